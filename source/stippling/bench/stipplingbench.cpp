@@ -0,0 +1,373 @@
+/**
+ * @file stipplingbench.cpp
+ * @brief Micro and macro benchmarks of the stippling pipeline kernels
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ * Built only with -DSTIPPLING_BUILD_BENCHMARKS=ON (needs Google Benchmark).
+ * The image kernels run on "use examples/test battery/battery.jpg" scaled to 25%, 50%, 100%
+ * and 200% (the STIPPLING_BENCH_IMAGE environment variable overrides the image). None of the
+ * benchmarks need a GL context: the solid rendering of the CSG tree is replaced by a synthetic
+ * one (a green ellipse over the red background) and the export benchmark measures the CPU side
+ * of saveStippledImageToDisk (flip and PNG encoding) over an image of the stippled size.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "dotgenerationworker.h"
+#include "entitytreecontroller.h"
+#include "configuration.h"
+#include "quadtree.h"
+#include "random.h"
+#include "stippledot.h"
+#include "spriteatlas.h"
+
+#ifndef STIPPLING_BENCH_IMAGE
+#define STIPPLING_BENCH_IMAGE "battery.jpg"
+#endif
+
+#ifndef STIPPLING_BENCH_SPRITES
+#define STIPPLING_BENCH_SPRITES "precdots10alpha.xml"
+#endif
+
+static const glm::vec2 spriteSize(10, 10); /**< Same sprites as GLWidgetStippling::initializeSprites. */
+static const glm::vec2 spritesMatrixSize(29, 29);
+
+/**
+ * @brief Returns the sprite atlas the dots are generated with (loaded once, empty if not found).
+ */
+static const SpriteAtlas & benchmarkSprites()
+{
+    static SpriteAtlas sprites;
+    if(sprites.isEmpty())
+    {
+        const char * path = getenv("STIPPLING_BENCH_SPRITES");
+        sprites.load(path != 0 ? path : STIPPLING_BENCH_SPRITES);
+    }
+    return sprites;
+}
+
+/**
+ * @brief Exposes the protected kernels of DotGenerationWorker.
+ */
+class BenchmarkWorker : public DotGenerationWorker
+{
+public:
+    BenchmarkWorker(cv::Mat toStipple, cv::Mat solid3DModel, Configuration * globalConfig, EntityTreeController * entities)
+        : DotGenerationWorker(toStipple, STUCKI, benchmarkSprites(), solid3DModel, globalConfig, entities)
+    {
+        setDebugOutput(false);
+    }
+
+    using DotGenerationWorker::floydSteinbergDithering;
+    using DotGenerationWorker::stuckiDithering;
+    using DotGenerationWorker::sobelEdgeDetection;
+    using DotGenerationWorker::sobelEdgeMasks;
+    using DotGenerationWorker::thresholding;
+};
+
+/**
+ * @brief Returns the benchmark image scaled to percentage % of its size (cached).
+ */
+static cv::Mat benchmarkImage(int percentage)
+{
+    static cv::Mat original;
+    if(original.empty())
+    {
+        const char * path = getenv("STIPPLING_BENCH_IMAGE");
+        original = cv::imread(path != 0 ? path : STIPPLING_BENCH_IMAGE, CV_LOAD_IMAGE_COLOR);
+    }
+    if(original.empty())
+    {
+        return cv::Mat();
+    }
+
+    cv::Mat scaled;
+    cv::resize(original, scaled, cv::Size(), percentage / 100.0, percentage / 100.0, cv::INTER_AREA);
+    return scaled;
+}
+
+/**
+ * @brief Solid rendering stand in: red background (not modelled) and a green ellipse (modelled).
+ */
+static cv::Mat syntheticSolidRendering(int rows, int cols)
+{
+    cv::Mat solid(rows, cols, CV_8UC3, cv::Scalar(0, 0, 255));
+    cv::ellipse(solid, cv::Point(cols/2, rows/2), cv::Size(cols/3, rows/3), 0, 0, 360, cv::Scalar(0, 255, 0), -1);
+    return solid;
+}
+
+static StippleDot * randomDot(Random & random, float width, float height)
+{
+    glm::vec2 position(width * random.uniform(), height * random.uniform());
+    return new StippleDot(position, spriteSize, random.next(int(spritesMatrixSize.x * spritesMatrixSize.y)));
+}
+
+static void addItemsProcessed(benchmark::State & state, qint64 itemsPerIteration)
+{
+    state.SetItemsProcessed(int64_t(state.iterations()) * itemsPerIteration);
+}
+
+
+
+static void BM_FloydSteinbergDithering(benchmark::State & state)
+{
+    cv::Mat image = benchmarkImage(int(state.range(0)));
+    if(image.empty()) { state.SkipWithError("Benchmark image not found"); return; }
+
+    Configuration config;
+    EntityTreeController entities;
+    BenchmarkWorker worker(image, cv::Mat(), &config, &entities);
+
+    while(state.KeepRunning())
+    {
+        cv::Mat dithered = worker.floydSteinbergDithering(image);
+        benchmark::DoNotOptimize(dithered.data);
+    }
+    addItemsProcessed(state, qint64(image.rows) * image.cols);
+}
+BENCHMARK(BM_FloydSteinbergDithering)->Arg(25)->Arg(50)->Arg(100)->Arg(200)->Unit(benchmark::kMillisecond);
+
+static void BM_StuckiDithering(benchmark::State & state)
+{
+    cv::Mat image = benchmarkImage(int(state.range(0)));
+    if(image.empty()) { state.SkipWithError("Benchmark image not found"); return; }
+
+    Configuration config;
+    EntityTreeController entities;
+    BenchmarkWorker worker(image, cv::Mat(), &config, &entities);
+
+    while(state.KeepRunning())
+    {
+        cv::Mat dithered = worker.stuckiDithering(image);
+        benchmark::DoNotOptimize(dithered.data);
+    }
+    addItemsProcessed(state, qint64(image.rows) * image.cols);
+}
+BENCHMARK(BM_StuckiDithering)->Arg(25)->Arg(50)->Arg(100)->Arg(200)->Unit(benchmark::kMillisecond);
+
+static void BM_Thresholding(benchmark::State & state)
+{
+    cv::Mat image = benchmarkImage(int(state.range(0)));
+    if(image.empty()) { state.SkipWithError("Benchmark image not found"); return; }
+
+    Configuration config;
+    EntityTreeController entities;
+    BenchmarkWorker worker(image, cv::Mat(), &config, &entities);
+
+    while(state.KeepRunning())
+    {
+        cv::Mat thresholded = worker.thresholding(image);
+        benchmark::DoNotOptimize(thresholded.data);
+    }
+    addItemsProcessed(state, qint64(image.rows) * image.cols);
+}
+BENCHMARK(BM_Thresholding)->Arg(25)->Arg(50)->Arg(100)->Arg(200)->Unit(benchmark::kMillisecond);
+
+static void BM_SobelEdgeDetection(benchmark::State & state)
+{
+    cv::Mat image = benchmarkImage(int(state.range(0)));
+    if(image.empty()) { state.SkipWithError("Benchmark image not found"); return; }
+
+    cv::Mat solid = syntheticSolidRendering(image.rows, image.cols);
+
+    Configuration config;
+    EntityTreeController entities;
+    BenchmarkWorker worker(image, solid, &config, &entities);
+
+    while(state.KeepRunning())
+    {
+        cv::Mat edges = worker.sobelEdgeDetection(solid);
+        benchmark::DoNotOptimize(edges.data);
+    }
+    addItemsProcessed(state, qint64(solid.rows) * solid.cols);
+}
+BENCHMARK(BM_SobelEdgeDetection)->Arg(25)->Arg(50)->Arg(100)->Arg(200)->Unit(benchmark::kMillisecond);
+
+static void BM_SobelEdgeMasks(benchmark::State & state)
+{
+    cv::Mat image = benchmarkImage(int(state.range(0)));
+    if(image.empty()) { state.SkipWithError("Benchmark image not found"); return; }
+
+    // Global solid rendering plus three specific nodes, as process() would detect them.
+    QVector<cv::Mat> solids(4, syntheticSolidRendering(image.rows, image.cols));
+
+    while(state.KeepRunning())
+    {
+        QVector<cv::Mat> masks = BenchmarkWorker::sobelEdgeMasks(solids);
+        benchmark::DoNotOptimize(masks[0].data);
+    }
+    addItemsProcessed(state, qint64(image.rows) * image.cols * solids.size());
+}
+BENCHMARK(BM_SobelEdgeMasks)->Arg(25)->Arg(50)->Arg(100)->Arg(200)->Unit(benchmark::kMillisecond);
+
+static void BM_QuadTreeAdd(benchmark::State & state)
+{
+    int numberOfDots = int(state.range(0));
+    float width = 6400.0f;
+    float height = 6400.0f;
+
+    while(state.KeepRunning())
+    {
+        state.PauseTiming();
+        Random random(Random::seedOf(0));
+        std::vector<StippleDot *> dots(numberOfDots);
+        for(int i=0; i<numberOfDots; ++i)
+        {
+            dots[i] = randomDot(random, width, height);
+        }
+        QuadTree * tree = new QuadTree(glm::vec4(0, 0, width, height), 5);
+        state.ResumeTiming();
+
+        for(int i=0; i<numberOfDots; ++i)
+        {
+            tree->add(dots[i]);
+        }
+
+        state.PauseTiming();
+        delete tree;
+        state.ResumeTiming();
+    }
+    addItemsProcessed(state, numberOfDots);
+}
+BENCHMARK(BM_QuadTreeAdd)->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+static void BM_QuadTreeGetDotsInPaddedArea(benchmark::State & state)
+{
+    int numberOfDots = 1000000;
+    float width = 6400.0f;
+    float height = 6400.0f;
+    // Viewport sized query (as paintScene does), moved around the tree.
+    float querySize = float(state.range(0));
+
+    Random random(Random::seedOf(0));
+    QuadTree tree(glm::vec4(0, 0, width, height), 5);
+    for(int i=0; i<numberOfDots; ++i)
+    {
+        tree.add(randomDot(random, width, height));
+    }
+
+    qint64 dotsVisited = 0;
+    int query = 0;
+    while(state.KeepRunning())
+    {
+        float x = (query * 997) % int(width - querySize);
+        float y = (query * 463) % int(height - querySize);
+        ++query;
+
+        QVector<QVector<StippleDot *> *> found = tree.getDotsInPaddedArea(glm::vec4(x, y, x + querySize, y + querySize),
+                                                                          int(spriteSize.x));
+        for(int i=0; i<found.size(); ++i)
+        {
+            dotsVisited += found[i]->size();
+        }
+    }
+    state.SetItemsProcessed(dotsVisited);
+}
+BENCHMARK(BM_QuadTreeGetDotsInPaddedArea)->Arg(500)->Arg(3000)->Unit(benchmark::kMicrosecond);
+
+static void BM_QuadTreeRebucket(benchmark::State & state)
+{
+    int numberOfDots = 1000000;
+    float width = 6400.0f;
+    float height = 6400.0f;
+    // Dispersion radius, in pixels.
+    int radius = int(state.range(0));
+
+    Random random(Random::seedOf(0));
+    QuadTree tree(glm::vec4(0, 0, width, height), 5);
+    std::vector<StippleDot *> dots(numberOfDots);
+    for(int i=0; i<numberOfDots; ++i)
+    {
+        dots[i] = randomDot(random, width, height);
+        tree.add(dots[i]);
+    }
+
+    qint64 moved = 0;
+    while(state.KeepRunning())
+    {
+        state.PauseTiming();
+        for(int i=0; i<numberOfDots; ++i)
+        {
+            dots[i]->setOffset(glm::vec2(random.next(2*radius + 1) - radius, random.next(2*radius + 1) - radius));
+        }
+        state.ResumeTiming();
+
+        moved += tree.rebucket();
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * numberOfDots);
+    state.counters["moved"] = double(moved) / state.iterations();
+}
+BENCHMARK(BM_QuadTreeRebucket)->Arg(2)->Arg(10)->Unit(benchmark::kMillisecond);
+
+static void BM_DotGeneration(benchmark::State & state)
+{
+    cv::Mat image = benchmarkImage(int(state.range(0)));
+    if(image.empty()) { state.SkipWithError("Benchmark image not found"); return; }
+
+    if(benchmarkSprites().isEmpty()) { state.SkipWithError("Sprite atlas not found"); return; }
+
+    cv::Mat solid = syntheticSolidRendering(image.rows, image.cols);
+
+    Configuration config;
+    EntityTreeController entities;
+    // The root is the only node, it carries the synthetic solid rendering (as generateSolidRenderings would).
+    QVector<EntityTreeNode*> * nodes = entities.traverseBreadthFirst();
+    nodes->at(0)->setSolidRendering(solid);
+    delete nodes;
+
+    BenchmarkWorker worker(image, solid, &config, &entities);
+
+    while(state.KeepRunning())
+    {
+        worker.process();
+
+        state.PauseTiming();
+        delete worker.getStipplingDots();
+        state.ResumeTiming();
+    }
+    addItemsProcessed(state, qint64(image.rows) * image.cols);
+}
+BENCHMARK(BM_DotGeneration)->Arg(25)->Arg(50)->Arg(100)->Unit(benchmark::kMillisecond);
+
+static void BM_ExportEncode(benchmark::State & state)
+{
+    cv::Mat image = benchmarkImage(int(state.range(0)));
+    if(image.empty()) { state.SkipWithError("Benchmark image not found"); return; }
+
+    // Stippled size for the default packing factor, mostly white as the rendered stippling is.
+    Configuration config;
+    int rows = image.rows * int(spriteSize.y) / config.packingFactor();
+    int cols = image.cols * int(spriteSize.x) / config.packingFactor();
+    cv::Mat stippled(rows, cols, CV_8UC3, cv::Scalar(255, 255, 255));
+    cv::Mat gray;
+    cv::cvtColor(image, gray, CV_BGR2GRAY);
+    cv::Mat dots;
+    cv::resize(gray, dots, cv::Size(cols, rows), 0, 0, cv::INTER_NEAREST);
+    stippled.setTo(cv::Scalar(0, 0, 0), dots < 64);
+
+    while(state.KeepRunning())
+    {
+        cv::Mat flipped;
+        cv::flip(stippled, flipped, 0);
+
+        std::vector<uchar> encoded;
+        cv::imencode(".png", flipped, encoded);
+        benchmark::DoNotOptimize(encoded.data());
+    }
+    addItemsProcessed(state, qint64(rows) * cols);
+}
+BENCHMARK(BM_ExportEncode)->Arg(25)->Arg(50)->Arg(100)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
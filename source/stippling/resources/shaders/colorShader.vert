@@ -13,6 +13,10 @@ uniform mat4 mvp;
 
 uniform vec3 pickingColor;
 
+// Single color for the whole mesh, used instead of vertexColor when useUniformColor != 0
+uniform vec3 uniformColor;
+uniform int useUniformColor;
+
 uniform float xLeft;
 uniform float xRight;
 
@@ -29,5 +33,12 @@ void main()
 
     // The color of each vertex will be interpolated
     // to produce the color of each fragment
-    fragmentColor = vertexColor;
+    if(useUniformColor != 0)
+    {
+        fragmentColor = uniformColor;
+    }
+    else
+    {
+        fragmentColor = vertexColor;
+    }
 }
@@ -0,0 +1,39 @@
+#version 330 core
+
+// Stipple dots without dispersion, used when stippleDotShader.vert can not be linked.
+
+// Input vertex data, different for all executions of this shader.
+layout(location = 0) in vec3 vertexPosition;
+layout(location = 1) in vec3 vertexNormal;
+layout(location = 2) in vec3 vertexColor;
+layout(location = 3) in vec2 vertexUV;
+
+// Input dot data, different for every instance of the quad.
+layout(location = 4) in vec2 dotPosition;     // Bottom left corner of the quad
+layout(location = 5) in vec4 uvRect;          // Cell of the sprite in the atlas: left, top, width and height (UV of the quad go from 0 to 1)
+
+// Output data ; will be interpolated for each fragment.
+out vec2 UV;
+
+// Values that stay constant for the whole mesh.
+uniform mat4 mvp;
+
+uniform vec3 pickingColor;
+
+uniform float xLeft;
+uniform float xRight;
+
+uniform float yBottom;
+uniform float yTop;
+
+uniform float zNear;
+uniform float zFar;
+
+void main(){
+
+        // Output position of the vertex, in clip space : MVP * position
+        gl_Position =  mvp * vec4(vertexPosition + vec3(dotPosition, 0.0), 1);
+
+        // UV of the vertex, inside the cell of the sprite.
+        UV = uvRect.xy + vertexUV * uvRect.zw;
+}
@@ -0,0 +1,52 @@
+#version 330 core
+
+// Input vertex data, different for all executions of this shader.
+layout(location = 0) in vec3 vertexPosition;
+layout(location = 1) in vec3 vertexNormal;
+layout(location = 2) in vec3 vertexColor;
+layout(location = 3) in vec2 vertexUV;
+
+// Input dot data, different for every instance of the quad.
+layout(location = 4) in vec2 dotPosition;     // Bottom left corner of the quad
+layout(location = 5) in vec4 uvRect;          // Cell of the sprite in the atlas: left, top, width and height (UV of the quad go from 0 to 1)
+layout(location = 6) in uvec2 dotRandom;      // Random number of the dot (low and high halves)
+layout(location = 7) in int useDispersion;    // 0 if the dot must stay where it was generated
+
+// Output data ; will be interpolated for each fragment.
+out vec2 UV;
+
+// Values that stay constant for the whole mesh.
+uniform mat4 mvp;
+
+uniform vec3 pickingColor;
+
+uniform float xLeft;
+uniform float xRight;
+
+uniform float yBottom;
+uniform float yTop;
+
+uniform float zNear;
+uniform float zFar;
+
+// Stipple dot dispersion.
+uniform uint dispersion;        // Maximum offset, in pixels
+uniform sampler1D directions;   // Unit vector of every integer angle in degrees (360 RG texels)
+
+void main(){
+
+        // Same offset the CPU dispersion would apply to the dot.
+        vec2 offset = vec2(0.0, 0.0);
+        if(useDispersion != 0)
+        {
+                uint alpha = dotRandom.x % 360u;
+                float offsetLength = float(dotRandom.y % (dispersion + 1u));
+                offset = vec2(ivec2(offsetLength * texelFetch(directions, int(alpha), 0).xy));
+        }
+
+        // Output position of the vertex, in clip space : MVP * position
+        gl_Position =  mvp * vec4(vertexPosition + vec3(dotPosition + offset, 0.0), 1);
+
+        // UV of the vertex, inside the cell of the sprite.
+        UV = uvRect.xy + vertexUV * uvRect.zw;
+}
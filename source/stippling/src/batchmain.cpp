@@ -0,0 +1,518 @@
+/**
+ * @file batchmain.cpp
+ * @brief Batch (non interactive) application entry point
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+
+#include <QtGui>
+#include <QApplication>
+#include <QStringList>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+
+#include "batchstippler.h"
+#include "batchscheduler.h"
+#include "regressionharness.h"
+
+#ifdef Q_WS_X11
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+
+
+static void printUsage()
+{
+    out << "Usage:" << endl;
+    out << "  stippling-batch <image> <csgtree.xml> <fov> <configuration.xml> <output.png> [options]" << endl;
+    out << "  stippling-batch --jobs <jobs.txt> [--memory-budget <MB>] [--max-concurrent <N>]" << endl;
+    out << "  stippling-batch --regression <suite.txt> <goldens directory> [--results <directory>] [--min-ssim <value>] [--update]" << endl;
+    out << "  stippling-batch --render-dots <dots file> <configuration.xml> <output.png>" << endl;
+    out << "  stippling-batch --write-configuration <configuration.xml>" << endl;
+    out << endl;
+    out << "Options:" << endl;
+    out << "  --dithering <floyd-steinberg|stucki>  Dithering method (default: stucki)." << endl;
+    out << "  --pitch <degrees>                     Camera pitch (default: 0)." << endl;
+    out << "  --height <units>                      Camera height (default: 0)." << endl;
+    out << "  --distance <units>                    Camera distance modifier (default: 0)." << endl;
+    out << "  --profile <report.json>               Write the time and memory spent on each stage." << endl;
+    out << "  --save-dots <dots file>               Write the dots, to be rendered again with --render-dots." << endl;
+    out << "  --cache <directory>                   Reuse the solid renderings, dithered and edge images of" << endl;
+    out << "                                        former runs kept in this directory." << endl;
+    out << endl;
+    out << "Each line of a jobs file holds the arguments of one run (image, CSG tree, fov," << endl;
+    out << "configuration, output and options) separated by blanks. Lines starting with # are ignored." << endl;
+    out << "The memory budget defaults to 2048 MB, the concurrency to the number of cores." << endl;
+    out << "Arguments holding blanks can be written between double quotes." << endl;
+    out << "Outputs ending in .svg are written as SVG documents, which can be rasterized at any resolution." << endl;
+    out << endl;
+    out << "Each line of a regression suite holds a case name followed by the arguments of its run" << endl;
+    out << "without the output file. Relative paths are relative to the suite file. The dithered image," << endl;
+    out << "the dots and the final render are compared against the goldens (--update rewrites them)." << endl;
+    out << "The results default to ./regression-results, the minimum SSIM of a final render to 0.99." << endl;
+    out << endl;
+    out << "Without a display (DISPLAY not set) the GL contexts are created on a private Xvfb server," << endl;
+    out << "started for the run and stopped at the end, so Xvfb must be installed on such machines." << endl;
+}
+
+/**
+ * @brief Splits a line of a jobs or suite file in arguments, separated by blanks.
+ * Double quotes group an argument holding blanks.
+ */
+static QStringList splitArguments(const QString & line)
+{
+    QStringList args;
+    QString current;
+    bool quoted = false;
+    bool pending = false;
+
+    for(int i=0; i<line.size(); ++i)
+    {
+        QChar c = line[i];
+        if(c == '"')
+        {
+            quoted = !quoted;
+            pending = true;
+        }
+        else if(c.isSpace() && !quoted)
+        {
+            if(pending)
+            {
+                args << current;
+                current.clear();
+                pending = false;
+            }
+        }
+        else
+        {
+            current += c;
+            pending = true;
+        }
+    }
+    if(pending)
+    {
+        args << current;
+    }
+
+    return args;
+}
+
+/**
+ * @brief Fills a job from its arguments: image, CSG tree, fov, configuration, output and options.
+ * @return False (after printing why) if the arguments are not valid.
+ */
+static bool parseJob(const QStringList & args, BatchJob & job)
+{
+    if(args.size() < 5)
+    {
+        out << "Error: a job needs an image, a CSG tree, a fov, a configuration and an output file." << endl;
+        return false;
+    }
+
+    job.imageFile = args[0];
+    job.csgTreeFile = args[1];
+    job.configurationFile = args[3];
+    job.outputFile = args[4];
+
+    bool ok;
+    job.fov = args[2].toFloat(&ok);
+    if(!ok || job.fov <= 0.0f || job.fov >= 180.0f)
+    {
+        out << "Error: invalid field of view " << args[2] << "." << endl;
+        return false;
+    }
+
+    for(int i=5; i<args.size(); i+=2)
+    {
+        if(i+1 >= args.size())
+        {
+            out << "Error: missing value for " << args[i] << "." << endl;
+            return false;
+        }
+
+        QString option = args[i];
+        QString value = args[i+1];
+        ok = true;
+
+        if(option == "--dithering")
+        {
+            if(value == "floyd-steinberg")
+            {
+                job.ditheringMethod = DotGenerationWorker::FLOYD_STEINBERG;
+            }
+            else if(value == "stucki")
+            {
+                job.ditheringMethod = DotGenerationWorker::STUCKI;
+            }
+            else
+            {
+                ok = false;
+            }
+        }
+        else if(option == "--pitch")
+        {
+            job.cameraPitch = value.toFloat(&ok);
+        }
+        else if(option == "--height")
+        {
+            job.cameraHeight = value.toInt(&ok);
+        }
+        else if(option == "--distance")
+        {
+            job.cameraDistance = value.toFloat(&ok);
+        }
+        else if(option == "--profile")
+        {
+            job.profileFile = value;
+        }
+        else if(option == "--save-dots")
+        {
+            job.dotSetFile = value;
+        }
+        else if(option == "--cache")
+        {
+            job.cacheDirectory = value;
+        }
+        else
+        {
+            out << "Error: unknown option " << option << "." << endl;
+            return false;
+        }
+
+        if(!ok)
+        {
+            out << "Error: invalid value " << value << " for " << option << "." << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Runs every job listed in a jobs file through a BatchScheduler.
+ */
+static int runJobs(const QStringList & args)
+{
+    QString jobsFile = args[2];
+    qint64 memoryBudget = 2048;
+    int maxConcurrentJobs = 0;
+
+    for(int i=3; i<args.size(); i+=2)
+    {
+        bool ok = false;
+        if(i+1 >= args.size())
+        {
+            // Missing value.
+        }
+        else if(args[i] == "--memory-budget")
+        {
+            memoryBudget = args[i+1].toLongLong(&ok);
+        }
+        else if(args[i] == "--max-concurrent")
+        {
+            maxConcurrentJobs = args[i+1].toInt(&ok);
+        }
+        if(!ok)
+        {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    QFile file(jobsFile);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        out << "Error: the jobs file " << jobsFile << " could not be opened." << endl;
+        return EXIT_FAILURE;
+    }
+
+    BatchStippler stippler;
+    BatchScheduler scheduler(&stippler, memoryBudget * 1024 * 1024, maxConcurrentJobs);
+
+    QTextStream in(&file);
+    int lineNumber = 0;
+    while(!in.atEnd())
+    {
+        QString line = in.readLine().trimmed();
+        ++lineNumber;
+        if(line.isEmpty() || line.startsWith("#"))
+        {
+            continue;
+        }
+
+        BatchJob job;
+        if(!parseJob(splitArguments(line), job))
+        {
+            out << "Error in " << jobsFile << ", line " << lineNumber << "." << endl;
+            return EXIT_FAILURE;
+        }
+        scheduler.addJob(job);
+    }
+    file.close();
+
+    int failed = scheduler.run();
+    scheduler.printReport();
+
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Runs a regression suite through a RegressionHarness.
+ */
+static int runRegression(const QStringList & args)
+{
+    if(args.size() < 4)
+    {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    QString suiteFile = args[2];
+    QString goldensDirectory = args[3];
+    QString resultsDirectory = "regression-results";
+    double minimumSSIM = 0.99;
+    bool updateGoldens = false;
+
+    for(int i=4; i<args.size(); ++i)
+    {
+        bool ok = true;
+        if(args[i] == "--update")
+        {
+            updateGoldens = true;
+        }
+        else if(i+1 >= args.size())
+        {
+            ok = false;
+        }
+        else if(args[i] == "--results")
+        {
+            resultsDirectory = args[++i];
+        }
+        else if(args[i] == "--min-ssim")
+        {
+            minimumSSIM = args[++i].toDouble(&ok);
+        }
+        else
+        {
+            ok = false;
+        }
+        if(!ok)
+        {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    QFile file(suiteFile);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        out << "Error: the suite file " << suiteFile << " could not be opened." << endl;
+        return EXIT_FAILURE;
+    }
+    QDir suiteDirectory = QFileInfo(suiteFile).absoluteDir();
+
+    BatchStippler stippler;
+    RegressionHarness harness(&stippler, goldensDirectory, resultsDirectory, minimumSSIM);
+
+    QTextStream in(&file);
+    int lineNumber = 0;
+    while(!in.atEnd())
+    {
+        QString line = in.readLine().trimmed();
+        ++lineNumber;
+        if(line.isEmpty() || line.startsWith("#"))
+        {
+            continue;
+        }
+
+        QStringList caseArgs = splitArguments(line);
+        RegressionCase regressionCase;
+        if(caseArgs.size() >= 5)
+        {
+            regressionCase.name = caseArgs.takeFirst();
+            // The output is chosen by the harness.
+            caseArgs.insert(4, QString());
+        }
+        if(!parseJob(caseArgs, regressionCase.job))
+        {
+            out << "Error in " << suiteFile << ", line " << lineNumber << "." << endl;
+            return EXIT_FAILURE;
+        }
+
+        BatchJob & job = regressionCase.job;
+        job.imageFile = suiteDirectory.absoluteFilePath(job.imageFile);
+        job.csgTreeFile = suiteDirectory.absoluteFilePath(job.csgTreeFile);
+        job.configurationFile = suiteDirectory.absoluteFilePath(job.configurationFile);
+
+        harness.addCase(regressionCase);
+    }
+    file.close();
+
+    int failed = harness.run(updateGoldens);
+
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+#ifdef Q_WS_X11
+/**
+ * @brief Private X server, for the GL contexts of the widgets when there is no display.
+ * The QGLWidget contexts of Qt 4 can only be created through the window system, so the
+ * batch tool starts its own Xvfb server and stops it when the run ends.
+ */
+class VirtualDisplay
+{
+private:
+    pid_t _pid;
+
+public:
+    VirtualDisplay() : _pid(-1)
+    {
+    }
+
+    ~VirtualDisplay()
+    {
+        if(_pid > 0)
+        {
+            kill(_pid, SIGTERM);
+            waitpid(_pid, 0, 0);
+        }
+    }
+
+    /**
+     * @brief Starts Xvfb on a free display and points DISPLAY to it.
+     * The server picks the display number itself (-displayfd) and writes it once it accepts
+     * connections, so there is no race with other servers nor with the connection of Qt.
+     * @return False (after printing why) if the server could not be started.
+     */
+    bool start()
+    {
+        int fds[2];
+        if(pipe(fds) != 0)
+        {
+            out << "Error: could not create a pipe for the Xvfb server." << endl;
+            return false;
+        }
+
+        _pid = fork();
+        if(_pid < 0)
+        {
+            close(fds[0]);
+            close(fds[1]);
+            out << "Error: could not start the Xvfb server." << endl;
+            return false;
+        }
+
+        if(_pid == 0)
+        {
+            close(fds[0]);
+            QByteArray fd = QByteArray::number(fds[1]);
+            execlp("Xvfb", "Xvfb", "-displayfd", fd.constData(), "-screen", "0", "1024x768x24",
+                   "-nolisten", "tcp", (char *) 0);
+            _exit(127);
+        }
+
+        close(fds[1]);
+
+        // Read until the end of the line; the end of the pipe means the server died (or was not found).
+        QByteArray display;
+        char c;
+        ssize_t n;
+        while((n = read(fds[0], &c, 1)) != 0)
+        {
+            if(n < 0)
+            {
+                if(errno == EINTR)
+                {
+                    continue;
+                }
+                break;
+            }
+            if(c == '\n')
+            {
+                break;
+            }
+            display.append(c);
+        }
+        close(fds[0]);
+
+        bool ok = false;
+        display.trimmed().toInt(&ok);
+        if(!ok)
+        {
+            waitpid(_pid, 0, 0);
+            _pid = -1;
+            out << "Error: there is no display (DISPLAY is not set) and a Xvfb server could not be started." << endl;
+            out << "Install Xvfb, or set DISPLAY to a running X server." << endl;
+            return false;
+        }
+
+        setenv("DISPLAY", (":" + display.trimmed()).constData(), 1);
+        return true;
+    }
+};
+#endif
+
+int main(int argc, char *argv[])
+{
+    if(argc == 3 && QString(argv[1]) == "--write-configuration")
+    {
+        // Writes the default configuration, to be used as a template. No GL, so no display needed.
+        QCoreApplication app(argc, argv);
+        return BatchStippler::saveConfiguration(QString::fromLocal8Bit(argv[2]), Configuration()) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+#ifdef Q_WS_X11
+    // Declared before the application, so the server outlives the X connection of Qt.
+    VirtualDisplay virtualDisplay;
+    if(qgetenv("DISPLAY").isEmpty() && !virtualDisplay.start())
+    {
+        return EXIT_FAILURE;
+    }
+#endif
+
+    QApplication app(argc, argv);
+    QStringList args = app.arguments();
+
+    if(args.size() == 5 && args[1] == "--render-dots")
+    {
+        BatchStippler stippler;
+        return stippler.renderDotSet(args[2], args[3], args[4]) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if(args.size() >= 3 && args[1] == "--jobs")
+    {
+        return runJobs(args);
+    }
+
+    if(args.size() >= 2 && args[1] == "--regression")
+    {
+        return runRegression(args);
+    }
+
+    BatchJob job;
+    if(!parseJob(args.mid(1), job))
+    {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    BatchStippler stippler;
+
+    return stippler.run(job) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
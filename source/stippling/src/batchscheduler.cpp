@@ -0,0 +1,152 @@
+/**
+ * @file batchscheduler.cpp
+ * @brief BatchScheduler class source file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#include "batchscheduler.h"
+
+BatchScheduler::DotGenerationTask::DotGenerationTask(BatchJobState * state, QAtomicInt * finished, QSemaphore * finishedJobs)
+{
+    _state = state;
+    _finished = finished;
+    _finishedJobs = finishedJobs;
+}
+
+void BatchScheduler::DotGenerationTask::run()
+{
+    BatchStippler::generateDots(_state);
+
+    _finished->fetchAndStoreOrdered(1);
+    _finishedJobs->release();
+}
+
+BatchScheduler::BatchScheduler(BatchStippler * stippler, qint64 memoryBudget, int maxConcurrentJobs)
+{
+    _stippler = stippler;
+    _memoryBudget = memoryBudget;
+    _maxConcurrentJobs = maxConcurrentJobs > 0 ? maxConcurrentJobs : QThreadPool::globalInstance()->maxThreadCount();
+}
+
+void BatchScheduler::addJob(const BatchJob & job)
+{
+    _jobs.append(job);
+}
+
+int BatchScheduler::run()
+{
+    int numberOfJobs = _jobs.size();
+
+    _timings = QVector<BatchJobTimings>(numberOfJobs);
+    _succeeded = QVector<bool>(numberOfJobs, false);
+
+    // Admitted jobs, with their submission index and the flag their task raises once done.
+    QList<BatchJobState *> running;
+    QList<int> runningIndex;
+    QList<QAtomicInt *> runningFinished;
+    qint64 memoryInUse = 0;
+
+    QSemaphore finishedJobs;
+
+    QElapsedTimer clock;
+    clock.start();
+
+    int next = 0;
+    while(next < numberOfJobs || !running.isEmpty())
+    {
+        // Admit as many pending jobs as the budget allows.
+        while(next < numberOfJobs && running.size() < _maxConcurrentJobs)
+        {
+            qint64 estimate = BatchStippler::estimateMemory(_jobs[next]);
+            if(!running.isEmpty() && memoryInUse + estimate > _memoryBudget)
+            {
+                break;
+            }
+
+            BatchJobState * state = new BatchJobState(_jobs[next]);
+            state->estimatedMemory = estimate;
+            state->timings.queued = clock.elapsed();
+
+            out << "Job " << next << ": " << state->job.imageFile << " admitted ("
+                << estimate / (1024*1024) << " MB estimated, "
+                << (memoryInUse + estimate) / (1024*1024) << " MB in use)." << endl;
+
+            if(!_stippler->load(state))
+            {
+                _timings[next] = state->timings;
+                delete state;
+                ++next;
+                continue;
+            }
+
+            // GL stage, serialized with the other GL stages (this thread).
+            _stippler->renderSolids(state);
+            state->worker->setDebugOutput(false);
+
+            QAtomicInt * finished = new QAtomicInt(0);
+            QThreadPool::globalInstance()->start(new DotGenerationTask(state, finished, &finishedJobs));
+
+            running.append(state);
+            runningIndex.append(next);
+            runningFinished.append(finished);
+            memoryInUse += estimate;
+            ++next;
+        }
+
+        if(running.isEmpty())
+        {
+            continue;
+        }
+
+        // Wait for any dot generation to end, and write its image while the others go on.
+        finishedJobs.acquire();
+
+        for(int i=0; i<running.size(); ++i)
+        {
+            if(runningFinished[i]->testAndSetOrdered(1, 2))
+            {
+                BatchJobState * state = running[i];
+
+                _stippler->saveFinalImage(state);
+
+                _timings[runningIndex[i]] = state->timings;
+                _succeeded[runningIndex[i]] = state->succeeded;
+                memoryInUse -= state->estimatedMemory;
+
+                delete state;
+                delete runningFinished[i];
+                running.removeAt(i);
+                runningIndex.removeAt(i);
+                runningFinished.removeAt(i);
+                break;
+            }
+        }
+    }
+
+    _jobs.clear();
+
+    return _succeeded.count(false);
+}
+
+const QVector<BatchJobTimings> & BatchScheduler::timings() const
+{
+    return _timings;
+}
+
+void BatchScheduler::printReport() const
+{
+    out << "job\tstatus\tqueued\tload\tsolids\tdots\tfinal (ms)" << endl;
+    for(int i=0; i<_timings.size(); ++i)
+    {
+        const BatchJobTimings & t = _timings[i];
+        out << i << "\t" << (_succeeded[i] ? "ok" : "failed") << "\t"
+            << t.queued << "\t" << t.load << "\t" << t.solidRenderings << "\t"
+            << t.dotGeneration << "\t" << t.finalImage << endl;
+    }
+}
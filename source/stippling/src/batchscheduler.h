@@ -0,0 +1,87 @@
+/**
+ * @file batchscheduler.h
+ * @brief BatchScheduler class header file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#ifndef BATCHSCHEDULER_H
+#define BATCHSCHEDULER_H
+
+#include "batchstippler.h"
+
+#include <QList>
+#include <QVector>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+
+/**
+ * @brief BatchScheduler class.
+ * Stipples several images concurrently. The GL stages (solid renderings and final image) share
+ * the widgets of a single BatchStippler and run one at a time in the GUI thread, while the dot
+ * generation of the admitted jobs runs in a thread pool. A job is only admitted if its estimated
+ * memory fits in what the running jobs left of the budget (a job is always admitted when nothing
+ * else is running, so oversized jobs still make progress).
+ */
+class BatchScheduler
+{
+private:
+    /**
+     * @brief Runs the dot generation stage of a job in the thread pool.
+     */
+    class DotGenerationTask : public QRunnable
+    {
+    private:
+        BatchJobState * _state;
+        QAtomicInt * _finished;
+        QSemaphore * _finishedJobs;
+
+    public:
+        DotGenerationTask(BatchJobState * state, QAtomicInt * finished, QSemaphore * finishedJobs);
+        void run();
+    };
+
+    BatchStippler * _stippler; /**< Owner of the GL widgets shared by every job. */
+
+    QList<BatchJob> _jobs; /**< Pending jobs, in submission order. */
+
+    qint64 _memoryBudget; /**< Bytes the admitted jobs may use at once. */
+    int _maxConcurrentJobs; /**< Maximum number of admitted jobs. */
+
+    QVector<BatchJobTimings> _timings; /**< Timings of the last run, in submission order. */
+    QVector<bool> _succeeded; /**< Outcome of the last run, in submission order. */
+
+public:
+    /**
+     * @brief Constructor.
+     * @param stippler Stippler whose widgets will be used. Not owned.
+     * @param memoryBudget Bytes the admitted jobs may use at once.
+     * @param maxConcurrentJobs Maximum number of admitted jobs (the thread pool size by default).
+     */
+    BatchScheduler(BatchStippler * stippler, qint64 memoryBudget, int maxConcurrentJobs = 0);
+
+    void addJob(const BatchJob & job);
+
+    /**
+     * @brief Runs every job added so far. Must be called from the GUI thread.
+     * @return Number of jobs that failed.
+     */
+    int run();
+
+    const QVector<BatchJobTimings> & timings() const;
+
+    /**
+     * @brief Prints the outcome and the stage timings of every job of the last run.
+     */
+    void printReport() const;
+};
+
+#endif // BATCHSCHEDULER_H
@@ -0,0 +1,405 @@
+/**
+ * @file batchstippler.cpp
+ * @brief BatchStippler class source file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#include "batchstippler.h"
+
+#include <QApplication>
+#include <QTextStream>
+#include <QImageReader>
+
+BatchJob::BatchJob()
+{
+    fov = 0.0f;
+    ditheringMethod = DotGenerationWorker::STUCKI;
+    cameraPitch = 0.0f;
+    cameraHeight = 0;
+    cameraDistance = 0.0f;
+}
+
+BatchJobTimings::BatchJobTimings()
+{
+    queued = 0;
+    load = 0;
+    solidRenderings = 0;
+    dotGeneration = 0;
+    finalImage = 0;
+}
+
+BatchJobState::BatchJobState(const BatchJob & batchJob)
+{
+    job = batchJob;
+    worker = 0;
+    cache = job.cacheDirectory.isEmpty() ? 0 : new IntermediateCache(job.cacheDirectory);
+    estimatedMemory = 0;
+    succeeded = false;
+}
+
+BatchJobState::~BatchJobState()
+{
+    if(worker != 0)
+    {
+        delete worker;
+        worker = 0;
+    }
+
+    if(cache != 0)
+    {
+        delete cache;
+        cache = 0;
+    }
+}
+
+BatchStippler::BatchStippler()
+{
+    _engine = 0;
+    _stippling = 0;
+    _initialized = false;
+}
+
+BatchStippler::~BatchStippler()
+{
+    if(_stippling != 0)
+    {
+        delete _stippling;
+        _stippling = 0;
+    }
+
+    if(_engine != 0)
+    {
+        delete _engine;
+        _engine = 0;
+    }
+}
+
+void BatchStippler::initialize()
+{
+    if(_initialized)
+    {
+        return;
+    }
+
+    _engine = new GLWidget3DEngine();
+    _engine->setConfiguration(&_configuration);
+    _engine->setEntityTreeController(&_entities);
+
+    _stippling = new GLWidgetStippling();
+    _stippling->setConfiguration(&_configuration);
+    _stippling->setEntityTreeController(&_entities);
+
+    // The widgets are never mapped, but showing them is what triggers
+    // initializeGL (shaders, sprites) on their contexts.
+    _engine->setAttribute(Qt::WA_DontShowOnScreen);
+    _engine->resize(800, 600);
+    _engine->show();
+
+    _stippling->setAttribute(Qt::WA_DontShowOnScreen);
+    _stippling->resize(800, 600);
+    _stippling->show();
+
+    QApplication::processEvents();
+
+    _initialized = true;
+}
+
+void BatchStippler::bindJob(BatchJobState * state)
+{
+    Configuration * configuration = (state != 0) ? &state->configuration : &_configuration;
+    EntityTreeController * entities = (state != 0) ? &state->entities : &_entities;
+
+    _engine->setConfiguration(configuration);
+    _engine->setEntityTreeController(entities);
+    _engine->setIntermediateCache((state != 0) ? state->cache : 0);
+    _stippling->setConfiguration(configuration);
+    _stippling->setEntityTreeController(entities);
+    _stippling->setProfiler((state != 0) ? &state->profiler : 0);
+}
+
+bool BatchStippler::readTextFile(QString fileName, QString & contents)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        return false;
+    }
+    contents = QString(file.readAll());
+    file.close();
+
+    return true;
+}
+
+bool BatchStippler::saveStippledImage(QString fileName)
+{
+    if(fileName.endsWith(".svg", Qt::CaseInsensitive))
+    {
+        return _stippling->saveStippledImageAsSVG(fileName);
+    }
+
+    return _stippling->saveStippledImageToDisk(fileName, false);
+}
+
+bool BatchStippler::loadConfiguration(QString fileName, Configuration & configuration)
+{
+    QString xml;
+    if(!readTextFile(fileName, xml))
+    {
+        out << "Error: the configuration file " << fileName << " could not be opened." << endl;
+        return false;
+    }
+
+    QDomDocument document;
+    if(!document.setContent(xml))
+    {
+        out << "Error: the configuration file " << fileName << " is not a valid XML file." << endl;
+        return false;
+    }
+
+    if(!configuration.fromXML(document.documentElement()))
+    {
+        out << "Error: the configuration file " << fileName << " has values out of range." << endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool BatchStippler::saveConfiguration(QString fileName, const Configuration & configuration)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        out << "Error: the configuration file " << fileName << " could not be written." << endl;
+        return false;
+    }
+
+    QDomDocument doc;
+    QDomProcessingInstruction instr = doc.createProcessingInstruction("xml", "version='1.0' encoding='UTF-8'");
+    doc.appendChild(instr);
+    doc.appendChild(configuration.toXML(&doc));
+
+    QTextStream fo(&file);
+    fo << doc.toString();
+
+    return true;
+}
+
+qint64 BatchStippler::estimateMemory(const BatchJob & job)
+{
+    // Only the header is read.
+    QSize size = QImageReader(job.imageFile).size();
+    if(!size.isValid())
+    {
+        return 0;
+    }
+
+    QString xml;
+    int numberOfNodes = 0;
+    if(readTextFile(job.csgTreeFile, xml))
+    {
+        numberOfNodes = xml.count("<node>");
+    }
+
+    qint64 pixels = qint64(size.width()) * qint64(size.height());
+
+    // Image, global solid rendering and one solid rendering per node (BGR).
+    qint64 bytes = pixels * 3 * (2 + numberOfNodes);
+    // Grayscale, dithered and edge detected images (one channel), plus one edge image per node.
+    bytes += pixels * (3 + numberOfNodes);
+    // At most one dot per pixel.
+    bytes += pixels * qint64(sizeof(StippleDot) + sizeof(StippleDot *));
+
+    return bytes;
+}
+
+bool BatchStippler::load(BatchJobState * state)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const BatchJob & job = state->job;
+
+    if(!loadConfiguration(job.configurationFile, state->configuration))
+    {
+        return false;
+    }
+
+    state->image = cv::imread(job.imageFile.toStdString(), CV_LOAD_IMAGE_COLOR);
+    if(!state->image.data)
+    {
+        out << "Error: could not open or find the image " << job.imageFile << "." << endl;
+        return false;
+    }
+
+    if(!readTextFile(job.csgTreeFile, state->csgTree))
+    {
+        out << "Error: the CSG tree file " << job.csgTreeFile << " could not be opened." << endl;
+        return false;
+    }
+
+    state->timings.load = timer.elapsed();
+
+    return true;
+}
+
+void BatchStippler::renderSolids(BatchJobState * state)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    initialize();
+    bindJob(state);
+
+    const BatchJob & job = state->job;
+
+    // Same sequence as loading an image and importing a CSG tree from the GUI.
+    _engine->setImage(state->image, job.fov);
+    _engine->setCameraHeight(job.cameraHeight);
+    _engine->setCameraPitch(job.cameraPitch);
+    _engine->setCameraDistance(job.cameraDistance);
+    _engine->reApplyConfiguration();
+    _engine->importEntitiesFromXML(state->csgTree);
+    state->csgTree.clear();
+
+    // A scene rendered before is read from the cache, without tessellating it again.
+    if(!_engine->loadCachedSolidRenderings(state->solidRendering))
+    {
+        _engine->applyLevelOfDetail(FINE_LOD);
+        _engine->generateSolidRenderings();
+        state->solidRendering = _engine->renderSceneToImageAsSolidAllIlluminated();
+    }
+    QByteArray sceneKey = (state->cache != 0) ? _engine->sceneKey() : QByteArray();
+
+    // The worker only reads the job's own tree and configuration, so it can be processed anywhere.
+    state->worker = new DotGenerationWorker(state->image, job.ditheringMethod,
+                                            _stippling->spriteAtlas(),
+                                            state->solidRendering,
+                                            &state->configuration,
+                                            &state->entities);
+    state->worker->setProfiler(&state->profiler);
+    state->worker->setIntermediateCache(state->cache, sceneKey);
+
+    bindJob(0);
+
+    state->timings.solidRenderings = timer.elapsed();
+}
+
+void BatchStippler::generateDots(BatchJobState * state)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    state->worker->process();
+
+    state->timings.dotGeneration = timer.elapsed();
+}
+
+void BatchStippler::saveFinalImage(BatchJobState * state)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    bindJob(state);
+
+    _stippling->setStipplingDots(state->worker->getStipplingDots(), false);
+
+    if(state->configuration.stippleDotDispersion() != 0)
+    {
+        _stippling->applyStippleDotDispersion();
+    }
+
+    // The job only succeeds if all its outputs are written.
+    bool saved = saveStippledImage(state->job.outputFile);
+
+    if(!state->job.dotSetFile.isEmpty())
+    {
+        DotSetInfo info;
+        info.imageSize = glm::ivec2(state->image.cols, state->image.rows);
+        info.area = state->worker->stippledImageArea();
+        info.spriteSize = _stippling->getSpriteSize();
+        info.matrixSize = glm::ivec2(_stippling->spriteAtlas().matrixSize());
+        info.rngSeed = state->configuration.rngSeed();
+        info.dispersion = _stippling->cpuStippleDotDispersion();
+        info.configurationHash = DotSetFile::configurationHash(state->configuration);
+
+        saved = DotSetFile::save(state->job.dotSetFile, state->worker->getStipplingDots(), info) && saved;
+    }
+
+    if(!state->job.profileFile.isEmpty() && !state->profiler.saveJSON(state->job.profileFile))
+    {
+        out << "Error: the profile " << state->job.profileFile << " could not be written." << endl;
+        saved = false;
+    }
+
+    // Release everything but the timings: the dots, the renderings and the tree (its GL buffers
+    // belong to the engine context).
+    _stippling->setStipplingDots(0, false);
+    _engine->makeCurrent();
+    state->entities.clear();
+    state->image.release();
+    state->solidRendering.release();
+
+    bindJob(0);
+
+    state->timings.finalImage = timer.elapsed();
+    state->succeeded = saved;
+}
+
+bool BatchStippler::run(const BatchJob & job)
+{
+    BatchJobState state(job);
+
+    if(!load(&state))
+    {
+        return false;
+    }
+
+    renderSolids(&state);
+    generateDots(&state);
+    saveFinalImage(&state);
+
+    return state.succeeded;
+}
+
+bool BatchStippler::renderDotSet(QString dotSetFile, QString configurationFile, QString outputFile)
+{
+    Configuration configuration;
+    if(!loadConfiguration(configurationFile, configuration))
+    {
+        return false;
+    }
+
+    DotSetInfo info;
+    QuadTree * dots = DotSetFile::load(dotSetFile, info, DotGenerationWorker::QUADTREE_DEPTH);
+    if(dots == 0)
+    {
+        return false;
+    }
+
+    initialize();
+
+    if(info.spriteSize != _stippling->getSpriteSize() || info.matrixSize != glm::ivec2(_stippling->spriteAtlas().matrixSize()))
+    {
+        out << "Error: the dot set " << dotSetFile << " was generated with a different sprite atlas." << endl;
+        delete dots;
+        return false;
+    }
+
+    _stippling->setConfiguration(&configuration);
+
+    // The offsets are already in the dots.
+    _stippling->setStipplingDots(dots, false);
+    bool saved = saveStippledImage(outputFile);
+    _stippling->setStipplingDots(0, false);
+
+    _stippling->setConfiguration(&_configuration);
+
+    return saved;
+}
@@ -0,0 +1,217 @@
+/**
+ * @file batchstippler.h
+ * @brief BatchStippler class header file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#ifndef BATCHSTIPPLER_H
+#define BATCHSTIPPLER_H
+
+// Dependancies on glew (QT conflicts with glew when including GLEW before QGLWidget)
+#include "glwidget3dengine.h"
+#include "glwidgetstippling.h"
+// End of conflicting glew dependancies
+
+#include <QString>
+#include <QFile>
+#include <QDomDocument>
+#include <QElapsedTimer>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include "util.h"
+#include "configuration.h"
+#include "entitytreecontroller.h"
+#include "dotgenerationworker.h"
+#include "stageprofiler.h"
+#include "intermediatecache.h"
+#include "dotsetfile.h"
+
+/**
+ * @brief Description of a single stippling run.
+ */
+struct BatchJob
+{
+    QString imageFile; /**< Photograph to be stippled. */
+    QString csgTreeFile; /**< CSG tree exported from the GUI (Export CSG Tree). */
+    float fov; /**< Vertical field of view of the camera, in degrees. */
+    QString configurationFile; /**< Configuration XML file. */
+    QString outputFile; /**< Stippled image to be written. */
+
+    DotGenerationWorker::DitheringMethod ditheringMethod; /**< Dithering applied before the dot generation. */
+
+    float cameraPitch; /**< Camera pitch, as set in the camera controls panel. */
+    int cameraHeight; /**< Camera height, as set in the camera controls panel. */
+    float cameraDistance; /**< Camera distance modifier, as set in the camera controls panel. */
+
+    QString profileFile; /**< If not empty, the stage profile (JSON) is written to this file. */
+
+    QString dotSetFile; /**< If not empty, the dots (with their offsets) are written to this dot set file. */
+
+    QString cacheDirectory; /**< If not empty, the solid renderings, dithered and edge images are cached in this directory. */
+
+    BatchJob();
+};
+
+/**
+ * @brief Wall time spent by a job on each stage, in milliseconds.
+ */
+struct BatchJobTimings
+{
+    qint64 queued; /**< Waiting for memory budget (or a free slot) to be admitted. */
+    qint64 load; /**< Reading the configuration, the image and the CSG tree. */
+    qint64 solidRenderings; /**< Building the CSG tree and rendering its solid images. */
+    qint64 dotGeneration; /**< Dithering, edge detection and dot creation (worker). */
+    qint64 finalImage; /**< Dispersion, tile rendering and export. */
+
+    BatchJobTimings();
+};
+
+/**
+ * @brief Everything a job holds while it goes through the pipeline.
+ * Each job has its own configuration and CSG tree, so the dot generation of a job can
+ * run while the GL stages of another one are using the widgets.
+ */
+struct BatchJobState
+{
+    BatchJob job;
+    Configuration configuration;
+    EntityTreeController entities;
+
+    cv::Mat image;
+    QString csgTree;
+    cv::Mat solidRendering;
+
+    DotGenerationWorker * worker;
+
+    IntermediateCache * cache; /**< Cache of the job's cacheDirectory, 0 if none. */
+
+    qint64 estimatedMemory; /**< Bytes reserved from the scheduler budget. */
+    BatchJobTimings timings;
+    StageProfiler profiler; /**< Stage measures of the dot generation and the final image. */
+    bool succeeded;
+
+    BatchJobState(const BatchJob & batchJob);
+    ~BatchJobState();
+};
+
+/**
+ * @brief BatchStippler class.
+ * Runs the stippling pipeline (solid renderings, dot generation and final image export)
+ * without user interaction. The GL widgets are created but never shown on screen, they are
+ * only needed for their contexts, shaders and sprites, which are shared by every job.
+ * The stages are public so a scheduler can interleave several jobs, run() chains them for one.
+ */
+class BatchStippler
+{
+private:
+    Configuration _configuration; /**< Configuration the widgets use while no job is bound. */
+    EntityTreeController _entities; /**< CSG tree the widgets use while no job is bound. */
+
+    GLWidget3DEngine * _engine; /**< Generates the solid renderings of the CSG tree. */
+    GLWidgetStippling * _stippling; /**< Generates and renders the stipple dots. */
+
+    bool _initialized; /**< True once the GL widgets have been initialized. */
+
+    /**
+     * @brief Creates the GL widgets (and their contexts) if not created yet.
+     */
+    void initialize();
+
+    /**
+     * @brief Makes the widgets use the configuration and CSG tree of a job (or the default ones if 0).
+     */
+    void bindJob(BatchJobState * state);
+
+    /**
+     * @brief Reads a whole text file.
+     * @param fileName File to be read.
+     * @param contents Contents of the file.
+     * @return False if the file could not be opened.
+     */
+    static bool readTextFile(QString fileName, QString & contents);
+
+    /**
+     * @brief Writes the stippled image of the bound dots: as a SVG document if the file name ends in .svg, as a raster image otherwise.
+     * @return False (after printing why) if the file could not be written.
+     */
+    bool saveStippledImage(QString fileName);
+
+public:
+    BatchStippler();
+
+    ~BatchStippler();
+
+    /**
+     * @brief Loads a configuration file (as written by saveConfiguration).
+     * @param fileName Configuration XML file.
+     * @param configuration Configuration to be updated.
+     * @return False if the file could not be read or parsed.
+     */
+    static bool loadConfiguration(QString fileName, Configuration & configuration);
+
+    /**
+     * @brief Writes a configuration to a XML file.
+     * @param fileName Configuration XML file.
+     * @param configuration Configuration to be written.
+     * @return False if the file could not be written.
+     */
+    static bool saveConfiguration(QString fileName, const Configuration & configuration);
+
+    /**
+     * @brief Estimates the peak memory a job needs, without loading it.
+     * Accounts for the image, one solid rendering per CSG tree node, the intermediate
+     * single channel images and one stipple dot per pixel (upper bound).
+     * @param job The job.
+     * @return Estimated bytes, or 0 if the image size could not be read.
+     */
+    static qint64 estimateMemory(const BatchJob & job);
+
+    /**
+     * @brief Stage 1. Loads the configuration, the image and the CSG tree of a job.
+     * @return False if any of them could not be loaded.
+     */
+    bool load(BatchJobState * state);
+
+    /**
+     * @brief Stage 2 (GUI thread). Builds the CSG tree and renders its solid images.
+     * Also creates the job's worker, ready to be processed in any thread.
+     */
+    void renderSolids(BatchJobState * state);
+
+    /**
+     * @brief Stage 3 (any thread). Generates the stipple dots.
+     */
+    static void generateDots(BatchJobState * state);
+
+    /**
+     * @brief Stage 4 (GUI thread). Applies the dispersion, renders the stippled image and writes it to disk.
+     * Releases the dots and the CSG tree of the job afterwards.
+     */
+    void saveFinalImage(BatchJobState * state);
+
+    /**
+     * @brief Stipples an image, running all the stages.
+     * @param job Description of the run.
+     * @return False if any of the inputs could not be loaded.
+     */
+    bool run(const BatchJob & job);
+
+    /**
+     * @brief Renders a dot set file, written by a former run, to a stippled image.
+     * @param dotSetFile Dot set file (see DotSetFile).
+     * @param configurationFile Configuration XML file (colors and rendering options).
+     * @param outputFile Stippled image to be written.
+     * @return False if the dot set or the configuration could not be loaded.
+     */
+    bool renderDotSet(QString dotSetFile, QString configurationFile, QString outputFile);
+};
+
+#endif // BATCHSTIPPLER_H
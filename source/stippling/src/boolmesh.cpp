@@ -188,10 +188,18 @@ unsigned int **BoolMesh::facesCache(unsigned int &nfaces,
 {
    Facet_iterator f;
    Halfedge_facet_circulator hf;
+   Vertex_iterator v;
+   CGAL::Unique_hash_map<Polyhedron::Vertex_const_handle, unsigned int> vindex;
    unsigned int **array;
    unsigned int nvertex;
    unsigned int i, j, indexv;
 
+   // same numbering as verticesCache()
+   i = 0;
+   for (v = this->_cache.vertices_begin(); 
+	v != this->_cache.vertices_end(); ++v)
+      vindex[v] = i++;
+
    nindex.clear();
    nfaces = this->_cache.size_of_facets();
    array = new unsigned int *[nfaces];
@@ -210,7 +218,7 @@ unsigned int **BoolMesh::facesCache(unsigned int &nfaces,
 
       j = 0;
       do {
-	 indexv = std::distance(this->_cache.vertices_begin(), hf->vertex());
+	 indexv = vindex[hf->vertex()];
 	 array[i][j] = indexv;
 	 j++;
       } while (++hf != f->facet_begin());
@@ -222,6 +230,167 @@ unsigned int **BoolMesh::facesCache(unsigned int &nfaces,
 }
 
 
+// -------------------------------------------------------------------------
+void BoolMesh::indexedCache(IndexedMesh &mesh)
+{
+   Polyhedron::Vertex_const_iterator v;
+   Polyhedron::Facet_const_iterator f;
+   Polyhedron::Edge_const_iterator e;
+   Polyhedron::Halfedge_around_facet_const_circulator hf;
+   CGAL::Unique_hash_map<Polyhedron::Vertex_const_handle, unsigned int> vindex;
+   std::vector<unsigned int> polygon;
+   Point p;
+   unsigned int i, nfacet, ntriangles;
+
+   mesh.clear();
+   mesh.vertices.reserve(3*this->_cache.size_of_vertices());
+   mesh.edges.reserve(2*(this->_cache.size_of_halfedges()/2));
+   // a closed surface has 2*(V-2) triangles once every facet is split
+   mesh.triangles.reserve(6*this->_cache.size_of_vertices());
+
+   // number the vertices while they are copied
+   i = 0;
+   for (v = this->_cache.vertices_begin(); 
+	v != this->_cache.vertices_end(); ++v)
+   {
+      p = v->point();
+      mesh.vertices.push_back((float) (CGAL::to_double(p.x())));
+      mesh.vertices.push_back((float) (CGAL::to_double(p.y())));
+      mesh.vertices.push_back((float) (CGAL::to_double(p.z())));
+      vindex[v] = i++;
+   }
+
+   // split every facet into triangles
+   nfacet = 0;
+   for (f = this->_cache.facets_begin(); f != this->_cache.facets_end(); ++f) 
+   {
+      polygon.clear();
+      hf = f->facet_begin();
+      do {
+	 polygon.push_back(vindex[hf->vertex()]);
+      } while (++hf != f->facet_begin());
+
+      ntriangles = mesh.triangles.size();
+      if (polygon.size() == 3)
+	 mesh.triangles.insert(mesh.triangles.end(), 
+			       polygon.begin(), polygon.end());
+      else
+	 triangulatePolygon(polygon, mesh.vertices, mesh.triangles);
+      ntriangles = (mesh.triangles.size() - ntriangles) / 3;
+
+      mesh.facets.insert(mesh.facets.end(), ntriangles, nfacet);
+      nfacet++;
+   }
+
+   // edges_begin() visits only one of the two halfedges of each edge
+   for (e = this->_cache.edges_begin(); e != this->_cache.edges_end(); ++e)
+   {
+      mesh.edges.push_back(vindex[e->opposite()->vertex()]);
+      mesh.edges.push_back(vindex[e->vertex()]);
+   }
+}
+
+
+// -------------------------------------------------------------------------
+void BoolMesh::triangulatePolygon(const std::vector<unsigned int> &polygon,
+				  const std::vector<float> &vertices,
+				  std::vector<unsigned int> &triangles)
+{
+   unsigned int n = polygon.size();
+   unsigned int i, j, k, a, b, c, prev, next, axis;
+   double nx = 0.0, ny = 0.0, nz = 0.0;
+   bool ear;
+
+   // Newell normal of the polygon, its dominant axis is dropped to work in 2D
+   for (i = 0; i < n; i ++)
+   {
+      const float *p = &vertices[3*polygon[i]];
+      const float *q = &vertices[3*polygon[(i+1)%n]];
+      nx += (p[1] - q[1]) * (p[2] + q[2]);
+      ny += (p[2] - q[2]) * (p[0] + q[0]);
+      nz += (p[0] - q[0]) * (p[1] + q[1]);
+   }
+   axis = 2;
+   if (fabs(nx) >= fabs(ny) && fabs(nx) >= fabs(nz))
+      axis = 0;
+   else if (fabs(ny) >= fabs(nz))
+      axis = 1;
+
+   // 2D coordinates keeping the orientation of the polygon counter-clockwise
+   std::vector<double> pu(n), pw(n);
+   for (i = 0; i < n; i ++)
+   {
+      const float *p = &vertices[3*polygon[i]];
+      pu[i] = p[(axis+1)%3];
+      pw[i] = p[(axis+2)%3];
+      if ((axis == 0 && nx < 0) || (axis == 1 && ny < 0) || 
+	  (axis == 2 && nz < 0))
+	 pw[i] = -pw[i];
+   }
+   std::vector<unsigned int> local(n);
+   for (i = 0; i < n; i ++)
+      local[i] = i;
+
+   // ear clipping, O(n^2) for every polygon but polygons are small
+   while (local.size() > 3)
+   {
+      n = local.size();
+      ear = false;
+      for (i = 0; i < n && !ear; i ++)
+      {
+	 prev = local[(i+n-1)%n];
+	 a = local[i];
+	 next = local[(i+1)%n];
+
+	 // reflex vertex, it cannot be an ear
+	 if ((pu[a]-pu[prev])*(pw[next]-pw[a]) - 
+	     (pw[a]-pw[prev])*(pu[next]-pu[a]) <= 0.0)
+	    continue;
+
+	 ear = true;
+	 for (j = 0; j < n && ear; j ++)
+	 {
+	    k = local[j];
+	    if (k == prev || k == a || k == next)
+	       continue;
+	    b = prev; c = a;
+	    double d1 = (pu[c]-pu[b])*(pw[k]-pw[b]) - (pw[c]-pw[b])*(pu[k]-pu[b]);
+	    b = a; c = next;
+	    double d2 = (pu[c]-pu[b])*(pw[k]-pw[b]) - (pw[c]-pw[b])*(pu[k]-pu[b]);
+	    b = next; c = prev;
+	    double d3 = (pu[c]-pu[b])*(pw[k]-pw[b]) - (pw[c]-pw[b])*(pu[k]-pu[b]);
+	    if (d1 >= 0.0 && d2 >= 0.0 && d3 >= 0.0)
+	       ear = false;
+	 }
+
+	 if (ear)
+	 {
+	    triangles.push_back(polygon[prev]);
+	    triangles.push_back(polygon[a]);
+	    triangles.push_back(polygon[next]);
+	    local.erase(local.begin() + i);
+	 }
+      }
+
+      // degenerated polygon (collinear vertices), fall back to a fan
+      if (!ear)
+      {
+	 for (i = 1; i+1 < n; i ++)
+	 {
+	    triangles.push_back(polygon[local[0]]);
+	    triangles.push_back(polygon[local[i]]);
+	    triangles.push_back(polygon[local[i+1]]);
+	 }
+	 return;
+      }
+   }
+
+   triangles.push_back(polygon[local[0]]);
+   triangles.push_back(polygon[local[1]]);
+   triangles.push_back(polygon[local[2]]);
+}
+
+
 // -------------------------------------------------------------------------
 void BoolMesh::translatef(float x, float y, float z)
 {
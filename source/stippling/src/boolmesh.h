@@ -9,6 +9,7 @@
 #include <CGAL/IO/Polyhedron_VRML_2_ostream.h>
 #include <CGAL/Nef_polyhedron_3.h>
 #include <CGAL/IO/Nef_polyhedron_iostream_3.h>
+#include <CGAL/Unique_hash_map.h>
 
 
 ////////////////////// Necessary for GLM interface support ////////////////
@@ -112,9 +113,33 @@ class SurfaceM : public CGAL::Modifier_base<HDS>
 
 typedef SurfaceM<HalfedgeDS> Surface;
 
+// Flat, contiguous representation of a cached polyhedron. Every facet is
+// triangulated, so the buffers can be handed directly to OpenGL.
+struct IndexedMesh
+{
+   std::vector<float> vertices;         // 3 values (x, y, z) per vertex
+   std::vector<unsigned int> triangles; // 3 vertex indices per triangle
+   std::vector<unsigned int> edges;     // 2 vertex indices per edge (each edge only once)
+   std::vector<unsigned int> facets;    // facet each triangle was generated from
+
+   void clear(void)
+   {
+      vertices.clear();
+      triangles.clear();
+      edges.clear();
+      facets.clear();
+   }
+};
+
 class BoolMesh {
   private:
    Polyhedron _cache;
+
+   // Triangulate a (planar) polygon by ear clipping and append the
+   // resulting triangles to the output
+   static void triangulatePolygon(const std::vector<unsigned int> &polygon,
+				  const std::vector<float> &vertices,
+				  std::vector<unsigned int> &triangles);
   public:
 
    /* **********  BOOLEAN OPERATIONS  ******** */
@@ -185,6 +210,10 @@ class BoolMesh {
    unsigned int **facesCache(unsigned int &nfaces,
 			     std::vector<unsigned int> &nvertices);
 
+   // Fill an indexed mesh with the cache in a single pass over it (linear
+   // time). Non triangular facets are split into triangles.
+   void indexedCache(IndexedMesh &mesh);
+
    // Translate the model (it doesn't affect the cached model)
    void translatef (float x, float y, float z);
 
@@ -12,6 +12,8 @@
 
 #include "configuration.h"
 
+#include <climits>
+
 Configuration::Configuration()
 {
     // Default configuration
@@ -26,12 +28,15 @@ Configuration::Configuration()
     _packingFactor = 3;
     _rngSeed = 0;
     _stippleDotDispersion = 0;
+    _gpuStippleDotDispersion = false;
 
     _unmodelledStipplingChance = 15;
     _modelledStipplingChance = 75;
 
     _edgeDetectionMethod = SOBEL;
 
+    _dotPlacement = DITHERED_GRID;
+
     _useTileRendering = false; // Single tile mode by default
     _tileWidth = 3000;
     _tileHeight = 3000;
@@ -86,6 +91,11 @@ unsigned int Configuration::stippleDotDispersion() const
     return _stippleDotDispersion;
 }
 
+bool Configuration::gpuStippleDotDispersion() const
+{
+    return _gpuStippleDotDispersion;
+}
+
 int Configuration::unmodelledStipplingChance() const
 {
     return _unmodelledStipplingChance;
@@ -101,6 +111,11 @@ EdgeDetectionMethod Configuration::edgeDetectionMethod() const
     return _edgeDetectionMethod;
 }
 
+DotPlacement Configuration::dotPlacement() const
+{
+    return _dotPlacement;
+}
+
 bool Configuration::useTileRendering() const
 {
     return _useTileRendering;
@@ -171,6 +186,11 @@ void Configuration::setStippleDotDispersion(unsigned int stippleDotDispersion)
     _stippleDotDispersion = stippleDotDispersion;
 }
 
+void Configuration::setGPUStippleDotDispersion(bool gpuStippleDotDispersion)
+{
+    _gpuStippleDotDispersion = gpuStippleDotDispersion;
+}
+
 void Configuration::setUnmodelledStipplingChance(int unmodelledStipplingChance)
 {
     _unmodelledStipplingChance = unmodelledStipplingChance;
@@ -186,6 +206,11 @@ void Configuration::setEdgeDetectionMethod(EdgeDetectionMethod edgeDetectionMeth
     _edgeDetectionMethod = edgeDetectionMethod;
 }
 
+void Configuration::setDotPlacement(DotPlacement dotPlacement)
+{
+    _dotPlacement = dotPlacement;
+}
+
 void Configuration::setUseTileRendering(bool useTileRendering)
 {
     _useTileRendering = useTileRendering;
@@ -202,3 +227,168 @@ void Configuration::setTileHeight(int tileHeight)
 }
 
 
+
+
+
+
+
+QDomElement Configuration::toXML(QDomDocument * doc) const
+{
+    QDomElement node = doc->createElement("configuration");
+
+    QList< QPair<QString, QString> > values;
+    values << qMakePair(QString("entityWires"), _entityWires.name());
+    values << qMakePair(QString("positionCP"), _positionCP.name());
+    values << qMakePair(QString("resizeCP"), _resizeCP.name());
+    values << qMakePair(QString("rotateCP"), _rotateCP.name());
+    values << qMakePair(QString("scaleCP"), _scaleCP.name());
+    values << qMakePair(QString("floorWires"), _floorWires.name());
+    values << qMakePair(QString("packingFactor"), QString::number(_packingFactor));
+    values << qMakePair(QString("rngSeed"), QString::number(_rngSeed));
+    values << qMakePair(QString("stippleDotDispersion"), QString::number(_stippleDotDispersion));
+    values << qMakePair(QString("gpuStippleDotDispersion"), QString::number(int(_gpuStippleDotDispersion)));
+    values << qMakePair(QString("unmodelledStipplingChance"), QString::number(_unmodelledStipplingChance));
+    values << qMakePair(QString("modelledStipplingChance"), QString::number(_modelledStipplingChance));
+    values << qMakePair(QString("edgeDetectionMethod"), QString::number(int(_edgeDetectionMethod)));
+    values << qMakePair(QString("dotPlacement"), QString::number(int(_dotPlacement)));
+    values << qMakePair(QString("useTileRendering"), QString::number(int(_useTileRendering)));
+    values << qMakePair(QString("tileWidth"), QString::number(_tileWidth));
+    values << qMakePair(QString("tileHeight"), QString::number(_tileHeight));
+
+    for(int i=0; i<values.size(); ++i)
+    {
+        QDomElement elem = doc->createElement(values[i].first);
+        node.appendChild(elem);
+        QDomText txt = doc->createTextNode(values[i].second);
+        elem.appendChild(txt);
+    }
+
+    return node;
+}
+
+/**
+ * @brief Reads an integer element of a configuration, if present (value is untouched otherwise).
+ * @return False (after printing why) if it is present but is not an integer in [minimum, maximum].
+ */
+static bool readInt(const QDomNode & node, const QString & name, int minimum, int maximum, int & value)
+{
+    QDomElement elem = node.firstChildElement(name);
+    if(elem.isNull())
+    {
+        return true;
+    }
+
+    bool ok;
+    int read = elem.text().trimmed().toInt(&ok);
+    if(!ok || read < minimum || read > maximum)
+    {
+        out << "Error: the configuration value " << name << " (\"" << elem.text() << "\") is not an integer from "
+            << minimum << " to " << maximum << "." << endl;
+        return false;
+    }
+
+    value = read;
+    return true;
+}
+
+/**
+ * @brief Reads a not negative integer element of a configuration, if present (value is untouched otherwise).
+ * @return False (after printing why) if it is present but is not such an integer.
+ */
+static bool readUInt(const QDomNode & node, const QString & name, unsigned int & value)
+{
+    QDomElement elem = node.firstChildElement(name);
+    if(elem.isNull())
+    {
+        return true;
+    }
+
+    bool ok;
+    unsigned int read = elem.text().trimmed().toUInt(&ok);
+    if(!ok)
+    {
+        out << "Error: the configuration value " << name << " (\"" << elem.text() << "\") is not a positive integer." << endl;
+        return false;
+    }
+
+    value = read;
+    return true;
+}
+
+/**
+ * @brief Reads a boolean (0 or 1) element of a configuration, if present (value is untouched otherwise).
+ * @return False (after printing why) if it is present but is neither 0 nor 1.
+ */
+static bool readBool(const QDomNode & node, const QString & name, bool & value)
+{
+    int read = value ? 1 : 0;
+    if(!readInt(node, name, 0, 1, read))
+    {
+        return false;
+    }
+
+    value = (read != 0);
+    return true;
+}
+
+/**
+ * @brief Reads a color element of a configuration, if present (value is untouched otherwise).
+ * @return False (after printing why) if it is present but is not a color name.
+ */
+static bool readColor(const QDomNode & node, const QString & name, QColor & value)
+{
+    QDomElement elem = node.firstChildElement(name);
+    if(elem.isNull())
+    {
+        return true;
+    }
+
+    QColor read(elem.text().trimmed());
+    if(!read.isValid())
+    {
+        out << "Error: the configuration value " << name << " (\"" << elem.text() << "\") is not a color." << endl;
+        return false;
+    }
+
+    value = read;
+    return true;
+}
+
+bool Configuration::fromXML(QDomNode node)
+{
+    // Read on a copy, so nothing is loaded unless every value is valid (and every wrong one is reported).
+    Configuration read(*this);
+    int edgeDetectionMethod = int(_edgeDetectionMethod);
+    int dotPlacement = int(_dotPlacement);
+
+    bool valid = true;
+    valid = readColor(node, "entityWires", read._entityWires) && valid;
+    valid = readColor(node, "positionCP", read._positionCP) && valid;
+    valid = readColor(node, "resizeCP", read._resizeCP) && valid;
+    valid = readColor(node, "rotateCP", read._rotateCP) && valid;
+    valid = readColor(node, "scaleCP", read._scaleCP) && valid;
+    valid = readColor(node, "floorWires", read._floorWires) && valid;
+
+    valid = readInt(node, "packingFactor", 1, INT_MAX, read._packingFactor) && valid;
+    valid = readUInt(node, "rngSeed", read._rngSeed) && valid;
+    valid = readUInt(node, "stippleDotDispersion", read._stippleDotDispersion) && valid;
+    valid = readBool(node, "gpuStippleDotDispersion", read._gpuStippleDotDispersion) && valid;
+    valid = readInt(node, "unmodelledStipplingChance", 0, 100, read._unmodelledStipplingChance) && valid;
+    valid = readInt(node, "modelledStipplingChance", 0, 100, read._modelledStipplingChance) && valid;
+    valid = readInt(node, "edgeDetectionMethod", SOBEL, SILHOUETTE, edgeDetectionMethod) && valid;
+    valid = readInt(node, "dotPlacement", DITHERED_GRID, POISSON_DISK, dotPlacement) && valid;
+    valid = readBool(node, "useTileRendering", read._useTileRendering) && valid;
+    valid = readInt(node, "tileWidth", 1, INT_MAX, read._tileWidth) && valid;
+    valid = readInt(node, "tileHeight", 1, INT_MAX, read._tileHeight) && valid;
+
+    if(!valid)
+    {
+        return false;
+    }
+
+    read._edgeDetectionMethod = EdgeDetectionMethod(edgeDetectionMethod);
+    read._dotPlacement = DotPlacement(dotPlacement);
+    *this = read;
+
+    return true;
+}
@@ -23,9 +23,25 @@
 #include "util.h"
 
 #include <QColor>
+#include <QDomDocument>
 
 
-enum EdgeDetectionMethod { SOBEL, CANNY };
+/**
+ * SILHOUETTE marks the pixels where the owner of the pixel (deepest CSG node covering it, or none)
+ * changes, instead of detecting edges on the solid renderings.
+ */
+enum EdgeDetectionMethod { SOBEL, CANNY, SILHOUETTE };
+
+/**
+ * DITHERED_GRID places a dot on every dark pixel of the dithered image, with a random sprite.
+ * TONE_AWARE chooses the sprite from the darkness around the pixel (darker areas get inkier sprites)
+ * and places the dot with the probability that gives that darkness, given the ink of the sprite.
+ * WEIGHTED_VORONOI spreads as many dots as that darkness needs by Lloyd relaxation (weighted
+ * centroidal Voronoi stippling), off the grid of the pixels.
+ * POISSON_DISK spreads them by Poisson disk sampling, keeping the dots further apart the lighter the
+ * area: not as even as the relaxation, but much cheaper.
+ */
+enum DotPlacement { DITHERED_GRID, TONE_AWARE, WEIGHTED_VORONOI, POISSON_DISK };
 
 /**
  * @brief Configuration class.
@@ -46,11 +62,14 @@ private:
     int _packingFactor; /**< Packing factor (min = 1, max = stippling dot size - 1). */
     unsigned int _rngSeed; /**< Random Number Generator seed. */
     unsigned int _stippleDotDispersion; /**< Stipple dot dispersion (maximum offset applied to the position). */
+    bool _gpuStippleDotDispersion; /**< If true the dispersion offsets are computed in the vertex shader when the dots are drawn. */
     int _unmodelledStipplingChance; /**< Percentage of the unmodelled image that will result of Stipple dots generation. */
     int _modelledStipplingChance; /**< Percentage of the modelled image that will result of Stipple dots generation. */
 
     EdgeDetectionMethod _edgeDetectionMethod;
 
+    DotPlacement _dotPlacement;
+
     bool _useTileRendering;
     int _tileWidth;
     int _tileHeight;
@@ -76,12 +95,15 @@ public:
 
     unsigned int rngSeed() const;
     unsigned int stippleDotDispersion() const;
+    bool gpuStippleDotDispersion() const;
 
     int unmodelledStipplingChance() const;
     int modelledStipplingChance() const;
 
     EdgeDetectionMethod edgeDetectionMethod() const;
 
+    DotPlacement dotPlacement() const;
+
     bool useTileRendering() const;
     int tileWidth() const;
     int tileHeight() const;
@@ -99,15 +121,34 @@ public:
 
     void setRngSeed(unsigned int rngSeed);
     void setStippleDotDispersion(unsigned int stippleDotDispersion);
+    void setGPUStippleDotDispersion(bool gpuStippleDotDispersion);
 
     void setUnmodelledStipplingChance(int unmodelledStipplingChance);
     void setModelledStipplingChance(int modelledStipplingChance);
 
     void setEdgeDetectionMethod(EdgeDetectionMethod edgeDetectionMethod);
 
+    void setDotPlacement(DotPlacement dotPlacement);
+
     void setUseTileRendering(bool useTileRendering);
     void setTileWidth(int tileWidth);
     void setTileHeight(int tileHeight);
+
+    /**
+     * @brief Serializes the configuration as a "configuration" XML element.
+     * @param doc Document the element is created in.
+     * @return The configuration element.
+     */
+    QDomElement toXML(QDomDocument * doc) const;
+
+    /**
+     * @brief Loads the values stored in a "configuration" XML element.
+     * Values missing from the element keep their current value, so partial files are accepted.
+     * @param node The configuration element.
+     * @return False (after printing why) if some value is not a number in its range (packing factor
+     * from 1, chances from 0 to 100, known methods...) or not a color. Nothing is loaded then.
+     */
+    bool fromXML(QDomNode node);
 };
 
 #endif // CONFIGURATION_H
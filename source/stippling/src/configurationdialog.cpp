@@ -31,14 +31,22 @@ ConfigurationDialog::ConfigurationDialog(QWidget *parent) :
 
     connect(ui->rngSeed, SIGNAL(valueChanged(int)), this, SLOT(setRngSeed()));
     connect(ui->stippleDotDispersion, SIGNAL(valueChanged(int)), this, SLOT(setStippleDotDispersion()));
+    connect(ui->gpuStippleDotDispersion, SIGNAL(toggled(bool)), this, SLOT(setGPUStippleDotDispersion()));
 
     connect(ui->unmodeledStipplingChance, SIGNAL(valueChanged(int)), this, SLOT(setUnmodelledStipplingChance()));
     connect(ui->modeledStipplingChance, SIGNAL(valueChanged(int)), this, SLOT(setModelledStipplingChance()));
 
     ui->edgeDetectionMethod->addItem("Sobel", "Sobel");
     ui->edgeDetectionMethod->addItem("Canny", "Canny");
+    ui->edgeDetectionMethod->addItem("Silhouette", "Silhouette");
     connect(ui->edgeDetectionMethod, SIGNAL(currentIndexChanged(int)), this, SLOT(setEdgeDetectionMethod()));
 
+    ui->dotPlacement->addItem("Dithered grid", "Dithered grid");
+    ui->dotPlacement->addItem("Tone aware", "Tone aware");
+    ui->dotPlacement->addItem("Weighted Voronoi", "Weighted Voronoi");
+    ui->dotPlacement->addItem("Poisson disk", "Poisson disk");
+    connect(ui->dotPlacement, SIGNAL(currentIndexChanged(int)), this, SLOT(setDotPlacement()));
+
     connect(ui->useTileRendering, SIGNAL(toggled(bool)), this, SLOT(setUseTileRendering()));
     connect(ui->tileWidth, SIGNAL(valueChanged(int)), this, SLOT(setTileWidth()));
     connect(ui->tileHeight, SIGNAL(valueChanged(int)), this, SLOT(setTileHeight()));
@@ -102,11 +110,14 @@ void ConfigurationDialog::loadConfiguration(Configuration * configuration)
     _configuration->setPackingFactor(_externalConfiguration->packingFactor());
     _configuration->setRngSeed(_externalConfiguration->rngSeed());
     _configuration->setStippleDotDispersion(_externalConfiguration->stippleDotDispersion());
+    _configuration->setGPUStippleDotDispersion(_externalConfiguration->gpuStippleDotDispersion());
     _configuration->setUnmodelledStipplingChance(_externalConfiguration->unmodelledStipplingChance());
     _configuration->setModelledStipplingChance(_externalConfiguration->modelledStipplingChance());
 
     _configuration->setEdgeDetectionMethod(_externalConfiguration->edgeDetectionMethod());
 
+    _configuration->setDotPlacement(_externalConfiguration->dotPlacement());
+
     _configuration->setUseTileRendering(_externalConfiguration->useTileRendering());
     _configuration->setTileWidth(_externalConfiguration->tileWidth());
     _configuration->setTileHeight(_externalConfiguration->tileHeight());
@@ -151,9 +162,29 @@ void ConfigurationDialog::loadConfiguration(Configuration * configuration)
     {
         index = "Canny";
     }
+    else if(_configuration->edgeDetectionMethod() ==  SILHOUETTE)
+    {
+        index = "Silhouette";
+    }
     ui->edgeDetectionMethod->setCurrentIndex(ui->edgeDetectionMethod->findText(index));
 
+    index = "Dithered grid";
+    if(_configuration->dotPlacement() == TONE_AWARE)
+    {
+        index = "Tone aware";
+    }
+    else if(_configuration->dotPlacement() == WEIGHTED_VORONOI)
+    {
+        index = "Weighted Voronoi";
+    }
+    else if(_configuration->dotPlacement() == POISSON_DISK)
+    {
+        index = "Poisson disk";
+    }
+    ui->dotPlacement->setCurrentIndex(ui->dotPlacement->findText(index));
+
     ui->useTileRendering->setChecked(_configuration->useTileRendering());
+    ui->gpuStippleDotDispersion->setChecked(_configuration->gpuStippleDotDispersion());
     ui->tileWidth->setValue(_configuration->tileWidth());
     ui->tileHeight->setValue(_configuration->tileHeight());
 }
@@ -245,6 +276,16 @@ void ConfigurationDialog::setStippleDotDispersion()
     unsigned int stippleDotDispersion = ui->stippleDotDispersion->text().toUInt();
 
     _configuration->setStippleDotDispersion(stippleDotDispersion);
+
+    if(_configuration->gpuStippleDotDispersion())
+    {
+        emit stippleDotDispersionPreviewed(stippleDotDispersion);
+    }
+}
+
+void ConfigurationDialog::setGPUStippleDotDispersion()
+{
+    _configuration->setGPUStippleDotDispersion(ui->gpuStippleDotDispersion->isChecked());
 }
 
 void ConfigurationDialog::setUnmodelledStipplingChance()
@@ -274,10 +315,35 @@ void ConfigurationDialog::setEdgeDetectionMethod()
     {
         method = CANNY;
     }
+    else if(value == "Silhouette")
+    {
+        method = SILHOUETTE;
+    }
 
     _configuration->setEdgeDetectionMethod(method);
 }
 
+void ConfigurationDialog::setDotPlacement()
+{
+    QString value = ui->dotPlacement->currentText();
+
+    DotPlacement placement = DITHERED_GRID;
+    if(value == "Tone aware")
+    {
+        placement = TONE_AWARE;
+    }
+    else if(value == "Weighted Voronoi")
+    {
+        placement = WEIGHTED_VORONOI;
+    }
+    else if(value == "Poisson disk")
+    {
+        placement = POISSON_DISK;
+    }
+
+    _configuration->setDotPlacement(placement);
+}
+
 void ConfigurationDialog::setUseTileRendering()
 {
     _configuration->setUseTileRendering(ui->useTileRendering->isChecked());
@@ -310,11 +376,14 @@ void ConfigurationDialog::applyChangesOnConfiguration()
     _externalConfiguration->setPackingFactor(_configuration->packingFactor());
     _externalConfiguration->setRngSeed(_configuration->rngSeed());
     _externalConfiguration->setStippleDotDispersion(_configuration->stippleDotDispersion());
+    _externalConfiguration->setGPUStippleDotDispersion(_configuration->gpuStippleDotDispersion());
     _externalConfiguration->setUnmodelledStipplingChance(_configuration->unmodelledStipplingChance());
     _externalConfiguration->setModelledStipplingChance(_configuration->modelledStipplingChance());
 
     _externalConfiguration->setEdgeDetectionMethod(_configuration->edgeDetectionMethod());
 
+    _externalConfiguration->setDotPlacement(_configuration->dotPlacement());
+
     _externalConfiguration->setUseTileRendering(_configuration->useTileRendering());
     _externalConfiguration->setTileWidth(_configuration->tileWidth());
     _externalConfiguration->setTileHeight(_configuration->tileHeight());
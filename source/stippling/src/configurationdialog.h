@@ -96,6 +96,11 @@ private slots:
      */
     void setStippleDotDispersion();
 
+    /**
+     * @brief Sets whether the dispersion is computed on the GPU from the QCheckBox that holds it.
+     */
+    void setGPUStippleDotDispersion();
+
     /**
      * @brief Validates and sets (if valid) the unmodelled stippling percentage from the QSpinBox that holds it.
      */
@@ -111,12 +116,25 @@ private slots:
      */
     void setEdgeDetectionMethod();
 
+    /**
+     * @brief Sets the chosen dot placement from the QComboBox that holds it.
+     */
+    void setDotPlacement();
+
     void setUseTileRendering();
     void setTileWidth();
     void setTileHeight();
 
     void applyChangesOnConfiguration();
 
+signals:
+    /**
+     * @brief Emitted when the dispersion changes while the GPU dispersion is enabled,
+     * so the stippled image can preview it before the dialog is accepted.
+     * @param stippleDotDispersion The dispersion shown by the dialog.
+     */
+    void stippleDotDispersionPreviewed(unsigned int stippleDotDispersion);
+
 public:
     /**
      * @brief Default constructor.
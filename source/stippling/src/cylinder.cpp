@@ -1,10 +1,14 @@
 #include "cylinder.h"
 
+const float Cylinder::_coarseTolerance = 1.0f;
+const float Cylinder::_fineTolerance = 0.25f;
+
 Cylinder::Cylinder(IDManager * idManager, const float size, const GLuint entityRenderShader,
              const GLuint controlPointsRenderShader, const GLuint selectionShader, glm::vec3 color) :
     Entity3D(idManager)
 {
     _type = CYLINDER;
+    _numberOfSidesPerCircle = 36;
 
     _color = color;
 
@@ -70,51 +74,7 @@ Cylinder::Cylinder(IDManager * idManager, const float size, const GLuint entityR
 
     recalculateGeometry();
 
-    GLfloat * vertexColor = new GLfloat[lines_NumberOfValues];
-    // Setting the color of each vertex
-    for(int i=0; i<lines_NumberOfValues; i+=3)
-    {
-        vertexColor[i] = color.r;
-        vertexColor[i+1] = color.g;
-        vertexColor[i+2] = color.b;
-    }
-
-    const GLfloat * normalBufferData = 0;
-    const GLfloat * uvBufferData = 0;
-
-    _wireframe.initialize(lines, vertexColor, normalBufferData, uvBufferData,
-                          lines_NumberOfValues, GL_LINES, 3, GL_DYNAMIC_DRAW,
-                          entityRenderShader, selectionShader);
-
-    deleteLines();
-    if(vertexColor != 0)
-    {
-        delete[] vertexColor;
-        vertexColor = 0;
-    }
-
-    vertexColor = new GLfloat[triangles_NumberOfValues];
-    // Setting the color of each vertex
-    for(int i=0; i<triangles_NumberOfValues; i+=3)
-    {
-        vertexColor[i] = color.r;
-        vertexColor[i+1] = color.g;
-        vertexColor[i+2] = color.b;
-    }
-
-    uvBufferData = 0;
-
-    _solid.initialize(triangles, vertexColor, normals, uvBufferData,
-                      triangles_NumberOfValues, GL_TRIANGLES, 3, GL_DYNAMIC_DRAW,
-                      entityRenderShader, selectionShader);
-
-    deleteTriangles();
-    deleteNormals();
-    if(vertexColor != 0)
-    {
-        delete[] vertexColor;
-        vertexColor = 0;
-    }
+    initializeGLEntities(entityRenderShader, selectionShader);
 }
 
 Cylinder::Cylinder(IDManager * idManager, QDomNode node, const GLuint entityRenderShader,
@@ -159,6 +119,7 @@ Cylinder::Cylinder(IDManager * idManager, QDomNode node, const GLuint entityRend
     QDomNode xmlResizeHeightCP = xmlResizeRadiusTopCP.nextSiblingElement("controlPoint");
 
     _type = type;
+    _numberOfSidesPerCircle = 36;
     _color = color;
     _name = name;
     _visible = visible;
@@ -201,51 +162,7 @@ Cylinder::Cylinder(IDManager * idManager, QDomNode node, const GLuint entityRend
 
     recalculateGeometry();
 
-    GLfloat * vertexColor = new GLfloat[lines_NumberOfValues];
-    // Setting the color of each vertex
-    for(int i=0; i<lines_NumberOfValues; i+=3)
-    {
-        vertexColor[i] = color.r;
-        vertexColor[i+1] = color.g;
-        vertexColor[i+2] = color.b;
-    }
-
-    const GLfloat * normalBufferData = 0;
-    const GLfloat * uvBufferData = 0;
-
-    _wireframe.initialize(lines, vertexColor, normalBufferData, uvBufferData,
-                          lines_NumberOfValues, GL_LINES, 3, GL_DYNAMIC_DRAW,
-                          entityRenderShader, selectionShader);
-
-    deleteLines();
-    if(vertexColor != 0)
-    {
-        delete[] vertexColor;
-        vertexColor = 0;
-    }
-
-    vertexColor = new GLfloat[triangles_NumberOfValues];
-    // Setting the color of each vertex
-    for(int i=0; i<triangles_NumberOfValues; i+=3)
-    {
-        vertexColor[i] = color.r;
-        vertexColor[i+1] = color.g;
-        vertexColor[i+2] = color.b;
-    }
-
-    uvBufferData = 0;
-
-    _solid.initialize(triangles, vertexColor, normals, uvBufferData,
-                      triangles_NumberOfValues, GL_TRIANGLES, 3, GL_DYNAMIC_DRAW,
-                      entityRenderShader, selectionShader);
-
-    deleteTriangles();
-    deleteNormals();
-    if(vertexColor != 0)
-    {
-        delete[] vertexColor;
-        vertexColor = 0;
-    }
+    initializeGLEntities(entityRenderShader, selectionShader);
 }
 
 Cylinder::~Cylinder()
@@ -323,165 +240,110 @@ void Cylinder::recalculateGeometry()
         //Util::printVector(circumferencePoint);
     }
 
-    Surface surface;
+    _primitiveVertices.clear();
+    _primitivePolygons.clear();
 
-    // Adding the vertices to the surface
-    //int vertexIndex = 0;
-    //out << "Prism's vertices:" << endl;
+    // Adding the vertices
     foreach(glm::vec3 cornerBottom, baseBottom)
     {
-        //out << "vertex #" << vertexIndex << " = " << endl;
-        //Util::printVector(cornerBottom);
-        //++vertexIndex;
-        surface.addVertex(cornerBottom);
+        _primitiveVertices.push_back(cornerBottom.x);
+        _primitiveVertices.push_back(cornerBottom.y);
+        _primitiveVertices.push_back(cornerBottom.z);
     }
     foreach(glm::vec3 cornerTop, baseTop)
     {
-        //out << "vertex #" << vertexIndex << " = " << endl;
-        //Util::printVector(cornerTop);
-        //++vertexIndex;
-        surface.addVertex(cornerTop);
+        _primitiveVertices.push_back(cornerTop.x);
+        _primitiveVertices.push_back(cornerTop.y);
+        _primitiveVertices.push_back(cornerTop.z);
     }
 
-    //out << "vertex #" << vertexIndex << " = " << endl;
-    //Util::printVector(_position.localPos());
-    //++vertexIndex;
-    surface.addVertex(_position.localPos());
-
-    //out << "vertex #" << vertexIndex << " = " << endl;
-    //Util::printVector(_resizeHeight.localPos());
-    //++vertexIndex;
-    surface.addVertex(_resizeHeight.localPos());
+    std::vector<unsigned int> polygon;
 
-    QVector<unsigned int> tempFaces;
-
-    // Adding the bottom face to the surface
+    // Adding the bottom face
+    polygon.clear();
     for(int i=0; i<baseBottom.size(); ++i)
     {
-       tempFaces.clear();
-
-       tempFaces.push_back(baseBottom.size() + baseTop.size());
-       tempFaces.push_back(Util::mod(-i,baseBottom.size()));
-       tempFaces.push_back(Util::mod(-1-i,baseBottom.size()));
+        polygon.push_back(Util::mod(-i,baseBottom.size()));
+    }
+    _primitivePolygons.push_back(polygon);
 
-       surface.addFace(tempFaces);
+    // Adding the top face
+    polygon.clear();
+    for(int i=0; i<baseTop.size(); ++i)
+    {
+        polygon.push_back(baseBottom.size() + i);
     }
+    _primitivePolygons.push_back(polygon);
 
-    // Adding the top face to the surface
+    // Adding the lateral faces
     for(int i=0; i<baseBottom.size(); ++i)
     {
-       tempFaces.clear();
+        polygon.clear();
 
-       tempFaces.push_back(baseBottom.size() + baseTop.size() + 1);
-       tempFaces.push_back(baseBottom.size() + Util::mod(i,baseTop.size()));
-       tempFaces.push_back(baseBottom.size() + Util::mod(1+i,baseTop.size()));
+        polygon.push_back(i);
+        polygon.push_back(Util::mod(i+1,baseBottom.size()));
+        polygon.push_back(baseBottom.size() + Util::mod(i+1,baseBottom.size()));
+        polygon.push_back(baseBottom.size() + i);
 
-       surface.addFace(tempFaces);
+        _primitivePolygons.push_back(polygon);
     }
 
-    // Adding the lateral faces to the surface
-    for(int i=0; i<baseBottom.size(); ++i)
+    // The CGAL mesh is only built when an operation needs it
+    generateGeometryFromPolygons();
+}
+
+int Cylinder::sidesForProjectedRadius(float radius, float tolerance)
+{
+    if(radius <= tolerance)
     {
-        tempFaces.clear();
-        tempFaces.push_back(i);
-        tempFaces.push_back(Util::mod(i+1,baseBottom.size()));
-        tempFaces.push_back(baseBottom.size() + Util::mod(i+1,baseBottom.size()));
-        surface.addFace(tempFaces);
-
-        tempFaces.clear();
-        tempFaces.push_back(i);
-        tempFaces.push_back(baseBottom.size() + Util::mod(i+1,baseBottom.size()));
-        tempFaces.push_back(baseBottom.size() + i);
-        surface.addFace(tempFaces);
+        return _minimumSidesPerCircle;
     }
 
-    //out << "Vertices and faces added to the surface..." << endl;
-    // create polyhedron from surface
-    _mesh.clearCache();
-    //out << "Cleared mesh cache..." << endl;
-    _mesh.addSurface(surface);
-    //out << "Surface added to the mesh..." << endl;
-    _mesh.flushCache();
-    //out << "Flushed mesch cache..." << endl;
+    // The polygon's maximum distance to the circle is r * (1 - cos(PI / sides))
+    float sides = PI / acos(1.0f - (tolerance / radius));
+
+    return std::max(_minimumSidesPerCircle, std::min(_maximumSidesPerCircle, int(ceil(sides))));
+}
+
+bool Cylinder::updateLevelOfDetail(const glm::mat4 * view, const glm::mat4 * projection,
+                                   int viewportHeight, LevelOfDetail levelOfDetail)
+{
+    float radiusBottom = fabs(_resizeRadiusBottom.localPos().x - _position.localPos().x);
+    float radiusTop = fabs(_resizeRadiusTop.localPos().x - _position.localPos().x);
+    float height = _resizeHeight.localPos().y - _position.localPos().y;
 
-    //_mesh.saveOFFMesh( QString("debug " + name() + ".off").toStdString() );
+    // World radius (the model matrix may scale the cylinder) and distance to the camera of the
+    // point of the axis nearest to it
+    float scale = std::max(glm::length(glm::vec3(_model[0])), glm::length(glm::vec3(_model[2])));
+    float radius = std::max(radiusBottom, radiusTop) * scale;
 
-    unsigned int nVertices;
-    float * vertices = _mesh.verticesCache(nVertices);
-    unsigned int nFaces;
-    std::vector<unsigned int> nVerticesPerFace;
-    unsigned int ** faces = _mesh.facesCache(nFaces, nVerticesPerFace);
+    glm::vec4 bottomCenter = (*view) * _model * glm::vec4(_position.localPos(), 1.0f);
+    glm::vec4 topCenter = (*view) * _model * glm::vec4(_position.localPos() + glm::vec3(0.0f, height, 0.0f), 1.0f);
+    float depth = std::min(-bottomCenter.z, -topCenter.z) - radius;
 
-    /*
-    out << endl;
-    out << "==============================" << endl;
-    out << "    Debugging CGAL mesh output" << endl;
-    out << "nVertices = " << nVertices << endl;
-    out << "vertices = " << endl << "{" << endl;
-    for(int i=0; i<3*nVertices; i=i+3)
+    int sides;
+    if(depth <= 0.0f)
     {
-        out << "( " << vertices[i] << ", " << vertices[i+1] << ", " << vertices[i+2] << " )";
-        if(i<(3*nVertices)-3)
-        {
-            out << "," << endl;
-        }
+        // The camera is inside (or very near) the cylinder
+        sides = _maximumSidesPerCircle;
     }
-    out << endl << "}" << endl;
-    out << "nFaces = " << nFaces << endl;
-    out << "nVerticesPerFace = {";
-    for(int i=0; i<nFaces; ++i)
+    else
     {
-        out << " " << nVerticesPerFace.at(i);
-        if(i<nFaces-1)
-        {
-            out << ",";
-        }
+        float projectedRadius = radius * (*projection)[1][1] * (viewportHeight / 2.0f) / depth;
+        float tolerance = (levelOfDetail == FINE_LOD) ? _fineTolerance : _coarseTolerance;
+        sides = sidesForProjectedRadius(projectedRadius, tolerance);
     }
-    out << " }" << endl;
-    out << "faces = " << endl << "{" << endl;
-    for(int i=0; i<nFaces; ++i)
-    {
-        for(int j=0; j<nVerticesPerFace.at(i); ++j)
-        {
-            out << " " << faces[i][j];
-            if(j<nVerticesPerFace.at(i)-1)
-            {
-                out << ",";
-            }
-        }
-        if(i<nFaces-1)
-        {
-            out << ";" << endl;
-        }
-    }
-    out << ";" << endl << " }" << endl;
-    out << "==============================" << endl;
-    out << endl;
-    */
 
-    generateLines(nVertices, vertices, nFaces, &nVerticesPerFace, faces);
-    generateTriangles(nVertices, vertices, nFaces, &nVerticesPerFace, faces);
-    generateNormals(nVertices, vertices, nFaces, &nVerticesPerFace, faces);
-
-    if(vertices != 0)
+    if(sides == _numberOfSidesPerCircle)
     {
-        delete[] vertices;
-        vertices = 0;
+        return false;
     }
-    for(int f=0; f<int(nFaces); ++f)
-    {
-        if(faces[f] != 0)
-        {
-            delete[] faces[f];
-            faces[f] = 0;
-        }
 
-    }
-    if(faces != 0)
-    {
-        delete[] faces;
-        faces = 0;
-    }
+    _numberOfSidesPerCircle = sides;
+    recalculateGeometry();
+    updateGLEntities();
+
+    return true;
 }
 
 void Cylinder::interactSpecifically(ControlPoint * cp)
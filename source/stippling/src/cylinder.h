@@ -10,7 +10,12 @@
 class Cylinder : public Entity3D
 {
 protected:
-    static const int _numberOfSidesPerCircle = 36; /**< _numberOfSidesPerCircle The number of sides per base of the cylinder. It defines how well the cylinder is approximated. */
+    static const int _minimumSidesPerCircle = 8; /**< Sides used however small the cylinder is projected. */
+    static const int _maximumSidesPerCircle = 256; /**< Sides used however big the cylinder is projected. */
+    static const float _coarseTolerance; /**< Maximum distance (in pixels) between the circle and its polygon while interacting. */
+    static const float _fineTolerance; /**< Maximum distance (in pixels) between the circle and its polygon on the final renderings. */
+
+    int _numberOfSidesPerCircle; /**< _numberOfSidesPerCircle The number of sides per base of the cylinder. It defines how well the cylinder is approximated. */
 
     ControlPoint _resizeRadiusBottom; /**< Control Point used to resize the radius of the cylinder's bottom face. */
     ControlPoint _resizeRadiusTop; /**< Control Point used to resize the radius of the cylinder's top face. */
@@ -57,6 +62,20 @@ public:
     ControlPoint * getControlPointResizeRadiusBottom();
     ControlPoint * getControlPointResizeRadiusTop();
     ControlPoint * getControlPointResizeHeight();
+
+    /**
+     * @brief Number of sides needed so a circle of the given radius doesn't deviate more than the tolerance from its polygon.
+     * @param radius Radius of the circle (in pixels).
+     * @param tolerance Maximum distance (in pixels) allowed between the circle and the polygon.
+     */
+    static int sidesForProjectedRadius(float radius, float tolerance);
+
+    /**
+     * @brief Chooses the number of sides per circle from the cylinder's projected radius.
+     * @see Entity3D#updateLevelOfDetail()
+     */
+    bool updateLevelOfDetail(const glm::mat4 * view, const glm::mat4 * projection,
+                             int viewportHeight, LevelOfDetail levelOfDetail);
 };
 
 #endif // CYLINDER_H
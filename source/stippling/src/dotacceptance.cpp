@@ -0,0 +1,73 @@
+/**
+ * @file dotacceptance.cpp
+ * @brief DotAcceptance class source file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#include "dotacceptance.h"
+
+// SSE2 is always there on x86-64, and on 32 bit x86 when the compiler targets it.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DOT_ACCEPTANCE_SSE2
+#include <emmintrin.h>
+#endif
+
+int DotAcceptance::words(int pixels)
+{
+    return (pixels + 31) / 32;
+}
+
+void DotAcceptance::acceptRow(const unsigned char * dark,
+                              const unsigned char * roll, const unsigned char * threshold,
+                              const unsigned char * offsetRoll, const unsigned char * offsetThreshold,
+                              int pixels, quint32 * accepted, quint32 * offsetAllowed)
+{
+    int i = 0;
+
+#ifdef DOT_ACCEPTANCE_SSE2
+    // A word at a time: two blocks of 16 pixels. There are no unsigned byte compares, but
+    // a >= b is max(a, b) == a.
+    for(; i + 32 <= pixels; i += 32)
+    {
+        quint32 acceptedWord = 0;
+        quint32 offsetWord = 0;
+        for(int half=0; half<2; ++half)
+        {
+            int first = i + 16*half;
+
+            __m128i rolls = _mm_loadu_si128((const __m128i *)(roll + first));
+            __m128i reached = _mm_cmpeq_epi8(_mm_max_epu8(rolls, _mm_loadu_si128((const __m128i *)(threshold + first))), rolls);
+            __m128i chosen = _mm_and_si128(reached, _mm_loadu_si128((const __m128i *)(dark + first)));
+
+            __m128i offsetRolls = _mm_loadu_si128((const __m128i *)(offsetRoll + first));
+            __m128i offset = _mm_cmpeq_epi8(_mm_max_epu8(offsetRolls, _mm_loadu_si128((const __m128i *)(offsetThreshold + first))), offsetRolls);
+
+            acceptedWord |= quint32(_mm_movemask_epi8(chosen)) << (16*half);
+            offsetWord |= quint32(_mm_movemask_epi8(offset)) << (16*half);
+        }
+        accepted[i / 32] = acceptedWord;
+        offsetAllowed[i / 32] = offsetWord;
+    }
+#endif
+
+    // Rest of the span (or all of it, without SSE2).
+    for(; i < pixels; i += 32)
+    {
+        int last = qMin(pixels, i + 32);
+        quint32 acceptedWord = 0;
+        quint32 offsetWord = 0;
+        for(int j=i; j<last; ++j)
+        {
+            acceptedWord |= quint32(dark[j] != 0 && roll[j] >= threshold[j]) << (j - i);
+            offsetWord |= quint32(offsetRoll[j] >= offsetThreshold[j]) << (j - i);
+        }
+        accepted[i / 32] = acceptedWord;
+        offsetAllowed[i / 32] = offsetWord;
+    }
+}
@@ -0,0 +1,54 @@
+/**
+ * @file dotacceptance.h
+ * @brief DotAcceptance class header file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#ifndef DOTACCEPTANCE_H
+#define DOTACCEPTANCE_H
+
+#include <QtGlobal>
+
+/**
+ * @brief DotAcceptance class
+ * Non instantiable class that decides which pixels of a row span get a dot, without branches.
+ * The chances of every pixel (modelled, unmodelled, specific, edge) are folded beforehand in a
+ * threshold its random roll has to reach, so the decision is the same couple of byte compares for
+ * every pixel, done 16 at a time with SSE2 where available (and one by one elsewhere).
+ * Results are bitmasks, bit (i % 32) of word (i / 32) being the pixel i of the span.
+ */
+class DotAcceptance
+{
+public:
+    static const unsigned char NEVER = 255; /**< Threshold no roll reaches, rolls are below it. */
+
+    /**
+     * @return Number of words of the bitmasks of a span.
+     */
+    static int words(int pixels);
+
+    /**
+     * @brief Accepts a dot on a pixel if it is dark and its roll reaches its threshold, and allows
+     * its offset if its offset roll reaches its offset threshold.
+     * @param dark 255 if the pixel may get a dot (dark on the dithered image, or chosen by the tone), 0 otherwise.
+     * @param roll Random roll of the pixel, below NEVER.
+     * @param threshold Smallest roll accepting the dot.
+     * @param offsetRoll Random roll of the offset of the pixel, below NEVER.
+     * @param offsetThreshold Smallest offset roll allowing the offset.
+     * @param pixels Pixels of the span.
+     * @param accepted Bitmask of the accepted dots, words(pixels) words.
+     * @param offsetAllowed Bitmask of the dots allowed to have an offset, words(pixels) words.
+     */
+    static void acceptRow(const unsigned char * dark,
+                          const unsigned char * roll, const unsigned char * threshold,
+                          const unsigned char * offsetRoll, const unsigned char * offsetThreshold,
+                          int pixels, quint32 * accepted, quint32 * offsetAllowed);
+};
+
+#endif // DOTACCEPTANCE_H
@@ -12,13 +12,23 @@
 
 #include "dotgenerationworker.h"
 
+#include "dotacceptance.h"
+#include "random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
 cv::Mat DotGenerationWorker::floydSteinbergDithering(cv::Mat toDither)
 {
     cv::Mat imageGrayscale;
     // First, transform the image to grayscale.
     cvtColor(toDither,imageGrayscale,CV_RGB2GRAY);
 
-    imwrite("imageGrayscale.png", imageGrayscale);
+    if(_debugOutput)
+    {
+        imwrite("imageGrayscale.png", imageGrayscale);
+    }
 
     int padding = 1;
     cv::Mat padded;
@@ -64,7 +74,10 @@ cv::Mat DotGenerationWorker::floydSteinbergDithering(cv::Mat toDither)
     cv::Rect myROI(1, 1, imageGrayscale.cols, imageGrayscale.rows);
     cv::Mat cropped = padded(myROI);
 
-    imwrite("imageDithered_Floyd-Steinberg.png", cropped);
+    if(_debugOutput)
+    {
+        imwrite("imageDithered_Floyd-Steinberg.png", cropped);
+    }
 
     return cropped;
 }
@@ -75,7 +88,10 @@ cv::Mat DotGenerationWorker::stuckiDithering(cv::Mat toDither)
     // First, transform the image to grayscale.
     cvtColor(toDither,imageGrayscale,CV_RGB2GRAY);
 
-    imwrite("imageGrayscale.png", imageGrayscale);
+    if(_debugOutput)
+    {
+        imwrite("imageGrayscale.png", imageGrayscale);
+    }
 
     int padding = 2;
     cv::Mat padded;
@@ -153,7 +169,10 @@ cv::Mat DotGenerationWorker::stuckiDithering(cv::Mat toDither)
     cv::Rect myROI(2, 2, imageGrayscale.cols, imageGrayscale.rows);
     cv::Mat cropped = padded(myROI);
 
-    imwrite("imageDithered_Stucki.png", cropped);
+    if(_debugOutput)
+    {
+        imwrite("imageDithered_Stucki.png", cropped);
+    }
 
     return cropped;
 }
@@ -189,6 +208,213 @@ cv::Mat DotGenerationWorker::sobelEdgeDetection(cv::Mat toDetect, int scale)
     return result;
 }
 
+/**
+ * @brief Band of rows of a Sobel edge mask, see DotGenerationWorker::sobelEdgeMasks.
+ */
+struct SobelEdgeBand
+{
+    int image;
+    int firstRow;
+    int lastRow; // Not included
+};
+
+/**
+ * @brief Computes bands of Sobel edge masks, as a cv::parallel_for_ body.
+ */
+class SobelEdgeMaskBody : public cv::ParallelLoopBody
+{
+private:
+    const QVector<cv::Mat> & _toDetect;
+    QVector<cv::Mat> & _masks;
+    const QVector<SobelEdgeBand> & _bands;
+
+    /**
+     * @brief Reflects an index out of [0, length) as cv::BORDER_DEFAULT (BORDER_REFLECT_101) does.
+     */
+    static int reflect(int i, int length)
+    {
+        if(length == 1)
+        {
+            return 0;
+        }
+        if(i < 0)
+        {
+            return -i;
+        }
+        if(i >= length)
+        {
+            return 2*length - i - 2;
+        }
+        return i;
+    }
+
+    /**
+     * @brief 3x3 Sobel gradients at a column. sobelEdgeDetection saturates their absolute values to
+     * 8 bits and averages them rounding to even, so it is non zero exactly when |gx| + |gy| >= 2.
+     */
+    static inline uchar edge(const uchar * up, const uchar * middle, const uchar * down, int left, int column, int right)
+    {
+        int gx = (up[right] + 2*middle[right] + down[right]) - (up[left] + 2*middle[left] + down[left]);
+        int gy = (down[left] + 2*down[column] + down[right]) - (up[left] + 2*up[column] + up[right]);
+
+        return (std::abs(gx) + std::abs(gy) >= 2) ? 255 : 0;
+    }
+
+public:
+    SobelEdgeMaskBody(const QVector<cv::Mat> & toDetect, QVector<cv::Mat> & masks, const QVector<SobelEdgeBand> & bands)
+        : _toDetect(toDetect), _masks(masks), _bands(bands)
+    {
+    }
+
+    void operator()(const cv::Range & range) const
+    {
+        cv::Mat gray;
+
+        for(int b=range.start; b<range.end; ++b)
+        {
+            const SobelEdgeBand & band = _bands[b];
+            const cv::Mat & image = _toDetect[band.image];
+            cv::Mat & mask = _masks[band.image];
+            int rows = image.rows;
+            int cols = image.cols;
+
+            // Grayscale of the band plus a row above and below, while it is still in cache.
+            int top = std::max(band.firstRow - 1, 0);
+            int bottom = std::min(band.lastRow + 1, rows);
+            cv::cvtColor(image.rowRange(top, bottom), gray, CV_RGB2GRAY);
+
+            for(int row=band.firstRow; row<band.lastRow; ++row)
+            {
+                const uchar * up = gray.ptr<uchar>(reflect(row - 1, rows) - top);
+                const uchar * middle = gray.ptr<uchar>(row - top);
+                const uchar * down = gray.ptr<uchar>(reflect(row + 1, rows) - top);
+                uchar * result = mask.ptr<uchar>(row);
+
+                // The interior columns are a branch free loop the compiler can vectorize.
+                result[0] = edge(up, middle, down, reflect(-1, cols), 0, reflect(1, cols));
+                for(int column=1; column<cols-1; ++column)
+                {
+                    result[column] = edge(up, middle, down, column - 1, column, column + 1);
+                }
+                if(cols > 1)
+                {
+                    result[cols-1] = edge(up, middle, down, cols - 2, cols - 1, reflect(cols, cols));
+                }
+            }
+        }
+    }
+};
+
+QVector<cv::Mat> DotGenerationWorker::sobelEdgeMasks(const QVector<cv::Mat> & toDetect)
+{
+    // Bands small enough to keep their three gray rows and the source rows in cache.
+    const int bandRows = 32;
+
+    QVector<cv::Mat> masks(toDetect.size());
+    QVector<SobelEdgeBand> bands;
+
+    for(int i=0; i<toDetect.size(); ++i)
+    {
+        masks[i].create(toDetect[i].rows, toDetect[i].cols, CV_8UC1);
+
+        for(int row=0; row<toDetect[i].rows; row+=bandRows)
+        {
+            SobelEdgeBand band;
+            band.image = i;
+            band.firstRow = row;
+            band.lastRow = std::min(row + bandRows, toDetect[i].rows);
+            bands.append(band);
+        }
+    }
+
+    cv::parallel_for_(cv::Range(0, bands.size()), SobelEdgeMaskBody(toDetect, masks, bands));
+
+    return masks;
+}
+
+/**
+ * @brief True if a pixel of a solid rendering is the red background.
+ */
+static inline bool isBackground(const cv::Vec3b & bgrPixel)
+{
+    return (bgrPixel[0] == 0) && (bgrPixel[1] == 0) && (bgrPixel[2] == 255);
+}
+
+cv::Mat DotGenerationWorker::silhouetteEdgeMask(const QVector<EntityTreeNode*> & nodes)
+{
+    cv::Mat mask;
+    if(nodes.isEmpty())
+    {
+        return mask;
+    }
+
+    QVector<cv::Mat> renderings(nodes.size());
+    for(int i=0; i<nodes.size(); ++i)
+    {
+        renderings[i] = nodes[i]->solidRendering();
+    }
+
+    int rows = renderings[0].rows;
+    int cols = renderings[0].cols;
+
+    // Owner of every pixel, searched deepest first as in the dot creation (-1 is the background).
+    cv::Mat labels(rows, cols, CV_32SC1);
+    for(int row=0; row<rows; ++row)
+    {
+        int * label = labels.ptr<int>(row);
+        for(int column=0; column<cols; ++column)
+        {
+            label[column] = -1;
+            for(int i=renderings.size()-1; i >= 0; --i)
+            {
+                if(!isBackground(renderings[i].at<cv::Vec3b>(row, column)))
+                {
+                    label[column] = i;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Both pixels at each side of a label change are marked, as Sobel does.
+    mask = cv::Mat::zeros(rows, cols, CV_8UC1);
+    for(int row=0; row<rows; ++row)
+    {
+        const int * label = labels.ptr<int>(row);
+        const int * below = (row+1 < rows) ? labels.ptr<int>(row+1) : 0;
+        uchar * result = mask.ptr<uchar>(row);
+        uchar * resultBelow = (row+1 < rows) ? mask.ptr<uchar>(row+1) : 0;
+
+        for(int column=0; column<cols; ++column)
+        {
+            if(column+1 < cols && label[column] != label[column+1])
+            {
+                result[column] = 255;
+                result[column+1] = 255;
+            }
+            if(below != 0 && label[column] != below[column])
+            {
+                result[column] = 255;
+                resultBelow[column] = 255;
+            }
+        }
+    }
+
+    return mask;
+}
+
+bool DotGenerationWorker::isCoverageEdge(const cv::Mat & solidRendering, int row, int column)
+{
+    bool covered = !isBackground(solidRendering.at<cv::Vec3b>(row, column));
+
+    if(row > 0 && covered == isBackground(solidRendering.at<cv::Vec3b>(row-1, column))) return true;
+    if(row+1 < solidRendering.rows && covered == isBackground(solidRendering.at<cv::Vec3b>(row+1, column))) return true;
+    if(column > 0 && covered == isBackground(solidRendering.at<cv::Vec3b>(row, column-1))) return true;
+    if(column+1 < solidRendering.cols && covered == isBackground(solidRendering.at<cv::Vec3b>(row, column+1))) return true;
+
+    return false;
+}
+
 cv::Mat DotGenerationWorker::cannyEdgeDetection(cv::Mat toDetect, int lowThreshold, int highThreshold)
 {
     cv::Mat result, gray;
@@ -240,16 +466,31 @@ cv::Mat DotGenerationWorker::thresholding(cv::Mat toThreshold, int threshold, in
 
 DotGenerationWorker::DotGenerationWorker(cv::Mat toStipple,
                                          DitheringMethod ditheringMethod,
-                                         glm::vec2 spriteSize,
-                                         glm::vec2 spritesMatrixSize,
+                                         const SpriteAtlas & sprites,
                                          cv::Mat solid3DModel,
                                          Configuration * globalConfig,
                                          EntityTreeController * entities)
 {
     _toStipple = toStipple;
     _ditheringMethod = ditheringMethod;
-    _spriteSize = spriteSize;
-    _spritesMatrixSize = spritesMatrixSize;
+    _spriteSize = sprites.spriteSize();
+    _numberOfSprites = sprites.numberOfSprites();
+    _spriteCoverage = sprites.coverages();
+
+    // Sprites that leave no ink can not darken anything.
+    QVector< QPair<float, int> > ranking;
+    for(int i=0; i<_numberOfSprites; ++i)
+    {
+        if(_spriteCoverage[i] > 0.0f)
+        {
+            ranking.append(qMakePair(_spriteCoverage[i], i));
+        }
+    }
+    qSort(ranking);
+    for(int i=0; i<ranking.size(); ++i)
+    {
+        _spritesByCoverage.append(ranking[i].second);
+    }
 
     _solid3DModel = solid3DModel;
 
@@ -258,6 +499,14 @@ DotGenerationWorker::DotGenerationWorker(cv::Mat toStipple,
     _globalConfig = globalConfig;
 
     _entities = entities;
+
+    _debugOutput = true;
+
+    _profiler = 0;
+
+    _intermediateCache = 0;
+
+    _progressiveOutput = false;
 }
 
 DotGenerationWorker::~DotGenerationWorker()
@@ -266,261 +515,967 @@ DotGenerationWorker::~DotGenerationWorker()
     _stipplingDots = 0;
 }
 
+void DotGenerationWorker::setDebugOutput(bool debugOutput)
+{
+    _debugOutput = debugOutput;
+}
+
+void DotGenerationWorker::setProfiler(StageProfiler * profiler)
+{
+    _profiler = profiler;
+}
+
+void DotGenerationWorker::setIntermediateCache(IntermediateCache * cache, const QByteArray & sceneKey)
+{
+    _intermediateCache = cache;
+    _sceneKey = sceneKey;
+}
+
+void DotGenerationWorker::setProgressiveOutput(bool progressiveOutput)
+{
+    _progressiveOutput = progressiveOutput;
+}
+
+glm::vec4 DotGenerationWorker::stippledImageArea() const
+{
+    int stippledImageRows = _toStipple.rows * _spriteSize.y / _globalConfig->packingFactor();
+    int stippledImageCols = _toStipple.cols * _spriteSize.x / _globalConfig->packingFactor();
+
+    return glm::vec4(0, 0, stippledImageCols, stippledImageRows);
+}
+
+QList<StippleDotBand *> DotGenerationWorker::takeCompletedBands()
+{
+    return _completedBands.takeAll();
+}
+
+void DotGenerationWorker::cancel()
+{
+    _cancelRequested.fetchAndStoreRelease(1);
+}
+
 QuadTree * DotGenerationWorker::getStipplingDots()
 {
     return _stipplingDots;
 }
 
-void DotGenerationWorker::process()
+cv::Mat DotGenerationWorker::ditheredImage() const
 {
-    out << "Beginning stippling process..." << endl;
+    return _ditheredImage;
+}
 
-    cv::Mat imageDithered;
-    switch(_ditheringMethod)
+/**
+ * @brief Sprite of a dot placed by the TONE_AWARE placement: one of the sprites whose coverage ranks
+ * close to the darkness of its pixel, so darker areas are drawn with inkier sprites.
+ * @param spritesByCoverage Sprites, from the lightest to the inkiest (not empty).
+ * @param darkness Darkness of the pixel, between 0 (white) and 1 (black).
+ */
+static int toneSprite(const QVector<int> & spritesByCoverage, float darkness, Random & random)
+{
+    // The sprite is drawn from a window of a quarter of the ranking, centered on the darkness.
+    int sprites = spritesByCoverage.size();
+    int window = qMax(1, sprites / 4);
+    int first = qBound(0, int(darkness * (sprites - 1)) - window / 2, sprites - window);
+
+    return spritesByCoverage[first + random.next(window)];
+}
+
+DotGenerationWorker::PixelOwner DotGenerationWorker::pixelOwner(const QVector<EntityTreeNode*> & nodes, int row, int column) const
+{
+    // Search for the first node (deepest first) that has a green solid rendering
+    // for the given pixel and has a non default specific configuration. If none
+    // is found, generate the dot using general configuration if any node has been
+    // flagged as green.
+    PixelOwner owner;
+    owner.node = 0;
+    owner.modelled = false;
+    for(int i=nodes.size()-1; i >= 0; --i)
     {
-        case FLOYD_STEINBERG:
-            imageDithered = floydSteinbergDithering(_toStipple);
-            break;
-        case STUCKI:
-            imageDithered = stuckiDithering(_toStipple);
+        cv::Vec3b bgrPixel = nodes.at(i)->solidRendering().at<cv::Vec3b>(row, column);
+        bool isRed = ( (bgrPixel[0] == 0) && (bgrPixel[1] == 0)  && (bgrPixel[2] == 255) );
+
+        owner.modelled = owner.modelled || !isRed;
+
+        if(!isRed && !nodes.at(i)->configuration()->isDefault())
+        {
+            owner.node = nodes.at(i);
             break;
+        }
     }
 
-    out << "Dithered image created..." << endl;
-
-    switch(_globalConfig->edgeDetectionMethod())
+    if(owner.node != 0)
     {
-    case SOBEL:
-        _edgeDetectedSolid3DModel = sobelEdgeDetection(_solid3DModel);
-        break;
-    case CANNY:
-        _edgeDetectedSolid3DModel = cannyEdgeDetection(_solid3DModel, 50, 150);
-        break;
+        bool specificSilhouette = owner.node->configuration()->hasSpecificEdgeDetectionMethod() ?
+                    (owner.node->configuration()->edgeDetectionMethod() == SILHOUETTE) :
+                    (_globalConfig->edgeDetectionMethod() == SILHOUETTE);
+        if(specificSilhouette)
+        {
+            // Use specific configuration, on the node's own coverage
+            owner.edge = isCoverageEdge(owner.node->solidRendering(), row, column);
+        }
+        else
+        {
+            // Use specific configuration
+            owner.edge = (owner.node->edgeDetection().at<unsigned char>(row, column) != 0);
+        }
+    }
+    else
+    {
+        // Use general configuration
+        owner.edge = (_edgeDetectedSolid3DModel.at<unsigned char>(row, column) != 0);
     }
 
-    cv::imwrite("debugEdgeGlobalSolid.png", _edgeDetectedSolid3DModel);
-
-    // Get the nodes breadth first
-    QVector<EntityTreeNode*> * nodes = _entities->traverseBreadthFirst();
+    return owner;
+}
 
-    foreach(EntityTreeNode * node, *nodes)
+qint64 DotGenerationWorker::generateDots(const cv::Mat & imageDithered, const QVector<EntityTreeNode*> & nodes,
+                                         const cv::Mat & region, QuadTree * dots)
+{
+    glm::vec4 stippledArea = stippledImageArea();
+    int stippledImageRows = stippledArea.w;
+
+    quint64 seed = Random::seedOf(_globalConfig->rngSeed());
+
+    // Grid cells a sprite spans, to turn the ink of a sprite in the darkness of a single pixel.
+    float cellsPerSprite = float(_globalConfig->packingFactor() * _globalConfig->packingFactor());
+    bool tonePlacement = _globalConfig->dotPlacement() == TONE_AWARE && !_toneImage.empty() && !_spritesByCoverage.isEmpty();
+
+    // Thresholds the chance roll (in [0, 100)) of a pixel has to reach for it to get a dot:
+    // outside the model, inside it (general or specific configuration) or on its edges, that always
+    // get their dot.
+    unsigned char unmodelledThreshold = (unsigned char)(100 - _globalConfig->unmodelledStipplingChance());
+    unsigned char modelledThreshold = (unsigned char)(100 - _globalConfig->modelledStipplingChance());
+
+    // Every row is prepared first (owner, sprite and random rolls of its pixels), then decided at
+    // once by DotAcceptance, and the dots are only created for the accepted pixels.
+    int columns = imageDithered.cols;
+    QVector<unsigned char> dark(columns), roll(columns), threshold(columns), offsetRoll(columns), offsetThreshold(columns);
+    QVector<int> sprite(columns);
+    QVector<quint32> accepted(DotAcceptance::words(columns)), offsetAllowed(DotAcceptance::words(columns));
+
+    // Ownership lookup, dot creation and quadtree insertion are timed (wall time only) row by row,
+    // just when a profiler is attached.
+    bool profiling = (_profiler != 0);
+    QElapsedTimer stageTimer;
+    if(profiling) stageTimer.start();
+    qint64 lap = 0;
+    qint64 ownershipLookupTime = 0;
+    qint64 dotCreationTime = 0;
+    qint64 quadTreeInsertionTime = 0;
+    qint64 numberOfDots = 0;
+
+    // Only whole images are handed out progressively.
+    bool progressive = _progressiveOutput && region.empty();
+    StippleDotBand * band = 0;
+
+    if(_debugOutput) out << "Progress: 0%" << endl;
+    int lastProgress = 0;
+    for (int row=0; row<imageDithered.rows && !_cancelRequested; ++row)
     {
-        if(!node->configuration()->isDefault())
+        if(progressive && band == 0)
+        {
+            band = new StippleDotBand;
+            band->firstRow = row;
+        }
+
+        if(profiling) lap = stageTimer.nsecsElapsed();
+
+        const unsigned char * ditheredRow = imageDithered.ptr<unsigned char>(row);
+        for (int column=0; column<columns; ++column)
         {
-            EdgeDetectionMethod method;
-            if(node->configuration()->hasSpecificEdgeDetectionMethod())
+            if(!region.empty() && region.at<unsigned char>(row, column) == 0)
             {
-                method = node->configuration()->edgeDetectionMethod();
+                dark[column] = 0;
+                continue;
+            }
+
+            // Every pixel draws its numbers in the same order: sprite, tone placement (tone aware
+            // placement, off the edges), chance roll, offset roll.
+            Random random(seed, Random::key(row, column));
+
+            PixelOwner owner = pixelOwner(nodes, row, column);
+
+            bool correctDitheringValue;
+            if(tonePlacement)
+            {
+                // Edges keep the dots of the dithered image, so the silhouettes stay as sharp.
+                // Elsewhere a dot is placed with the probability that its ink gives the darkness of
+                // the pixel, spread over the cells its sprite spans.
+                float darkness = 1.0f - _toneImage.at<unsigned char>(row, column) / 255.0f;
+                sprite[column] = toneSprite(_spritesByCoverage, darkness, random);
+                if(owner.edge)
+                {
+                    correctDitheringValue = (ditheredRow[column] <= 128);
+                }
+                else
+                {
+                    float placementChance = qMin(1.0f, darkness / (_spriteCoverage[sprite[column]] * cellsPerSprite));
+                    correctDitheringValue = random.next(1 << 16) < int(placementChance * (1 << 16));
+                }
             }
             else
             {
-                method = _globalConfig->edgeDetectionMethod();
+                // Pick a random dot sprite
+                sprite[column] = random.next(_numberOfSprites);
+                correctDitheringValue = (ditheredRow[column] <= 128);
             }
-            switch(method)
+            dark[column] = correctDitheringValue ? 255 : 0;
+
+            roll[column] = (unsigned char)random.next(100);
+            offsetRoll[column] = (unsigned char)random.next(100);
+
+            if(!owner.modelled)
             {
-            case SOBEL:
-                node->setEdgeDetection(sobelEdgeDetection(node->solidRendering()));
-                break;
-            case CANNY:
-                node->setEdgeDetection(cannyEdgeDetection(node->solidRendering(), 50, 150));
-                break;
+                threshold[column] = unmodelledThreshold;
+            }
+            else if(owner.edge)
+            {
+                // Is part of the silhouette
+                threshold[column] = 0;
+            }
+            else if(owner.node != 0 && owner.node->configuration()->percentageInternalGeneration() != -1)
+            {
+                // Use specific configuration
+                threshold[column] = (unsigned char)(101 - owner.node->configuration()->percentageInternalGeneration());
+            }
+            else
+            {
+                // Use general configuration
+                threshold[column] = modelledThreshold;
             }
 
-            cv::imwrite(QString("debugEdgeSpecific" + node->name() + ".png").toStdString(), node->edgeDetection());
+            // Dots on the silhouette only get an offset with the specific configuration.
+            if(!owner.edge)
+            {
+                offsetThreshold[column] = 0;
+            }
+            else if(owner.node != 0)
+            {
+                offsetThreshold[column] = (unsigned char)(101 - owner.node->configuration()->percentageSilhouetteDispersion());
+            }
+            else
+            {
+                offsetThreshold[column] = DotAcceptance::NEVER;
+            }
         }
-    }
 
-    out << "Edge detection completed..." << endl;
+        if(profiling)
+        {
+            qint64 now = stageTimer.nsecsElapsed();
+            ownershipLookupTime += now - lap;
+            lap = now;
+        }
 
-    out << "Beginning dot creation..." << endl;
+        DotAcceptance::acceptRow(dark.constData(), roll.constData(), threshold.constData(),
+                                 offsetRoll.constData(), offsetThreshold.constData(),
+                                 columns, accepted.data(), offsetAllowed.data());
 
-    int stippledImageRows = imageDithered.rows * _spriteSize.y / _globalConfig->packingFactor();
-    int stippledImageCols = imageDithered.cols * _spriteSize.x / _globalConfig->packingFactor();
+        for(int word=0; word<accepted.size(); ++word)
+        {
+            quint32 bits = accepted[word];
+            for(int column=32*word; bits != 0; ++column, bits >>= 1)
+            {
+                if((bits & 1) == 0)
+                {
+                    continue;
+                }
 
-    out << "Original image size: " << imageDithered.rows << " x " << imageDithered.cols << " px" <<endl;
-    out << "Stippled image size: " << stippledImageRows << " x " << stippledImageCols << " px" << endl;
-    out << "Packing factor: " << _globalConfig->packingFactor() << endl;
+                float posX = float(column * _spriteSize.x / _globalConfig->packingFactor());
+                float posY = float(stippledImageRows - (row * _spriteSize.y / _globalConfig->packingFactor()));
+                StippleDot * dot = new StippleDot(glm::vec2(posX, posY),
+                                              _spriteSize,
+                                              sprite[column]);
+                dot->setCanHaveOffsetApplied(((offsetAllowed[word] >> (column - 32*word)) & 1) != 0);
 
-    int depth = 5;
+                if(profiling)
+                {
+                    qint64 now = stageTimer.nsecsElapsed();
+                    dotCreationTime += now - lap;
+                    lap = now;
+                }
 
-    // TODO, choose a depth that is admitted by the size of the stippled image.
-    // The depth should be calculated so that the leaf node's area isn't too big nor too small.
+                // The tree deletes the dots out of its area.
+                StippleDot added = *dot;
+                if(dots->add(dot))
+                {
+                    ++numberOfDots;
+                    if(band != 0)
+                    {
+                        band->dots.append(added);
+                    }
+                }
 
-    _stipplingDots = new QuadTree(glm::vec4(0,0,stippledImageCols,stippledImageRows), depth);
-    //out << "_stipplingDots = " << _stipplingDots << endl;
+                if(profiling)
+                {
+                    qint64 now = stageTimer.nsecsElapsed();
+                    quadTreeInsertionTime += now - lap;
+                    lap = now;
+                }
+            }
+        }
 
-    //out << "QuadTree created with " << _stipplingDots->numberOfNodes() << " nodes and a depth of " << depth << "." << endl;
-    //out << "QuadTree has " << _stipplingDots->numberOfLeaves() << " leaf nodes." << endl;
-    //out << "A leaf node's area is equal to " << stippledImageRows / sqrt(_stipplingDots->numberOfLeaves()) << " x " << stippledImageCols / sqrt(_stipplingDots->numberOfLeaves()) << " px." << endl;
+        if(profiling)
+        {
+            dotCreationTime += stageTimer.nsecsElapsed() - lap;
+        }
 
+        if(band != 0 && (row - band->firstRow + 1 == BAND_ROWS || row == imageDithered.rows-1))
+        {
+            band->lastRow = row;
+            _completedBands.push(band);
+            band = 0;
+        }
+
+        int progress = (100 * (row+1)) / imageDithered.rows;
+        if(progress >= lastProgress+10)
+        {
+            lastProgress = progress - (progress % 10);
+            if(_debugOutput) out << "Progress: " << lastProgress << "%" << endl;
+            emit progressChanged(lastProgress);
+        }
+    }
 
-    srand(_globalConfig->rngSeed());
+    // Incomplete if the generation was cancelled.
+    delete band;
 
-    out << "Progress: 0%" << endl;
-    int lastProgress = 0;
-    for (int row=0; row<imageDithered.rows; ++row)
+    if(profiling)
     {
-        for (int column=0; column<imageDithered.cols; ++column)
-        {
-            // Pick a random dot sprite
-            int chosenDot = rand() % ((int(_spritesMatrixSize.x * _spritesMatrixSize.y)) - 1);
+        qint64 pixels = region.empty() ? qint64(imageDithered.rows) * imageDithered.cols : qint64(cv::countNonZero(region));
+        _profiler->record(StageProfiler::OWNERSHIP_LOOKUP, ownershipLookupTime, -1, pixels);
+        _profiler->record(StageProfiler::DOT_CREATION, dotCreationTime, -1, numberOfDots);
+        _profiler->record(StageProfiler::QUADTREE_INSERTION, quadTreeInsertionTime, -1, numberOfDots);
+    }
 
+    return numberOfDots;
+}
 
-            // Search for the first node (deepest first) that has a green solid rendering
-            // for the given pixel and has a non default specific configuration. If none
-            // is found, generate the dot using general configuration if any node has been
-            // flagged as green.
-            EntityTreeNode * foundNode = 0;
-            bool anyGreen = false;
-            //foreach(EntityTreeNode * node, *nodes)
-            for(int i=nodes->size()-1; i >= 0; --i)
-            {
-                cv::Vec3b bgrPixel = nodes->at(i)->solidRendering().at<cv::Vec3b>(row, column);
-                bool isRed = ( (bgrPixel[0] == 0) && (bgrPixel[1] == 0)  && (bgrPixel[2] == 255) );
+cv::Mat DotGenerationWorker::dotDensity(const cv::Mat & imageDithered, const QVector<EntityTreeNode*> & nodes)
+{
+    StageProfiler::ScopedStage stage(_profiler, StageProfiler::OWNERSHIP_LOOKUP);
 
-                anyGreen = anyGreen || !isRed;
+    cv::Mat density(imageDithered.rows, imageDithered.cols, CV_32FC1);
+    for(int row=0; row<imageDithered.rows; ++row)
+    {
+        float * densityRow = density.ptr<float>(row);
+        for(int column=0; column<imageDithered.cols; ++column)
+        {
+            PixelOwner owner = pixelOwner(nodes, row, column);
 
-                if(!isRed && !nodes->at(i)->configuration()->isDefault())
+            float darkness;
+            float weight;
+            if(!owner.modelled)
+            {
+                darkness = 1.0f - _toneImage.at<unsigned char>(row, column) / 255.0f;
+                weight = _globalConfig->unmodelledStipplingChance() / 100.0f;
+            }
+            else if(owner.edge)
+            {
+                // Edges keep the dots of the dithered image, so the silhouettes stay as sharp.
+                darkness = (imageDithered.at<unsigned char>(row, column) <= 128) ? 1.0f : 0.0f;
+                weight = 1.0f;
+            }
+            else
+            {
+                darkness = 1.0f - _toneImage.at<unsigned char>(row, column) / 255.0f;
+                if(owner.node != 0 && owner.node->configuration()->percentageInternalGeneration() != -1)
                 {
-                    foundNode = nodes->at(i);
-                    break;
+                    weight = owner.node->configuration()->percentageInternalGeneration() / 100.0f;
+                }
+                else
+                {
+                    weight = _globalConfig->modelledStipplingChance() / 100.0f;
                 }
             }
+            densityRow[column] = darkness * weight;
+        }
+    }
+    stage.addItems(qint64(imageDithered.rows) * imageDithered.cols);
+
+    return density;
+}
+
+float DotGenerationWorker::inkPerDot() const
+{
+    // Ink of an average sprite, spread over the cells it spans.
+    float meanCoverage = 0.0f;
+    foreach(int sprite, _spritesByCoverage)
+    {
+        meanCoverage += _spriteCoverage[sprite];
+    }
+    meanCoverage /= _spritesByCoverage.size();
+
+    return meanCoverage * _globalConfig->packingFactor() * _globalConfig->packingFactor();
+}
+
+qint64 DotGenerationWorker::addPointDots(const QVector<glm::vec2> & points, const QVector<EntityTreeNode*> & nodes, QuadTree * dots)
+{
+    StageProfiler::ScopedStage stage(_profiler, StageProfiler::QUADTREE_INSERTION);
+
+    glm::vec4 stippledArea = stippledImageArea();
+    int stippledImageRows = stippledArea.w;
+    float packingFactor = float(_globalConfig->packingFactor());
+
+    quint64 seed = Random::seedOf(_globalConfig->rngSeed());
+
+    StippleDotBand * band = 0;
+    if(_progressiveOutput)
+    {
+        band = new StippleDotBand;
+        band->firstRow = 0;
+        band->lastRow = _toneImage.rows - 1;
+    }
 
+    qint64 numberOfDots = 0;
+    for(int i=0; i<points.size(); ++i)
+    {
+        // The dots of a pixel are placed at its top left corner on the grid placements. Points on
+        // the first half pixel are kept in the image, or the tree would drop them.
+        glm::vec2 position = glm::max(points[i] - glm::vec2(0.5f), glm::vec2(0.0f));
+        int row = qBound(0, int(points[i].y), _toneImage.rows - 1);
+        int column = qBound(0, int(points[i].x), _toneImage.cols - 1);
+
+        Random random(seed, Random::key(i, -1));
+        float darkness = 1.0f - _toneImage.at<unsigned char>(row, column) / 255.0f;
+        int chosenDot = toneSprite(_spritesByCoverage, darkness, random);
+
+        float posX = position.x * _spriteSize.x / packingFactor;
+        float posY = stippledImageRows - position.y * _spriteSize.y / packingFactor;
+        StippleDot * dot = new StippleDot(glm::vec2(posX, posY), _spriteSize, chosenDot);
+
+        PixelOwner owner = pixelOwner(nodes, row, column);
+        if(owner.edge)
+        {
+            bool offset = owner.node != 0 &&
+                          random.next(100) > 100 - owner.node->configuration()->percentageSilhouetteDispersion();
+            dot->setCanHaveOffsetApplied(offset);
+        }
+        else
+        {
+            dot->setCanHaveOffsetApplied(true);
+        }
 
-            cv::Mat specificEdgeDetectedSolid3DModel;
-            if(foundNode != 0)
+        StippleDot added = *dot;
+        if(dots->add(dot))
+        {
+            ++numberOfDots;
+            if(band != 0)
             {
-                specificEdgeDetectedSolid3DModel = foundNode->edgeDetection();
+                band->dots.append(added);
             }
+        }
+    }
+    stage.addItems(numberOfDots);
 
-            bool correctDitheringValue = (imageDithered.at<unsigned char>(row, column) <= 128);
-            bool isRed = !anyGreen;
+    if(band != 0)
+    {
+        _completedBands.push(band);
+    }
 
-            bool belongsToModel = ( correctDitheringValue && !isRed );
+    return numberOfDots;
+}
 
-            bool externalToModelButChosen = false;
-            if(!belongsToModel)
+qint64 DotGenerationWorker::generateVoronoiDots(const cv::Mat & imageDithered, const QVector<EntityTreeNode*> & nodes, QuadTree * dots)
+{
+    if(_toneImage.empty() || _spritesByCoverage.isEmpty())
+    {
+        return 0;
+    }
+
+    quint64 seed = Random::seedOf(_globalConfig->rngSeed());
+
+    cv::Mat density = dotDensity(imageDithered, nodes);
+
+    double totalDensity = cv::sum(density)[0];
+    int numberOfSites = int(totalDensity / inkPerDot() + 0.5);
+    if(numberOfSites == 0)
+    {
+        return 0;
+    }
+
+    // Cells of a few pixels make blocky centroids, so the density is supersampled until a cell
+    // has about 64 of them, as long as it fits in VORONOI_MAX_PIXELS.
+    double pixels = double(imageDithered.rows) * imageDithered.cols;
+    double pixelsPerSite = pixels / numberOfSites;
+    int supersampling = qBound(1, int(std::ceil(std::sqrt(64.0 / pixelsPerSite))), 4);
+    supersampling = qMax(1, qMin(supersampling, int(std::sqrt(VORONOI_MAX_PIXELS / pixels))));
+
+    // Initial sites: every pixel draws its share of the sites from its own random numbers.
+    QVector<glm::vec2> sites;
+    sites.reserve(numberOfSites);
+    double sitesPerDensity = numberOfSites / totalDensity;
+    for(int row=0; row<imageDithered.rows; ++row)
+    {
+        for(int column=0; column<imageDithered.cols; ++column)
+        {
+            double expected = density.at<float>(row, column) * sitesPerDensity;
+            if(expected <= 0.0)
             {
-                // Check the chances of still generating the dot
-                int unmodelledChance = rand() % 100;
-                //out << "UnmodelledChance: " << unmodelledChance << endl;
-                if(correctDitheringValue && (unmodelledChance >= 100 - _globalConfig->unmodelledStipplingChance()))
-                {
-                    externalToModelButChosen = true;
-                }
-                else
-                {
-                    externalToModelButChosen = false;
-                }
+                continue;
             }
 
-            bool isEdgeModel;
-            if(foundNode != 0)
+            Random random(seed, Random::key(row, column));
+            int count = int(expected);
+            if(random.next(1 << 16) < int((expected - count) * (1 << 16)))
             {
-                // Use specific configuration
-                isEdgeModel = (specificEdgeDetectedSolid3DModel.at<unsigned char>(row, column) != 0);
+                ++count;
+            }
+            for(int i=0; i<count; ++i)
+            {
+                float x = column + random.uniform();
+                float y = row + random.uniform();
+                sites.append(glm::vec2(x, y) * float(supersampling));
+            }
+        }
+    }
+
+    if(supersampling > 1)
+    {
+        cv::resize(density, density, cv::Size(), supersampling, supersampling, cv::INTER_LINEAR);
+    }
+
+    VoronoiStippler stippler(density);
+    stippler.setSites(sites);
+
+    if(_debugOutput) out << "Progress: 0%" << endl;
+    {
+        StageProfiler::ScopedStage stage(_profiler, StageProfiler::DOT_CREATION);
+        int lastProgress = 0;
+        for(int iteration=0; iteration<VORONOI_ITERATIONS && !_cancelRequested; ++iteration)
+        {
+            float displacement = stippler.relax();
+            stage.addItems(1);
+
+            int progress = (100 * (iteration+1)) / VORONOI_ITERATIONS;
+            if(progress >= lastProgress+10)
+            {
+                lastProgress = progress - (progress % 10);
+                if(_debugOutput) out << "Progress: " << lastProgress << "%" << endl;
+                emit progressChanged(lastProgress);
+            }
+
+            // Converged once the sites move less than a twentieth of a pixel.
+            if(displacement < 0.05f * supersampling)
+            {
+                if(_debugOutput) out << "Converged after " << iteration+1 << " iterations." << endl;
+                emit progressChanged(100);
+                break;
+            }
+        }
+    }
+
+    if(_cancelRequested)
+    {
+        return 0;
+    }
+
+    QVector<glm::vec2> relaxed = stippler.sites();
+    for(int i=0; i<relaxed.size(); ++i)
+    {
+        relaxed[i] /= float(supersampling);
+    }
+    qint64 numberOfDots = addPointDots(relaxed, nodes, dots);
+
+    if(_debugOutput) out << numberOfDots << " dots placed by weighted Voronoi stippling." << endl;
+
+    return numberOfDots;
+}
+
+qint64 DotGenerationWorker::generatePoissonDiskDots(const cv::Mat & imageDithered, const QVector<EntityTreeNode*> & nodes, QuadTree * dots)
+{
+    if(_toneImage.empty() || _spritesByCoverage.isEmpty())
+    {
+        return 0;
+    }
+
+    quint64 seed = Random::seedOf(_globalConfig->rngSeed());
+
+    cv::Mat density = dotDensity(imageDithered, nodes);
+
+    // A maximal Poisson disk sampling leaves about 1.44 squared radii to every point, so the radius
+    // giving a pixel the ink it needs is sqrt(ink of a dot / (1.44 * density)), 0 where there is no density.
+    float ink = inkPerDot();
+    cv::Mat radius;
+    cv::divide(ink / 1.44, density, radius);
+    cv::sqrt(radius, radius);
+
+    // Dots closer than a pixel are not worth it, as on the grid placements. Areas that would get
+    // dots more than 16 times further apart get none.
+    float minimumRadius = qMax(1.0f, std::sqrt(ink / 1.44f));
+    float maximumRadius = 16.0f * minimumRadius;
+    radius.setTo(cv::Scalar(0), radius > maximumRadius);
+
+    if(_debugOutput) out << "Progress: 0%" << endl;
+    QVector<glm::vec2> points;
+    {
+        StageProfiler::ScopedStage stage(_profiler, StageProfiler::DOT_CREATION);
+
+        PoissonDiskSampler sampler(radius, minimumRadius, maximumRadius);
+        points = sampler.sample(seed, POISSON_DISK_ATTEMPTS);
+
+        stage.addItems(points.size());
+    }
+    if(_debugOutput) out << "Progress: 100%" << endl;
+    emit progressChanged(100);
+
+    if(_cancelRequested)
+    {
+        return 0;
+    }
+
+    qint64 numberOfDots = addPointDots(points, nodes, dots);
+
+    if(_debugOutput) out << numberOfDots << " dots placed by Poisson disk sampling." << endl;
+
+    return numberOfDots;
+}
+
+QByteArray DotGenerationWorker::edgesKey(int nodeIndex, EdgeDetectionMethod method) const
+{
+    if(_intermediateCache == 0 || _sceneKey.isEmpty())
+    {
+        return QByteArray();
+    }
+
+    return IntermediateCache::Key("edges").add(_sceneKey).add(nodeIndex).add(int(method)).result();
+}
+
+void DotGenerationWorker::detectSpecificEdges(EntityTreeNode * node)
+{
+    if(node->configuration()->isDefault())
+    {
+        // Its dots are generated with the general configuration.
+        return;
+    }
+
+    EdgeDetectionMethod method = _globalConfig->edgeDetectionMethod();
+    if(node->configuration()->hasSpecificEdgeDetectionMethod())
+    {
+        method = node->configuration()->edgeDetectionMethod();
+    }
+
+    switch(method)
+    {
+    case SOBEL:
+        node->setEdgeDetection(sobelEdgeMasks(QVector<cv::Mat>() << node->solidRendering())[0]);
+        break;
+    case CANNY:
+        node->setEdgeDetection(cannyEdgeDetection(node->solidRendering(), 50, 150));
+        break;
+    case SILHOUETTE:
+        node->setEdgeDetection(cv::Mat());
+        break;
+    }
+}
+
+bool DotGenerationWorker::regenerateNode(EntityTreeNode * node, QuadTree * dots)
+{
+    if(_ditheredImage.empty() || dots == 0)
+    {
+        out << "Error: the image has to be stippled before the dots of an entity can be generated again." << endl;
+        return false;
+    }
+
+    // Changes on the general configuration affect the whole image.
+    if(_globalConfig->packingFactor() != _generationConfig.packingFactor() ||
+       _globalConfig->rngSeed() != _generationConfig.rngSeed() ||
+       _globalConfig->unmodelledStipplingChance() != _generationConfig.unmodelledStipplingChance() ||
+       _globalConfig->modelledStipplingChance() != _generationConfig.modelledStipplingChance() ||
+       _globalConfig->edgeDetectionMethod() != _generationConfig.edgeDetectionMethod() ||
+       _globalConfig->dotPlacement() != _generationConfig.dotPlacement())
+    {
+        out << "Error: the general configuration changed since the image was stippled, it has to be stippled again." << endl;
+        return false;
+    }
+
+    // Relaxed and Poisson disk dots depend on the dots around them, not only on their pixel.
+    if(_generationConfig.dotPlacement() == WEIGHTED_VORONOI || _generationConfig.dotPlacement() == POISSON_DISK)
+    {
+        out << "Error: the dots placed off the grid can not be generated again for a single entity, the image has to be stippled again." << endl;
+        return false;
+    }
+
+    if(_debugOutput) out << "Generating again the dots of " << node->name() << "..." << endl;
+
+    // The configuration of a node only affects the pixels it covers. Those owned by a deeper
+    // node get the same dots again, as the random numbers of every pixel are fixed.
+    cv::Mat background, region;
+    cv::inRange(node->solidRendering(), cv::Scalar(0, 0, 255), cv::Scalar(0, 0, 255), background);
+    cv::bitwise_not(background, region);
+
+    detectSpecificEdges(node);
+
+    // Drop the dots of the region. The generation position of a dot gives back its pixel.
+    glm::vec4 stippledArea = stippledImageArea();
+    float packingFactor = float(_globalConfig->packingFactor());
+    qint64 removedDots = 0;
+    foreach(QVector<StippleDot *> * leaf, dots->getDotsInFullArea())
+    {
+        int kept = 0;
+        for(int i=0; i<leaf->size(); ++i)
+        {
+            StippleDot * dot = leaf->at(i);
+            glm::vec2 position = dot->position();
+            int column = qRound(position.x * packingFactor / _spriteSize.x);
+            int row = qRound((stippledArea.w - position.y) * packingFactor / _spriteSize.y);
+
+            bool inRegion = row >= 0 && row < region.rows && column >= 0 && column < region.cols &&
+                            region.at<unsigned char>(row, column) != 0;
+            if(inRegion)
+            {
+                delete dot;
+                ++removedDots;
             }
             else
             {
-                // Use general configuration
-                isEdgeModel = (_edgeDetectedSolid3DModel.at<unsigned char>(row, column) != 0);
+                (*leaf)[kept++] = dot;
             }
+        }
+        leaf->resize(kept);
+    }
+
+    QVector<EntityTreeNode*> * nodes = _entities->traverseBreadthFirst();
+    qint64 addedDots = generateDots(_ditheredImage, *nodes, region, dots);
+    delete nodes;
+
+    if(_debugOutput) out << removedDots << " dots replaced by " << addedDots << "." << endl;
 
-            bool belongsToModelAndChosen = false;
-            if(belongsToModel)
+    return true;
+}
+
+void DotGenerationWorker::process()
+{
+    if(_debugOutput) out << "Beginning stippling process..." << endl;
+
+    cv::Mat imageDithered;
+    {
+        StageProfiler::ScopedStage stage(_profiler, StageProfiler::DITHERING);
+
+        QByteArray key;
+        if(_intermediateCache != 0)
+        {
+            key = IntermediateCache::Key("dithered image").add(int(_ditheringMethod)).add(_toStipple).result();
+        }
+
+        if(_intermediateCache == 0 || !_intermediateCache->load(key, imageDithered))
+        {
+            switch(_ditheringMethod)
+            {
+                case FLOYD_STEINBERG:
+                    imageDithered = floydSteinbergDithering(_toStipple);
+                    break;
+                case STUCKI:
+                    imageDithered = stuckiDithering(_toStipple);
+                    break;
+            }
+            if(_intermediateCache != 0)
             {
-                // Check the chances of generating the dot in the modelled area
-                // If the dot corresponds to an edge of the model, it will always be generated
-                int modelledChance = rand() % 100;
-                //out << "ModelledChance: " << modelledChance << endl;
-                if( isEdgeModel)
+                _intermediateCache->store(key, imageDithered);
+            }
+        }
+        stage.addItems(qint64(_toStipple.rows) * _toStipple.cols);
+    }
+    _ditheredImage = imageDithered;
+    _generationConfig = *_globalConfig;
+
+    // The darkness around every pixel, rather than the pixel alone, chooses the sprites.
+    _toneImage.release();
+    if(_globalConfig->dotPlacement() != DITHERED_GRID)
+    {
+        cv::Mat imageGrayscale;
+        cvtColor(_toStipple, imageGrayscale, CV_RGB2GRAY);
+        cv::GaussianBlur(imageGrayscale, _toneImage, cv::Size(5, 5), 0);
+    }
+
+    if(_cancelRequested)
+    {
+        if(_debugOutput) out << "Stippling process cancelled." << endl;
+        emit finished();
+        return;
+    }
+
+    if(_debugOutput) out << "Dithered image created..." << endl;
+
+    // Get the nodes breadth first
+    QVector<EntityTreeNode*> * nodes = _entities->traverseBreadthFirst();
+
+    {
+        StageProfiler::ScopedStage stage(_profiler, StageProfiler::EDGE_DETECTION);
+
+        // The Sobel edges (global and specific) are only tested against 0, so they are computed
+        // as binary masks all at once. Canny ones are computed one by one. The silhouettes of the
+        // specific nodes are checked on their solid renderings during the dot creation.
+        // Edge images found in the cache are not computed again.
+        QVector<cv::Mat> sobelInputs;
+        QVector<EntityTreeNode*> sobelNodes;
+        QVector<QByteArray> computedKeys;
+        QVector<cv::Mat> computedEdges;
+
+        QByteArray globalKey = edgesKey(-1, _globalConfig->edgeDetectionMethod());
+        bool globalSobel = false;
+        if(globalKey.isEmpty() || !_intermediateCache->load(globalKey, _edgeDetectedSolid3DModel))
+        {
+            switch(_globalConfig->edgeDetectionMethod())
+            {
+            case SOBEL:
+                sobelInputs.append(_solid3DModel);
+                globalSobel = true;
+                break;
+            case CANNY:
+                _edgeDetectedSolid3DModel = cannyEdgeDetection(_solid3DModel, 50, 150);
+                computedKeys.append(globalKey);
+                computedEdges.append(_edgeDetectedSolid3DModel);
+                break;
+            case SILHOUETTE:
+                _edgeDetectedSolid3DModel = silhouetteEdgeMask(*nodes);
+                computedKeys.append(globalKey);
+                computedEdges.append(_edgeDetectedSolid3DModel);
+                break;
+            }
+        }
+        stage.addItems(1);
+
+        for(int i=0; i<nodes->size(); ++i)
+        {
+            EntityTreeNode * node = nodes->at(i);
+            if(!node->configuration()->isDefault())
+            {
+                EdgeDetectionMethod method;
+                if(node->configuration()->hasSpecificEdgeDetectionMethod())
                 {
-                    // Is part of the silhouette
-                    belongsToModelAndChosen = true;
+                    method = node->configuration()->edgeDetectionMethod();
                 }
-                // Is internal
                 else
                 {
-                    if(foundNode != 0 && foundNode->configuration()->percentageInternalGeneration() != -1)
-                    {
-                        // Use specific configuration
-                        if( modelledChance > 100 - foundNode->configuration()->percentageInternalGeneration() )
-                        {
-                            belongsToModelAndChosen =  true;
-                        }
-                        else
-                        {
-                            belongsToModelAndChosen = false;
-                        }
-                    }
-                    else
-                    {
-                        // Use general configuration
-                        if( modelledChance >= 100 - _globalConfig->modelledStipplingChance() )
-                        {
-                            belongsToModelAndChosen =  true;
-                        }
-                        else
-                        {
-                            belongsToModelAndChosen = false;
-                        }
-                    }
+                    method = _globalConfig->edgeDetectionMethod();
                 }
-            }
-
-            if(externalToModelButChosen || belongsToModelAndChosen)
-            {
-                //out << "Creating dot " << (row+1)*(column+1) << " out of " << imageDithered.rows * imageDithered.cols << endl;
 
-                float posX = float(column * _spriteSize.x / _globalConfig->packingFactor());
-                float posY = float(stippledImageRows - (row * _spriteSize.y / _globalConfig->packingFactor()));
-                StippleDot * dot = new StippleDot(glm::vec2(posX, posY),
-                                              _spriteSize,
-                                              chosenDot);
-                if(isEdgeModel)
+                QByteArray key;
+                if(method != SILHOUETTE)
                 {
-                    if(foundNode != 0)
-                    {
-                        // Use specific configuration
-                        int silhouetteSuffersOffsetChance = rand() % 100;
-                        if(silhouetteSuffersOffsetChance > 100 - foundNode->configuration()->percentageSilhouetteDispersion())
-                        {
-                            dot->setCanHaveOffsetApplied(true);
-                        }
-                        else
-                        {
-                            dot->setCanHaveOffsetApplied(false);
-                        }
-                    }
-                    else
-                    {
-                        // Use general configuration
-                        dot->setCanHaveOffsetApplied(false);
-                    }
+                    key = edgesKey(i, method);
                 }
-                else
+                cv::Mat cached;
+                if(!key.isEmpty() && _intermediateCache->load(key, cached))
                 {
-                    dot->setCanHaveOffsetApplied(true);
+                    node->setEdgeDetection(cached);
+                    stage.addItems(1);
+                    continue;
                 }
 
-                _stipplingDots->add(dot);
+                switch(method)
+                {
+                case SOBEL:
+                    sobelInputs.append(node->solidRendering());
+                    sobelNodes.append(node);
+                    break;
+                case CANNY:
+                    node->setEdgeDetection(cannyEdgeDetection(node->solidRendering(), 50, 150));
+                    computedKeys.append(key);
+                    computedEdges.append(node->edgeDetection());
+                    break;
+                case SILHOUETTE:
+                    node->setEdgeDetection(cv::Mat());
+                    break;
+                }
+                stage.addItems(1);
             }
+        }
+
+        QVector<cv::Mat> sobelMasks = sobelEdgeMasks(sobelInputs);
+        int first = 0;
+        if(globalSobel)
+        {
+            _edgeDetectedSolid3DModel = sobelMasks[0];
+            computedKeys.append(globalKey);
+            computedEdges.append(_edgeDetectedSolid3DModel);
+            first = 1;
+        }
+        for(int i=0; i<sobelNodes.size(); ++i)
+        {
+            sobelNodes[i]->setEdgeDetection(sobelMasks[first + i]);
+            computedKeys.append(edgesKey(nodes->indexOf(sobelNodes[i]), SOBEL));
+            computedEdges.append(sobelMasks[first + i]);
+        }
 
-            float progress = ( 100.0f * ((row*imageDithered.cols)+column+1) / float(imageDithered.rows*imageDithered.cols) );
-            if(int(progress) >= lastProgress+10)
+        for(int i=0; i<computedKeys.size(); ++i)
+        {
+            if(!computedKeys[i].isEmpty())
             {
-                lastProgress += 10;
-                out << "Progress: " << lastProgress << "%" << endl;
+                _intermediateCache->store(computedKeys[i], computedEdges[i]);
+            }
+        }
+
+        if(_debugOutput)
+        {
+            cv::imwrite("debugEdgeGlobalSolid.png", _edgeDetectedSolid3DModel);
+            foreach(EntityTreeNode * node, *nodes)
+            {
+                if(!node->configuration()->isDefault() && !node->edgeDetection().empty())
+                {
+                    cv::imwrite(QString("debugEdgeSpecific" + node->name() + ".png").toStdString(), node->edgeDetection());
+                }
             }
         }
     }
 
+    if(_debugOutput)
+    {
+        out << "Edge detection completed..." << endl;
+        out << "Beginning dot creation..." << endl;
+    }
+
+    glm::vec4 stippledArea = stippledImageArea();
+    int stippledImageRows = stippledArea.w;
+    int stippledImageCols = stippledArea.z;
+
+    if(_debugOutput)
+    {
+        out << "Original image size: " << imageDithered.rows << " x " << imageDithered.cols << " px" <<endl;
+        out << "Stippled image size: " << stippledImageRows << " x " << stippledImageCols << " px" << endl;
+        out << "Packing factor: " << _globalConfig->packingFactor() << endl;
+    }
+
+    int depth = QUADTREE_DEPTH;
+
+    // TODO, choose a depth that is admitted by the size of the stippled image.
+    // The depth should be calculated so that the leaf node's area isn't too big nor too small.
+
+    _stipplingDots = new QuadTree(glm::vec4(0,0,stippledImageCols,stippledImageRows), depth);
+    //out << "_stipplingDots = " << _stipplingDots << endl;
+
+    //out << "QuadTree created with " << _stipplingDots->numberOfNodes() << " nodes and a depth of " << depth << "." << endl;
+    //out << "QuadTree has " << _stipplingDots->numberOfLeaves() << " leaf nodes." << endl;
+    //out << "A leaf node's area is equal to " << stippledImageRows / sqrt(_stipplingDots->numberOfLeaves()) << " x " << stippledImageCols / sqrt(_stipplingDots->numberOfLeaves()) << " px." << endl;
+
+
+    if(_globalConfig->dotPlacement() == WEIGHTED_VORONOI)
+    {
+        generateVoronoiDots(imageDithered, *nodes, _stipplingDots);
+    }
+    else if(_globalConfig->dotPlacement() == POISSON_DISK)
+    {
+        generatePoissonDiskDots(imageDithered, *nodes, _stipplingDots);
+    }
+    else
+    {
+        generateDots(imageDithered, *nodes, cv::Mat(), _stipplingDots);
+    }
+
     nodes->clear();
     delete nodes;
     nodes = 0;
 
-    out << "Finished stippling process." << endl;
+    if(_cancelRequested)
+    {
+        delete _stipplingDots;
+        _stipplingDots = 0;
+
+        if(_debugOutput) out << "Stippling process cancelled." << endl;
+        emit finished();
+        return;
+    }
+
+    if(_debugOutput) out << "Finished stippling process." << endl;
 
     emit finished();
 }
@@ -18,11 +18,29 @@
 #include <opencv2/imgproc/imgproc.hpp>
 
 #include <QObject>
+#include <QElapsedTimer>
+#include <QAtomicInt>
 
 #include "util.h" // NOT REENTRANT
 #include "quadtree.h"
 #include "configuration.h"
 #include "entitytreecontroller.h"
+#include "stageprofiler.h"
+#include "lockfreequeue.h"
+#include "intermediatecache.h"
+#include "spriteatlas.h"
+#include "voronoistippler.h"
+#include "poissondisksampler.h"
+
+/**
+ * @brief Dots generated from a band of rows of the image, handed out while the generation goes on.
+ */
+struct StippleDotBand
+{
+    int firstRow; /**< First row of the image in the band. */
+    int lastRow; /**< Last row of the image in the band (included). */
+    QVector<StippleDot> dots; /**< Copies of the dots, the generated ones belong to the quadtree. */
+};
 
 class DotGenerationWorker : public QObject
 {
@@ -31,14 +49,25 @@ class DotGenerationWorker : public QObject
 public:
     enum DitheringMethod {FLOYD_STEINBERG, STUCKI};
 
+    static const int QUADTREE_DEPTH = 5; /**< Depth of the quadtree the dots are stored in. */
+    static const int BAND_ROWS = 16; /**< Rows of the image in every band handed out progressively. */
+    static const int VORONOI_ITERATIONS = 30; /**< Maximum Lloyd iterations of the WEIGHTED_VORONOI placement. */
+    static const int VORONOI_MAX_PIXELS = 32 * 1024 * 1024; /**< Maximum pixels of the supersampled density of the WEIGHTED_VORONOI placement (128 MB). */
+    static const int POISSON_DISK_ATTEMPTS = 30; /**< Candidates tried around every point by the POISSON_DISK placement. */
+
 protected:
     cv::Mat _toStipple;
     DitheringMethod _ditheringMethod;
     glm::vec2 _spriteSize;
-    glm::vec2 _spritesMatrixSize;
+    int _numberOfSprites;
+    QVector<float> _spriteCoverage; /**< Ink of every sprite, see SpriteAtlas::coverage. */
+    QVector<int> _spritesByCoverage; /**< Sprites leaving some ink, from the lightest to the inkiest. */
 
     QuadTree * _stipplingDots;
 
+    cv::Mat _ditheredImage; /**< Result of the dithering, kept for inspection (shared, not copied). */
+    cv::Mat _toneImage; /**< Smoothed grayscale of the image, for every placement but DITHERED_GRID (empty otherwise). */
+
     cv::Mat _solid3DModel;
     cv::Mat _edgeDetectedSolid3DModel;
 
@@ -46,6 +75,20 @@ protected:
 
     EntityTreeController * _entities;
 
+    bool _debugOutput; /**< Print progress and write the intermediate images to the working directory. */
+
+    StageProfiler * _profiler; /**< Receives the stage measures, if any. Not owned. */
+
+    IntermediateCache * _intermediateCache; /**< Keeps the dithered image and the edge images between runs, if any. Not owned. */
+    QByteArray _sceneKey; /**< Key of the solid renderings, see GLWidget3DEngine::sceneKey. */
+
+    bool _progressiveOutput; /**< Hand out the dots in bands of rows while they are generated. */
+    LockFreeQueue<StippleDotBand> _completedBands;
+
+    QAtomicInt _cancelRequested; /**< Non zero once cancel() is called. */
+
+    Configuration _generationConfig; /**< Copy of the general configuration the dots were generated with. */
+
 
 
 
@@ -54,27 +97,177 @@ protected:
     cv::Mat floydSteinbergDithering(cv::Mat toDither);
     cv::Mat stuckiDithering(cv::Mat toDither);
     cv::Mat sobelEdgeDetection(cv::Mat toDetect, int scale = 1);
+
+    /**
+     * @brief Binary Sobel edge masks of several images: 255 where sobelEdgeDetection would be non zero, 0 elsewhere.
+     * Grayscale conversion and both gradients are fused in a single sweep over bands of rows,
+     * and the bands of every image are processed in parallel.
+     */
+    static QVector<cv::Mat> sobelEdgeMasks(const QVector<cv::Mat> & toDetect);
+
+    /**
+     * @brief Silhouettes of the whole CSG tree: 255 where the owner of a pixel (deepest node whose solid
+     * rendering covers it, if any) differs from the owner of one of its 4 neighbours, 0 elsewhere.
+     */
+    static cv::Mat silhouetteEdgeMask(const QVector<EntityTreeNode*> & nodes);
+
+    /**
+     * @brief True if a pixel and one of its 4 neighbours differ in being covered by a solid rendering.
+     * Used for the nodes with a specific SILHOUETTE method, so they need no edge image.
+     */
+    static bool isCoverageEdge(const cv::Mat & solidRendering, int row, int column);
     cv::Mat cannyEdgeDetection(cv::Mat toDetect, int lowThreshold, int highThreshold);
     cv::Mat thresholding(cv::Mat toThreshold, int threshold = 128, int lower = 0, int higher = 255); // Threshold, lower and higher have to be between 0 and 255.
 
+    /**
+     * @brief Cache key of an edge image.
+     * @param nodeIndex Breadth first position of the node, -1 for the whole CSG tree.
+     * @return The key, empty if there is no cache or no scene key.
+     */
+    QByteArray edgesKey(int nodeIndex, EdgeDetectionMethod method) const;
+
+    /**
+     * @brief Sets the edge image of a node with a non default configuration, according to its edge detection method.
+     */
+    void detectSpecificEdges(EntityTreeNode * node);
+
+    /**
+     * @brief Where a pixel falls in the CSG tree.
+     */
+    struct PixelOwner
+    {
+        EntityTreeNode * node; /**< Deepest node covering the pixel with a non default configuration, 0 if none. */
+        bool modelled; /**< Some node covers the pixel. */
+        bool edge; /**< The pixel is an edge, for the edge detection method of node (or the general one). */
+    };
+
+    PixelOwner pixelOwner(const QVector<EntityTreeNode*> & nodes, int row, int column) const;
+
+    /**
+     * @brief Generates the dots of the pixels of a region and adds them to a tree.
+     * Every pixel draws its own random numbers, so the dots of a pixel are always the same.
+     * @param imageDithered Dithered image.
+     * @param nodes Nodes of the CSG tree, breadth first.
+     * @param region Mask of the pixels to be processed (non zero), empty to process the whole image.
+     * @param dots Tree the dots are added to.
+     * @return Number of dots generated.
+     */
+    qint64 generateDots(const cv::Mat & imageDithered, const QVector<EntityTreeNode*> & nodes,
+                        const cv::Mat & region, QuadTree * dots);
+
+    /**
+     * @brief Ink every pixel should receive from the placements off the grid: its darkness, weighted
+     * by the chance its dots have of being generated (modelled, unmodelled or specific). Edges take
+     * the dithered image instead. CV_32FC1, between 0 and 1.
+     */
+    cv::Mat dotDensity(const cv::Mat & imageDithered, const QVector<EntityTreeNode*> & nodes);
+
+    /**
+     * @brief Ink of an average dot, in pixels of the image (the coverage of its sprite times the cells it spans).
+     */
+    float inkPerDot() const;
+
+    /**
+     * @brief Creates a dot at every point (in pixels of the image) and adds them to a tree.
+     * Sprites follow the darkness around the points, see toneSprite.
+     * @return Number of dots generated.
+     */
+    qint64 addPointDots(const QVector<glm::vec2> & points, const QVector<EntityTreeNode*> & nodes, QuadTree * dots);
+
+    /**
+     * @brief Generates the dots of the whole image by weighted centroidal Voronoi stippling (WEIGHTED_VORONOI).
+     * As many sites as the dot density needs are sampled from it and relaxed with Lloyd iterations.
+     * @return Number of dots generated.
+     */
+    qint64 generateVoronoiDots(const cv::Mat & imageDithered, const QVector<EntityTreeNode*> & nodes, QuadTree * dots);
+
+    /**
+     * @brief Generates the dots of the whole image by Poisson disk sampling (POISSON_DISK).
+     * The radius of the disks gives every pixel the dot density it needs.
+     * @return Number of dots generated.
+     */
+    qint64 generatePoissonDiskDots(const cv::Mat & imageDithered, const QVector<EntityTreeNode*> & nodes, QuadTree * dots);
+
 public:
     DotGenerationWorker(cv::Mat toStipple,
                         DitheringMethod ditheringMethod,
-                        glm::vec2 spriteSize,
-                        glm::vec2 spritesMatrixSize,
+                        const SpriteAtlas & sprites,
                         cv::Mat solid3DModel,
                         Configuration * globalConfig,
                         EntityTreeController * entities);
 
     ~DotGenerationWorker();
 
+    /**
+     * @brief Enables (default) or disables the console progress and the intermediate images.
+     * Concurrent workers must disable it: they would share the console stream and file names.
+     */
+    void setDebugOutput(bool debugOutput);
+
+    /**
+     * @brief Attaches a profiler (0 to detach), which will receive the dithering, edge detection,
+     * ownership lookup, dot creation and quadtree insertion measures.
+     */
+    void setProfiler(StageProfiler * profiler);
+
+    /**
+     * @brief Attaches a cache (0 to detach), where the dithered image is looked up before dithering.
+     * @param sceneKey Key of the solid renderings the worker was given (see GLWidget3DEngine::sceneKey),
+     * under which the edge images are cached. If empty, the edge images are always computed.
+     */
+    void setIntermediateCache(IntermediateCache * cache, const QByteArray & sceneKey);
+
+    /**
+     * @brief Enables or disables (default) handing out the dots in bands of rows while they are
+     * generated, so a viewer can show partial results. See takeCompletedBands.
+     */
+    void setProgressiveOutput(bool progressiveOutput);
+
+    /**
+     * @brief Area (x, y, width, height) of the stippled image, as the root of the quadtree.
+     */
+    glm::vec4 stippledImageArea() const;
+
+    /**
+     * @brief Removes the bands completed since the last call, in generation order (the caller takes their ownership).
+     * Lock free, to be called from the thread that consumes the partial results while process() runs.
+     */
+    QList<StippleDotBand *> takeCompletedBands();
+
+    /**
+     * @brief Asks a running process() to stop as soon as possible. Safe to call from any thread.
+     * The dots generated so far are discarded, so getStipplingDots returns 0 once finished is emitted.
+     */
+    void cancel();
+
+    /**
+     * @brief Dots generated by process(), 0 if it was cancelled. The caller takes their ownership.
+     */
     QuadTree * getStipplingDots();
 
+    /**
+     * @brief Generates again the dots of the pixels covered by a node, after its specific configuration changed.
+     * The dithered image and the other edge images of the last process() call are reused, and the
+     * dots of the remaining pixels are left untouched.
+     * @param node Node whose configuration changed.
+     * @param dots Dots generated by the last process() call. The replaced dots are deleted.
+     * @return False (after printing why) if the dots can not be generated incrementally:
+     * there is no previous process() call, the general configuration changed since, or the
+     * dots were placed by WEIGHTED_VORONOI or POISSON_DISK (which depend on the dots around them).
+     */
+    bool regenerateNode(EntityTreeNode * node, QuadTree * dots);
+
+    /**
+     * @brief Dithered image of the last process() call (empty before it).
+     */
+    cv::Mat ditheredImage() const;
+
 public slots:
     void process();
 
 signals:
     void finished();
+    void progressChanged(int percentage);
     void error(QString err);
 };
 
@@ -0,0 +1,266 @@
+/**
+ * @file dotsetfile.cpp
+ * @brief DotSetFile class source file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#include "dotsetfile.h"
+
+#include <QFile>
+#include <QVector>
+#include <QDomDocument>
+#include <QCryptographicHash>
+
+#include <cstring>
+
+#include "util.h"
+
+static const char DOT_SET_MAGIC[8] = {'S', 'T', 'P', 'L', 'D', 'O', 'T', 'S'};
+static const quint32 BYTE_ORDER_MARK = 0x01020304;
+static const int HASH_SIZE = 20; // SHA-1
+static const quint64 DOT_SIZE = 2 * sizeof(glm::vec2) + sizeof(qint32) + sizeof(quint8); // Bytes of a dot, in all the arrays.
+
+/**
+ * @brief Header of a dot set file, followed by the arrays of dots (the first one at sizeof(FileHeader)).
+ */
+struct FileHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    quint64 dotCount;
+    qint32 imageSize[2];
+    float area[4];
+    float spriteSize[2];
+    quint32 rngSeed;
+    quint32 dispersion;
+    char configurationHash[HASH_SIZE];
+    qint32 matrixSize[2];
+    char reserved[36];
+};
+
+// The layout can only grow through the reserved bytes.
+typedef char FileHeaderSizeCheck[sizeof(FileHeader) == 128 ? 1 : -1];
+
+DotSetInfo::DotSetInfo()
+{
+    imageSize = glm::ivec2(0, 0);
+    area = glm::vec4(0.0f);
+    spriteSize = glm::vec2(0.0f);
+    matrixSize = glm::ivec2(0, 0);
+    rngSeed = 0;
+    dispersion = 0;
+}
+
+QByteArray DotSetFile::configurationHash(const Configuration & configuration)
+{
+    QDomDocument doc;
+    doc.appendChild(configuration.toXML(&doc));
+    return QCryptographicHash::hash(doc.toString().toUtf8(), QCryptographicHash::Sha1);
+}
+
+/**
+ * @brief Writes one array of the dots, leaf by leaf.
+ */
+template <typename T>
+static bool writeArray(QFile & file, const QVector<QVector<StippleDot *> *> & leaves, T (*value)(const StippleDot *))
+{
+    QVector<T> values;
+    foreach(QVector<StippleDot *> * leaf, leaves)
+    {
+        values.resize(leaf->size());
+        for(int i=0; i<leaf->size(); ++i)
+        {
+            values[i] = value(leaf->at(i));
+        }
+
+        qint64 size = qint64(values.size()) * sizeof(T);
+        if(file.write(reinterpret_cast<const char *>(values.constData()), size) != size)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static glm::vec2 dotPosition(const StippleDot * dot)
+{
+    return dot->position();
+}
+
+static glm::vec2 dotOffset(const StippleDot * dot)
+{
+    return dot->offset();
+}
+
+static qint32 dotSprite(const StippleDot * dot)
+{
+    return dot->chosenDot();
+}
+
+static quint8 dotFlags(const StippleDot * dot)
+{
+    return dot->canHaveOffsetApplied() ? DotSetFile::CAN_HAVE_OFFSET_APPLIED : 0;
+}
+
+bool DotSetFile::save(QString fileName, QuadTree * dots, const DotSetInfo & info)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        out << "Error: the dot set file " << fileName << " could not be written." << endl;
+        return false;
+    }
+
+    QVector<QVector<StippleDot *> *> leaves = dots->getDotsInFullArea();
+    quint64 dotCount = 0;
+    foreach(QVector<StippleDot *> * leaf, leaves)
+    {
+        dotCount += leaf->size();
+    }
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DOT_SET_MAGIC, sizeof(DOT_SET_MAGIC));
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.dotCount = dotCount;
+    header.imageSize[0] = info.imageSize.x;
+    header.imageSize[1] = info.imageSize.y;
+    for(int i=0; i<4; ++i)
+    {
+        header.area[i] = info.area[i];
+    }
+    header.spriteSize[0] = info.spriteSize.x;
+    header.spriteSize[1] = info.spriteSize.y;
+    header.matrixSize[0] = info.matrixSize.x;
+    header.matrixSize[1] = info.matrixSize.y;
+    header.rngSeed = info.rngSeed;
+    header.dispersion = info.dispersion;
+    memcpy(header.configurationHash, info.configurationHash.constData(), qMin(info.configurationHash.size(), HASH_SIZE));
+
+    bool written = file.write(reinterpret_cast<const char *>(&header), sizeof(header)) == qint64(sizeof(header)) &&
+                   writeArray(file, leaves, dotPosition) &&
+                   writeArray(file, leaves, dotOffset) &&
+                   writeArray(file, leaves, dotSprite) &&
+                   writeArray(file, leaves, dotFlags);
+    if(!written)
+    {
+        out << "Error: the dot set file " << fileName << " could not be written." << endl;
+        return false;
+    }
+
+    return true;
+}
+
+QuadTree * DotSetFile::load(QString fileName, DotSetInfo & info, int depth)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        out << "Error: the dot set file " << fileName << " could not be opened." << endl;
+        return 0;
+    }
+
+    qint64 size = file.size();
+    uchar * data = (size >= qint64(sizeof(FileHeader))) ? file.map(0, size) : 0;
+    if(data == 0)
+    {
+        out << "Error: " << fileName << " is not a dot set file." << endl;
+        return 0;
+    }
+
+    FileHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    QString error;
+    if(memcmp(header.magic, DOT_SET_MAGIC, sizeof(DOT_SET_MAGIC)) != 0)
+    {
+        error = "is not a dot set file";
+    }
+    else if(header.byteOrder != BYTE_ORDER_MARK)
+    {
+        error = "was written on a machine of a different byte order";
+    }
+    else if(header.version > VERSION)
+    {
+        error = "was written by a newer version";
+    }
+    else if(header.version < VERSION)
+    {
+        error = "was written by an older version";
+    }
+    else if(header.dotCount > quint64(size - sizeof(FileHeader)) / DOT_SIZE ||
+            quint64(size) != sizeof(FileHeader) + header.dotCount * DOT_SIZE)
+    {
+        // The count is checked before multiplying, so a corrupt one can not overflow.
+        error = "is truncated";
+    }
+    else if(header.matrixSize[0] <= 0 || header.matrixSize[1] <= 0)
+    {
+        error = "has no sprite atlas size";
+    }
+    if(!error.isEmpty())
+    {
+        out << "Error: the dot set file " << fileName << " " << error << "." << endl;
+        file.unmap(data);
+        return 0;
+    }
+
+    info.imageSize = glm::ivec2(header.imageSize[0], header.imageSize[1]);
+    info.area = glm::vec4(header.area[0], header.area[1], header.area[2], header.area[3]);
+    info.spriteSize = glm::vec2(header.spriteSize[0], header.spriteSize[1]);
+    info.matrixSize = glm::ivec2(header.matrixSize[0], header.matrixSize[1]);
+    info.rngSeed = header.rngSeed;
+    info.dispersion = header.dispersion;
+    info.configurationHash = QByteArray(header.configurationHash, HASH_SIZE);
+
+    // The arrays are read in place from the mapped pages.
+    quint64 dotCount = header.dotCount;
+    const uchar * section = data + sizeof(FileHeader);
+    const float * positions = reinterpret_cast<const float *>(section);
+    const float * offsets = reinterpret_cast<const float *>(section + dotCount * sizeof(glm::vec2));
+    const qint32 * sprites = reinterpret_cast<const qint32 *>(section + dotCount * 2 * sizeof(glm::vec2));
+    const quint8 * flags = section + dotCount * (2 * sizeof(glm::vec2) + sizeof(qint32));
+
+    // The renderer and the exporters index the sprite atlas with the sprites.
+    qint64 numberOfSprites = qint64(info.matrixSize.x) * info.matrixSize.y;
+    for(quint64 i=0; i<dotCount; ++i)
+    {
+        if(sprites[i] < 0 || sprites[i] >= numberOfSprites)
+        {
+            out << "Error: the dot set file " << fileName << " has a dot with sprite " << sprites[i]
+                << ", out of its " << numberOfSprites << " sprites." << endl;
+            file.unmap(data);
+            return 0;
+        }
+    }
+
+    QuadTree * dots = new QuadTree(info.area, depth);
+    quint64 dropped = 0;
+    for(quint64 i=0; i<dotCount; ++i)
+    {
+        StippleDot * dot = new StippleDot(glm::vec2(positions[2*i], positions[2*i + 1]), info.spriteSize, sprites[i]);
+        dot->setOffset(glm::vec2(offsets[2*i], offsets[2*i + 1]));
+        dot->setCanHaveOffsetApplied((flags[i] & CAN_HAVE_OFFSET_APPLIED) != 0);
+        if(!dots->add(dot))
+        {
+            ++dropped;
+        }
+    }
+
+    file.unmap(data);
+
+    if(dropped != 0)
+    {
+        out << dropped << " dots of the dot set file " << fileName << " are out of its area and were dropped." << endl;
+    }
+
+    return dots;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file dotsetfile.h
+ * @brief DotSetFile class header file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#ifndef DOTSETFILE_H
+#define DOTSETFILE_H
+
+#include <QString>
+#include <QByteArray>
+
+#include <glm/glm.hpp>
+
+#include "quadtree.h"
+#include "configuration.h"
+
+/**
+ * @brief Description of a stored dot set.
+ */
+struct DotSetInfo
+{
+    glm::ivec2 imageSize; /**< Columns and rows of the stippled photograph. */
+    glm::vec4 area; /**< Area of the stippled image, as the root of the quadtree. */
+    glm::vec2 spriteSize; /**< Size of every dot. */
+    glm::ivec2 matrixSize; /**< Columns and rows of the sprite atlas the dots index, see SpriteAtlas::matrixSize. */
+    unsigned int rngSeed; /**< Seed the dots were generated with. */
+    unsigned int dispersion; /**< Dispersion the offsets of the dots were computed with (0 if none). */
+    QByteArray configurationHash; /**< SHA-1 of the configuration the dots were generated with, see DotSetFile::configurationHash. */
+
+    DotSetInfo();
+};
+
+/**
+ * @brief DotSetFile class.
+ * Binary file format of a whole dot set, so that stippling results can be reopened later or
+ * rendered by another process. A fixed size header (see DotSetInfo) is followed by the dots as
+ * separate arrays: positions, offsets (pairs of floats), sprite indices (32 bit integers) and
+ * flags (one byte). The file is memory mapped to be read, and holds the numbers in the byte
+ * order of the machine that wrote it (files of the other order are refused).
+ * Non instantiable class.
+ */
+class DotSetFile
+{
+private:
+    DotSetFile();
+
+public:
+    static const quint32 VERSION = 2; /**< Version written. Other versions are refused. */
+
+    enum Flag { CAN_HAVE_OFFSET_APPLIED = 0x01 };
+
+    /**
+     * @brief Hash identifying a configuration (SHA-1 of its XML).
+     */
+    static QByteArray configurationHash(const Configuration & configuration);
+
+    /**
+     * @brief Writes a dot set.
+     * @return False (after printing why) if the file could not be written.
+     */
+    static bool save(QString fileName, QuadTree * dots, const DotSetInfo & info);
+
+    /**
+     * @brief Reads a dot set.
+     * @param info Receives the description of the dot set.
+     * @param depth Depth of the quadtree the dots are added to.
+     * Dots moved out of the area by their offset are kept, see QuadTree::add.
+     * @return The dots (the caller takes their ownership), or 0 (after printing why) if the file
+     * could not be read or is not a valid dot set (including sprites out of its sprite atlas).
+     */
+    static QuadTree * load(QString fileName, DotSetInfo & info, int depth);
+};
+
+#endif // DOTSETFILE_H
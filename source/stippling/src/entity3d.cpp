@@ -12,190 +12,201 @@
 
 #include "entity3d.h"
 
-void Entity3D::generateLines(int nVertices, float * vertices, int nFaces,
-                             std::vector<unsigned int> * nVerticesPerFace, unsigned int ** faces)
+void Entity3D::generateLines(const IndexedMesh & indexedMesh)
 {
-    deleteLines();
+    _lineVertices.assign(indexedMesh.vertices.begin(), indexedMesh.vertices.end());
+    _lineIndices.assign(indexedMesh.edges.begin(), indexedMesh.edges.end());
+}
 
-    int sumLines = 0;
-    for(int f=0; f<nFaces; ++f)
-    {
-        sumLines += nVerticesPerFace->at(f);
-    }
+void Entity3D::generateTriangles(const IndexedMesh & indexedMesh)
+{
+    const std::vector<float> & vertices = indexedMesh.vertices;
+    int nMeshVertices = vertices.size() / 3;
+    int nTriangles = indexedMesh.triangles.size() / 3;
 
-    lines_NumberOfLines = sumLines;
-    lines_NumberOfVertices = 2 * lines_NumberOfLines;
-    lines_NumberOfValues = 3 * lines_NumberOfVertices;
+    _solidVertices.clear();
+    _solidNormals.clear();
+    _solidIndices.clear();
+    _solidIndices.reserve(indexedMesh.triangles.size());
 
-    lines = new GLfloat[lines_NumberOfValues];
+    // Vertices are only shared among the triangles of the same facet. The triangles of a facet are
+    // consecutive, so remembering the last facet that used each mesh vertex is enough.
+    std::vector<int> lastFacet(nMeshVertices, -1);
+    std::vector<GLuint> solidIndex(nMeshVertices, 0);
 
-    int index = 0;
+    int currentFacet = -1;
+    glm::vec3 normal;
 
-    for(int f=0; f<nFaces; ++f)
+    for(int t=0; t<nTriangles; ++t)
     {
-        for(int vf=0; vf< int(nVerticesPerFace->at(f)); ++vf)
+        if(int(indexedMesh.facets[t]) != currentFacet)
         {
-            int origin = faces[f][vf];
-            int destiny = faces[f][Util::mod(vf+1,nVerticesPerFace->at(f))];
-
-            lines[index] = vertices[(3*origin)+0];
-            ++index;
-            lines[index] = vertices[(3*origin)+1];
-            ++index;
-            lines[index] = vertices[(3*origin)+2];
-            ++index;
-
-            lines[index] = vertices[(3*destiny)+0];
-            ++index;
-            lines[index] = vertices[(3*destiny)+1];
-            ++index;
-            lines[index] = vertices[(3*destiny)+2];
-            ++index;
-        }
-    }
-}
+            currentFacet = indexedMesh.facets[t];
 
-void Entity3D::deleteLines()
-{
-    if(lines != 0)
-    {
-        delete[] lines;
-        lines = 0;
-    }
-}
+            // Calculate the face normal
+            int vertex = indexedMesh.triangles[(3*t)+0];
+            glm::vec3 vertex1 = glm::vec3(vertices[(3*vertex)+0], vertices[(3*vertex)+1], vertices[(3*vertex)+2]);
+            vertex = indexedMesh.triangles[(3*t)+1];
+            glm::vec3 vertex2 = glm::vec3(vertices[(3*vertex)+0], vertices[(3*vertex)+1], vertices[(3*vertex)+2]);
+            vertex = indexedMesh.triangles[(3*t)+2];
+            glm::vec3 vertex3 = glm::vec3(vertices[(3*vertex)+0], vertices[(3*vertex)+1], vertices[(3*vertex)+2]);
 
-void Entity3D::generateTriangles(int nVertices, float * vertices, int nFaces,
-                             std::vector<unsigned int> * nVerticesPerFace, unsigned int ** faces)
-{
-    deleteTriangles();
+            glm::vec3 vector1 = glm::normalize(vertex2 - vertex1);
+            glm::vec3 vector2 = glm::normalize(vertex3 - vertex1);
 
-    // Check that all faces are triangles
-    // TODO Make sure that CGAL always returns triangles and remove this check
-    for(int f=0; f<nFaces; ++f)
-    {
-        if(nVerticesPerFace->at(f) != 3)
-        {
-            out << "Error on " << _name << " - Cannot generate triangles because a face is not triangular." << endl;
+            normal = glm::normalize(glm::cross(vector1, vector2));
+
+            // Correct the normal if the winding is not CCW.
+            // Thanks to Dirk Bartz (University of Thuebingen) for the method.
+            // (http://www.graphicsgroups.com/6-opengl/f0097cc7d778fbc2.htm)
+            glm::mat3x3 vertexMatrix;
+            vertexMatrix[0] = vertex1;
+            vertexMatrix[1] = vertex2;
+            vertexMatrix[2] = vertex3;
+            float det = glm::determinant(vertexMatrix);
 
-            triangles_NumberOfValues = 0;
-            return;
+
+            if(det < 0)
+            {
+                // Clockwise winding
+                normal = -normal;
+            }
+            else
+            {
+                // Counter-clockwise winding
+            }
         }
-    }
 
-    triangles_NumberOfTriangles = nFaces;
-    triangles_NumberOfVertices = 3 * triangles_NumberOfTriangles;
-    triangles_NumberOfValues = 3 * triangles_NumberOfVertices;
+        for(int vt=0; vt<3; ++vt)
+        {
+            int vertex = indexedMesh.triangles[(3*t)+vt];
 
-    triangles = new GLfloat[triangles_NumberOfValues];
+            if(lastFacet[vertex] != currentFacet)
+            {
+                // First use of this vertex on the facet
+                lastFacet[vertex] = currentFacet;
+                solidIndex[vertex] = _solidVertices.size() / 3;
 
-    int index = 0;
+                _solidVertices.push_back(vertices[(3*vertex)+0]);
+                _solidVertices.push_back(vertices[(3*vertex)+1]);
+                _solidVertices.push_back(vertices[(3*vertex)+2]);
 
-    for(int f=0; f<nFaces; ++f)
-    {
-        for(int vf=0; vf< int(nVerticesPerFace->at(f)); ++vf)
-        {
-            int vertex = faces[f][vf];
-
-            triangles[index] = vertices[(3*vertex)+0];
-            ++index;
-            triangles[index] = vertices[(3*vertex)+1];
-            ++index;
-            triangles[index] = vertices[(3*vertex)+2];
-            ++index;
+                _solidNormals.push_back(normal.x);
+                _solidNormals.push_back(normal.y);
+                _solidNormals.push_back(normal.z);
+            }
+
+            _solidIndices.push_back(solidIndex[vertex]);
         }
     }
 }
 
-void Entity3D::deleteTriangles()
+void Entity3D::clearGeometry()
 {
-    if(triangles != 0)
-    {
-        delete[] triangles;
-        triangles = 0;
-    }
+    _lineVertices.clear();
+    _lineIndices.clear();
+    _solidVertices.clear();
+    _solidNormals.clear();
+    _solidIndices.clear();
+}
+
+void Entity3D::generateGeometryFromMesh()
+{
+    IndexedMesh indexedMesh;
+    _mesh.indexedCache(indexedMesh);
+
+    generateLines(indexedMesh);
+    generateTriangles(indexedMesh);
 }
 
-void Entity3D::generateNormals(int nVertices, float * vertices, int nFaces, std::vector<unsigned int> * nVerticesPerFace,
-                     unsigned int ** faces)
+void Entity3D::generateGeometryFromPolygons()
 {
-    deleteNormals();
+    IndexedMesh indexedMesh;
+    indexedMesh.vertices = _primitiveVertices;
 
-    // Check that all faces are triangles
-    // TODO Make sure that CGAL always returns triangles and remove this check
-    for(int f=0; f<nFaces; ++f)
+    for(int p=0; p<int(_primitivePolygons.size()); ++p)
     {
-        if(nVerticesPerFace->at(f) != 3)
+        const std::vector<unsigned int> & polygon = _primitivePolygons[p];
+        int n = polygon.size();
+
+        // Convex polygons, a fan is enough
+        for(int i=1; i<n-1; ++i)
         {
-            out << "Error on " << _name << " - Cannot generate normals because a face is not triangular." << endl;
+            indexedMesh.triangles.push_back(polygon[0]);
+            indexedMesh.triangles.push_back(polygon[i]);
+            indexedMesh.triangles.push_back(polygon[i+1]);
+            indexedMesh.facets.push_back(p);
+        }
 
-            triangles_NumberOfValues = 0;
-            return;
+        // On a closed surface every edge is shared by two polygons walking it in opposite
+        // directions, so keeping only one direction lists each edge once
+        for(int i=0; i<n; ++i)
+        {
+            unsigned int origin = polygon[i];
+            unsigned int destiny = polygon[(i+1)%n];
+            if(origin < destiny)
+            {
+                indexedMesh.edges.push_back(origin);
+                indexedMesh.edges.push_back(destiny);
+            }
         }
     }
 
-    triangles_NumberOfTriangles = nFaces;
-    triangles_NumberOfVertices = 3 * triangles_NumberOfTriangles;
-    triangles_NumberOfValues = 3 * triangles_NumberOfVertices;
+    generateLines(indexedMesh);
+    generateTriangles(indexedMesh);
 
-    normals = new GLfloat[triangles_NumberOfValues];
+    _meshOutdated = true;
+}
 
-    int index = 0;
+void Entity3D::buildMeshFromPolygons()
+{
+    Surface surface;
 
-    for(int f=0; f<nFaces; ++f)
+    for(int v=0; v<int(_primitiveVertices.size()); v+=3)
     {
-        // Calculate the face normal
-        int vertex = faces[f][0];
-        glm::vec3 vertex1 = glm::vec3(vertices[(3*vertex)+0], vertices[(3*vertex)+1], vertices[(3*vertex)+2]);
-        vertex = faces[f][1];
-        glm::vec3 vertex2 = glm::vec3(vertices[(3*vertex)+0], vertices[(3*vertex)+1], vertices[(3*vertex)+2]);
-        vertex = faces[f][2];
-        glm::vec3 vertex3 = glm::vec3(vertices[(3*vertex)+0], vertices[(3*vertex)+1], vertices[(3*vertex)+2]);
-
-        glm::vec3 vector1 = glm::normalize(vertex2 - vertex1);
-        glm::vec3 vector2 = glm::normalize(vertex3 - vertex1);
-
-        glm::vec3 normal = glm::normalize(glm::cross(vector1, vector2));
-
-        // Correct the normal if the winding is not CCW.
-        // Thanks to Dirk Bartz (University of Thuebingen) for the method.
-        // (http://www.graphicsgroups.com/6-opengl/f0097cc7d778fbc2.htm)
-        glm::mat3x3 vertexMatrix;
-        vertexMatrix[0] = vertex1;
-        vertexMatrix[1] = vertex2;
-        vertexMatrix[2] = vertex3;
-        float det = glm::determinant(vertexMatrix);
-
-
-        if(det < 0)
-        {
-            // Clockwise winding
-            normal = -normal;
-        }
-        else
-        {
-            // Counter-clockwise winding
-        }
+        surface.addVertex(_primitiveVertices[v], _primitiveVertices[v+1], _primitiveVertices[v+2]);
+    }
 
-        for(int vf=0; vf< int(nVerticesPerFace->at(f)); ++vf)
+    // CGAL is fed triangles: polygons built from float coordinates may not be exactly planar
+    std::vector<unsigned int> face(3);
+    for(int p=0; p<int(_primitivePolygons.size()); ++p)
+    {
+        const std::vector<unsigned int> & polygon = _primitivePolygons[p];
+        for(int i=1; i<int(polygon.size())-1; ++i)
         {
-            // Assign the calculated face normal to each face vertex
-            normals[index] = normal.x;
-            ++index;
-            normals[index] = normal.y;
-            ++index;
-            normals[index] = normal.z;
-            ++index;
+            face[0] = polygon[0];
+            face[1] = polygon[i];
+            face[2] = polygon[i+1];
+            surface.addFace(face);
         }
     }
+
+    // create polyhedron from surface
+    _mesh.clearCache();
+    _mesh.addSurface(surface);
+    _mesh.flushCache();
+
+    //_mesh.saveOFFMesh( QString("debug " + name() + ".off").toStdString() );
+
+    _meshOutdated = false;
 }
 
-void Entity3D::deleteNormals()
+void Entity3D::initializeGLEntities(const GLuint renderShader, const GLuint selectionShader)
 {
-    if(normals != 0)
-    {
-        delete[] normals;
-        normals = 0;
-    }
+    _wireframe.initializeIndexed(0, 0, 0, 0, 0, _color, GL_LINES, GL_DYNAMIC_DRAW, renderShader, selectionShader);
+    _solid.initializeIndexed(0, 0, 0, 0, 0, _color, GL_TRIANGLES, GL_DYNAMIC_DRAW, renderShader, selectionShader);
+
+    updateGLEntities();
+}
+
+void Entity3D::updateGLEntities()
+{
+    _wireframe.setIndexedData(_lineVertices.empty() ? 0 : &_lineVertices[0], 0, _lineVertices.size(),
+                              _lineIndices.empty() ? 0 : &_lineIndices[0], _lineIndices.size());
+
+    _solid.setIndexedData(_solidVertices.empty() ? 0 : &_solidVertices[0],
+                          _solidNormals.empty() ? 0 : &_solidNormals[0], _solidVertices.size(),
+                          _solidIndices.empty() ? 0 : &_solidIndices[0], _solidIndices.size());
 }
 
 void Entity3D::add(ControlPoint* cp)
@@ -216,16 +227,12 @@ Entity3D::Entity3D()
 	_isOperation = false;
 	_operation = 0;
 
-    lines = 0;
-    triangles = 0;
-    normals = 0;
+    _meshOutdated = false;
 }
 
 Entity3D::~Entity3D()
 {
-    deleteLines();
-    deleteTriangles();
-    deleteNormals();
+
 }
 
 Entity3D::Entity3D(IDManager * idManager)
@@ -235,9 +242,7 @@ Entity3D::Entity3D(IDManager * idManager)
     _visible = true;
     _paintMode = ANY_CP;
     _model = glm::mat4(1.0f);
-    lines = 0;
-    triangles = 0;
-    normals = 0;
+    _meshOutdated = false;
 }
 
 int Entity3D::id() const
@@ -285,6 +290,11 @@ unsigned int Entity3D::operation() const
 
 BoolMesh Entity3D::mesh()
 {
+    if(_meshOutdated)
+    {
+        buildMeshFromPolygons();
+    }
+
     BoolMesh copy = _mesh;
     return copy;
 }
@@ -662,12 +672,17 @@ void Entity3D::interact(int id, glm::vec3 worldCoords)
     if(mustRecalculate)
     {
         recalculateGeometry();
-        _wireframe.setVertexData(0, lines_NumberOfValues, lines);
-        _solid.setVertexData(0, triangles_NumberOfValues, triangles);
+        updateGLEntities();
     }
 }
 
-void Entity3D::updateGeometry()
+bool Entity3D::updateLevelOfDetail(const glm::mat4 * view, const glm::mat4 * projection,
+                                   int viewportHeight, LevelOfDetail levelOfDetail)
+{
+    return false;
+}
+
+void Entity3D::updateGeometry(const bool propagateToParent)
 {
 
 }
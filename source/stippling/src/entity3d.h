@@ -23,6 +23,8 @@
 #include <QVector>
 #include <QSet>
 
+#include <algorithm>
+
 #include "idmanager.h"
 #include "controlpoint.h"
 #include "enums.h"
@@ -56,17 +58,21 @@ protected:
 
     ControlPoint _position;
 
-    int lines_NumberOfLines;
-    int lines_NumberOfVertices;
-    int lines_NumberOfValues;
-    GLfloat * lines;
+    // Indexed geometry. The wireframe shares the mesh vertices and draws every edge once, the solid
+    // shares vertices only inside each facet so that every facet keeps its own (flat) normal.
+    std::vector<GLfloat> _lineVertices;
+    std::vector<GLuint> _lineIndices;
 
-    int triangles_NumberOfTriangles;
-    int triangles_NumberOfVertices;
-    int triangles_NumberOfValues;
-    GLfloat * triangles;
+    std::vector<GLfloat> _solidVertices;
+    std::vector<GLfloat> _solidNormals;
+    std::vector<GLuint> _solidIndices;
 
-    GLfloat * normals;
+    // Analytic description of a primitive: its vertices (3 values each) and its convex polygons (CCW
+    // seen from outside). Primitives are rendered straight from it; the CGAL mesh, which is only
+    // needed by the operations, is built from it on demand.
+    std::vector<float> _primitiveVertices;
+    std::vector< std::vector<unsigned int> > _primitivePolygons;
+    bool _meshOutdated; /**< Whether _mesh has to be rebuilt from the primitive's polygons before being used. */
 
     BoolMesh _mesh;
     // TODO Refactor so that the _type is used instead of this member, then get rid of it.
@@ -76,20 +82,39 @@ protected:
     virtual void recalculateGeometry() = 0;
     virtual void interactSpecifically(ControlPoint * cp) = 0;
 
-    void generateLines(int nVertices, float * vertices, int nFaces, std::vector<unsigned int> * nVerticesPerFace,
-                       unsigned int ** faces);
+    void generateLines(const IndexedMesh & indexedMesh);
+
+    void generateTriangles(const IndexedMesh & indexedMesh);
+
+    void clearGeometry();
 
-    void deleteLines();
+    /**
+     * @brief Regenerates the lines, triangles and normals from the current CGAL mesh.
+     */
+    void generateGeometryFromMesh();
 
-    void generateTriangles(int nVertices, float * vertices, int nFaces, std::vector<unsigned int> * nVerticesPerFace,
-                       unsigned int ** faces);
+    /**
+     * @brief Regenerates the lines, triangles and normals from the primitive's polygons, without CGAL.
+     * The CGAL mesh is marked as outdated.
+     */
+    void generateGeometryFromPolygons();
 
-    void deleteTriangles();
+    /**
+     * @brief Builds the CGAL mesh from the primitive's polygons.
+     */
+    void buildMeshFromPolygons();
 
-    void generateNormals(int nVertices, float * vertices, int nFaces, std::vector<unsigned int> * nVerticesPerFace,
-                         unsigned int ** faces);
+    /**
+     * @brief Initializes the wireframe and solid GLEntities with the current indexed geometry.
+     * @param renderShader Shader used to render both representations.
+     * @param selectionShader Shader used to render in the selection process.
+     */
+    void initializeGLEntities(const GLuint renderShader, const GLuint selectionShader);
 
-    void deleteNormals();
+    /**
+     * @brief Uploads the current indexed geometry to the already initialized GLEntities (their VAOs and buffers are reused).
+     */
+    void updateGLEntities();
 
     void add(ControlPoint* cp);
 
@@ -141,7 +166,18 @@ public:
 
     void paintOnDifferentGLContext(const glm::mat4 * view, const glm::mat4 * projection) const;
 
-    virtual void updateGeometry();
+    /**
+     * @brief Adapts the tessellation of curved entities to their size once projected.
+     * @param view View matrix of the camera used to project the entity.
+     * @param projection Projection matrix of the camera used to project the entity.
+     * @param viewportHeight Height (in pixels) of the image the entity is projected into.
+     * @param levelOfDetail COARSE_LOD while interacting, FINE_LOD for the final renderings.
+     * @return Whether the geometry changed (the operations using the entity have to be updated).
+     */
+    virtual bool updateLevelOfDetail(const glm::mat4 * view, const glm::mat4 * projection,
+                                     int viewportHeight, LevelOfDetail levelOfDetail);
+
+    virtual void updateGeometry(const bool propagateToParent = true);
 
     void requestParentUpdate();
 
@@ -454,3 +454,8 @@ void EntityTreeController::emitModifiedInformation()
     emit modifiedInformation();
 }
 
+void EntityTreeController::emitModifiedConfiguration(EntityTreeNode * node)
+{
+    emit modifiedConfiguration(node);
+}
+
@@ -69,10 +69,12 @@ public:
     void correctEntityPositions();
 
     void emitModifiedInformation();
+    void emitModifiedConfiguration(EntityTreeNode * node);
 
 signals:
     void modifiedTree();
     void modifiedInformation();
+    void modifiedConfiguration(EntityTreeNode * node); /**< The specific configuration of a node was changed. */
 };
 
 #endif // ENTITYTREECONTROLLER_H
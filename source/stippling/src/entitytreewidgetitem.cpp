@@ -188,10 +188,20 @@ void EntityTreeWidgetItem::openSpecificConfigurationDialog()
     configDialog = new SpecificEntityConfigurationDialog();
     configDialog->loadConfiguration(_node->configuration());
 
+    connect(configDialog, SIGNAL(accepted()), this, SLOT(processConfigurationEdition()));
+
     configDialog->show();
     configDialog->activateWindow();
 }
 
+void EntityTreeWidgetItem::processConfigurationEdition()
+{
+    if(_controller != 0)
+    {
+        _controller->emitModifiedConfiguration(_node);
+    }
+}
+
 void EntityTreeWidgetItem::processCPVisibilityEdition(QString choice)
 {
     PaintMode mode;
@@ -45,6 +45,7 @@ public slots:
     void processNameEdition(QString name);
     void processVisibilityEdition(bool visible);
     void openSpecificConfigurationDialog();
+    void processConfigurationEdition();
     void processCPVisibilityEdition(QString choice);
     void processTypeEdition(QString choice);
 };
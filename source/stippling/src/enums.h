@@ -20,5 +20,6 @@ enum PaintMode { ENTITY, TRANSLATION, RESIZE, ROTATION, SCALE, ANY_CP };
 enum EntitiesRenderMode {WIREFRAME, DARK_SOLID, ILLUMINATED_SOLID, CPS_ONLY};
 enum FloorRenderMode { GRID, SOLID, GRID_SOLID, NO_FLOOR };
 enum EntityType { ABSTRACT, ROOT, OPERATION, CYLINDER, PRISM };
+enum LevelOfDetail { COARSE_LOD, FINE_LOD };
 
 #endif // ENUMS_H
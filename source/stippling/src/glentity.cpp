@@ -12,6 +12,8 @@
 
 #include "glentity.h"
 
+#include <algorithm>
+
 QString GLEntity::checkGLError()
 {
     QString str = "";
@@ -91,18 +93,35 @@ void GLEntity::delete_colorMPBuffer()
     }
 }
 
+void GLEntity::delete_indexMPBuffer()
+{
+    if(_indexMPBuffer != 0)
+    {
+        delete[] _indexMPBuffer;
+        _indexMPBuffer = 0;
+    }
+}
+
 GLEntity::GLEntity()
 {
     _id = -1;
     _model = glm::mat4(1.0f);
     _bufferSize = 0;
+    _numberOfIndices = 0;
+    _indexed = false;
+    _bufferCapacity = 0;
+    _indexCapacity = 0;
+    _useUniformColor = false;
 
     initialized = false;
     _vertexArrayID = 0;
+    _uvBuffer = 0;
+    _indexBuffer = 0;
 
     _vertexMPBuffer = 0;
     _normalMPBuffer = 0;
     _colorMPBuffer = 0;
+    _indexMPBuffer = 0;
 }
 
 GLEntity::GLEntity(int id, glm::vec3 selectionColor)
@@ -111,13 +130,21 @@ GLEntity::GLEntity(int id, glm::vec3 selectionColor)
     _selectionColor = glm::vec3(selectionColor);
     _model = glm::mat4(1.0f);
     _bufferSize = 0;
+    _numberOfIndices = 0;
+    _indexed = false;
+    _bufferCapacity = 0;
+    _indexCapacity = 0;
+    _useUniformColor = false;
 
     initialized = false;
     _vertexArrayID = 0;
+    _uvBuffer = 0;
+    _indexBuffer = 0;
 
     _vertexMPBuffer = 0;
     _normalMPBuffer = 0;
     _colorMPBuffer = 0;
+    _indexMPBuffer = 0;
 }
 
 GLEntity::~GLEntity()
@@ -184,6 +211,9 @@ void GLEntity::initialize(const GLfloat vertexBufferData[], const GLfloat colorB
     resetModel();
 
     _bufferSize = bufferSize;
+    _numberOfIndices = 0;
+    _indexed = false;
+    _useUniformColor = false;
     _glType = glType;
     _valuesPerVertex = valuesPerVertex;
 
@@ -293,10 +323,146 @@ void GLEntity::initialize(const GLfloat vertexBufferData[], const GLfloat colorB
     initialized = true;
 }
 
+void GLEntity::initializeIndexed(const GLfloat vertexBufferData[], const GLfloat normalBufferData[],
+                                 const int bufferSize, const GLuint indexBufferData[],
+                                 const int numberOfIndices, glm::vec3 color, GLuint glType, GLenum usage,
+                                 GLuint renderShader, GLuint selectionShader)
+{
+    resetModel();
+
+    _indexed = true;
+    _glType = glType;
+    _valuesPerVertex = 3;
+    _usage = usage;
+    _bufferSize = 0;
+    _numberOfIndices = 0;
+    _bufferCapacity = 0;
+    _indexCapacity = 0;
+
+    // The color is passed as a uniform, so no per-vertex color buffer is needed
+    _useUniformColor = true;
+    _uniformColor = color;
+    _colorBuffer = 0;
+
+    // Indexed entities are never textured
+    _uvBuffer = 0;
+
+    glGenVertexArrays(1, &_vertexArrayID);
+    glBindVertexArray(_vertexArrayID);
+
+    // 1rst attribute buffer : vertices
+    glGenBuffers(1, &_vertexBuffer);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+    // 2nd attribute buffer : normal (lines are never lit)
+    _normalBuffer = 0;
+    if(_glType != GL_LINES)
+    {
+        glGenBuffers(1, &_normalBuffer);
+        glEnableVertexAttribArray(1);
+        glBindBuffer(GL_ARRAY_BUFFER, _normalBuffer);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    }
+
+    // The element array binding is part of the VAO state
+    glGenBuffers(1, &_indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
+
+    glBindVertexArray(0);
+
+    _renderShader = renderShader;
+    _selectionShader = selectionShader;
+
+    delete_vertexMPBuffer();
+    delete_normalMPBuffer();
+    delete_colorMPBuffer();
+    delete_indexMPBuffer();
+
+    initialized = true;
+
+    setIndexedData(vertexBufferData, normalBufferData, bufferSize, indexBufferData, numberOfIndices);
+}
+
+void GLEntity::setIndexedData(const GLfloat * vertexBufferData, const GLfloat * normalBufferData,
+                              const int bufferSize, const GLuint * indexBufferData, const int numberOfIndices)
+{
+    if(!initialized || !_indexed)
+    {
+        return;
+    }
+
+    bool hasNormals = (_normalBuffer != 0);
+
+    // The GPU buffers (and their MP copies) only grow, with some slack so that a CSG tree being
+    // edited doesn't reallocate on every small change.
+    if(bufferSize > _bufferCapacity)
+    {
+        _bufferCapacity = (_bufferCapacity == 0) ? bufferSize : std::max(bufferSize, _bufferCapacity + _bufferCapacity/2);
+
+        delete_vertexMPBuffer();
+        _vertexMPBuffer = new GLfloat[_bufferCapacity];
+
+        if(hasNormals)
+        {
+            delete_normalMPBuffer();
+            _normalMPBuffer = new GLfloat[_bufferCapacity];
+        }
+    }
+    if(numberOfIndices > _indexCapacity)
+    {
+        _indexCapacity = (_indexCapacity == 0) ? numberOfIndices : std::max(numberOfIndices, _indexCapacity + _indexCapacity/2);
+
+        delete_indexMPBuffer();
+        _indexMPBuffer = new GLuint[_indexCapacity];
+    }
+
+    _bufferSize = bufferSize;
+    _numberOfIndices = numberOfIndices;
+
+    // Orphan the previous data stores before filling them, so the driver doesn't have to wait for
+    // the draws that may still be using them.
+    glBindVertexArray(_vertexArrayID);
+
+    glBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat)*_bufferCapacity, 0, _usage);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(GLfloat)*_bufferSize, vertexBufferData);
+
+    if(hasNormals)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, _normalBuffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat)*_bufferCapacity, 0, _usage);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(GLfloat)*_bufferSize, normalBufferData);
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint)*_indexCapacity, 0, _usage);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(GLuint)*_numberOfIndices, indexBufferData);
+
+    glBindVertexArray(0);
+
+    for(int i=0; i<_bufferSize; ++i)
+    {
+        _vertexMPBuffer[i] = vertexBufferData[i];
+    }
+    if(hasNormals)
+    {
+        for(int i=0; i<_bufferSize; ++i)
+        {
+            _normalMPBuffer[i] = normalBufferData[i];
+        }
+    }
+    for(int i=0; i<_numberOfIndices; ++i)
+    {
+        _indexMPBuffer[i] = indexBufferData[i];
+    }
+}
+
 void GLEntity::paint(SelectionMode selectionMode, const glm::mat4 * view, const glm::mat4 * projection,
                      const glm::mat4 * extModel, GLuint texture, GLfloat xLeft, GLfloat xRight,
                      GLfloat yBottom, GLfloat yTop, GLfloat zNear, GLfloat zFar,
-                     bool drawStippledLines, bool illuminated) const
+                     bool drawStippledLines, bool illuminated, int instances) const
 {
     glm::mat4 identity = glm::mat4(1.0f);
     if(extModel == 0)
@@ -333,6 +499,8 @@ void GLEntity::paint(SelectionMode selectionMode, const glm::mat4 * view, const
         GLuint yTopID = glGetUniformLocation(usingShader, "yTop");
         GLuint zNearID = glGetUniformLocation(usingShader, "zNear");
         GLuint zFarID = glGetUniformLocation(usingShader, "zFar");
+        GLuint useUniformColorID = glGetUniformLocation(usingShader, "useUniformColor");
+        GLuint uniformColorID = glGetUniformLocation(usingShader, "uniformColor");
 
         // Use our shader
         glUseProgram(usingShader);
@@ -354,6 +522,8 @@ void GLEntity::paint(SelectionMode selectionMode, const glm::mat4 * view, const
         glUniform1f(yTopID, yTop);
         glUniform1f(zNearID, zNear);
         glUniform1f(zFarID, zFar);
+        glUniform1i(useUniformColorID, _useUniformColor ? 1 : 0);
+        glUniform3f(uniformColorID, _uniformColor.r, _uniformColor.g, _uniformColor.b);
 
         int previousWidth;
         glGetIntegerv(GL_LINE_WIDTH, &previousWidth);
@@ -370,7 +540,28 @@ void GLEntity::paint(SelectionMode selectionMode, const glm::mat4 * view, const
 
         // Draw using the VAO (Vertex Array Object) data
         glBindVertexArray(_vertexArrayID);
-        glDrawArrays(_glType, 0, (int)(_bufferSize/_valuesPerVertex));
+        if(_indexed)
+        {
+            if(instances == 1)
+            {
+                glDrawElements(_glType, _numberOfIndices, GL_UNSIGNED_INT, (void*)0);
+            }
+            else
+            {
+                glDrawElementsInstanced(_glType, _numberOfIndices, GL_UNSIGNED_INT, (void*)0, instances);
+            }
+        }
+        else
+        {
+            if(instances == 1)
+            {
+                glDrawArrays(_glType, 0, (int)(_bufferSize/_valuesPerVertex));
+            }
+            else
+            {
+                glDrawArraysInstanced(_glType, 0, (int)(_bufferSize/_valuesPerVertex), instances);
+            }
+        }
 
         if(_glType == GL_LINES)
         {
@@ -402,14 +593,32 @@ void GLEntity::paint(SelectionMode selectionMode, const glm::mat4 * view, const
 
         glBegin(_glType);
 
-        for(int i=0; i<(int)(_bufferSize); i+=_valuesPerVertex)
+        if(_indexed)
+        {
+            glColor3f(_uniformColor.r, _uniformColor.g, _uniformColor.b);
+
+            for(int index=0; index<_numberOfIndices; ++index)
+            {
+                int i = _valuesPerVertex * _indexMPBuffer[index];
+
+                if(_glType != GL_LINES)
+                {
+                    glNormal3f(_normalMPBuffer[i], _normalMPBuffer[i+1], _normalMPBuffer[i+2]);
+                }
+                glVertex3f(_vertexMPBuffer[i], _vertexMPBuffer[i+1], _vertexMPBuffer[i+2]);
+            }
+        }
+        else
         {
-            glColor3f(_colorMPBuffer[i], _colorMPBuffer[i+1], _colorMPBuffer[i+2]);
-            if(_glType != GL_LINES)
+            for(int i=0; i<(int)(_bufferSize); i+=_valuesPerVertex)
             {
-                glNormal3f(_normalMPBuffer[i], _normalMPBuffer[i+1], _normalMPBuffer[i+2]);
+                glColor3f(_colorMPBuffer[i], _colorMPBuffer[i+1], _colorMPBuffer[i+2]);
+                if(_glType != GL_LINES)
+                {
+                    glNormal3f(_normalMPBuffer[i], _normalMPBuffer[i+1], _normalMPBuffer[i+2]);
+                }
+                glVertex3f(_vertexMPBuffer[i], _vertexMPBuffer[i+1], _vertexMPBuffer[i+2]);
             }
-            glVertex3f(_vertexMPBuffer[i], _vertexMPBuffer[i+1], _vertexMPBuffer[i+2]);
         }
 
         glEnd();
@@ -471,9 +680,30 @@ void GLEntity::setColorData(const int offset, const int bufferSize, const GLfloa
     }
 }
 
+void GLEntity::setInstanceAttribute(GLuint location, GLuint buffer, int components, GLenum type, int stride, int offset)
+{
+    if(!initialized)
+    {
+        return;
+    }
+
+    glBindVertexArray(_vertexArrayID);
+    glEnableVertexAttribArray(location);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    if(type == GL_FLOAT)
+    {
+        glVertexAttribPointer(location, components, type, GL_FALSE, stride, (void*)(size_t)offset);
+    }
+    else
+    {
+        glVertexAttribIPointer(location, components, type, stride, (void*)(size_t)offset);
+    }
+    glVertexAttribDivisor(location, 1);
+}
+
 void GLEntity::setUVData(const int offset, const int bufferSize, const GLfloat * uvBufferData)
 {
-    if(initialized)
+    if(initialized && _uvBuffer != 0)
     {
         glBindBuffer(GL_ARRAY_BUFFER, _uvBuffer);
         glBufferSubData(GL_ARRAY_BUFFER,  offset,  sizeof(GLfloat)*bufferSize,  uvBufferData);
@@ -482,7 +712,11 @@ void GLEntity::setUVData(const int offset, const int bufferSize, const GLfloat *
 
 void GLEntity::setColor(glm::vec3 color)
 {
-    if(initialized)
+    if(_useUniformColor)
+    {
+        _uniformColor = color;
+    }
+    else if(initialized)
     {
         GLfloat * vertexColor = new GLfloat[_bufferSize];
 
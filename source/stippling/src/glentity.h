@@ -42,6 +42,7 @@ private:
     void delete_vertexMPBuffer();
     void delete_normalMPBuffer();
     void delete_colorMPBuffer();
+    void delete_indexMPBuffer();
 
     GLuint _vertexArrayID;
 
@@ -49,11 +50,22 @@ private:
     GLuint _normalBuffer;       // Layout 1
     GLuint _colorBuffer;        // Layout 2
     GLuint _uvBuffer;           // Layout 3
+    GLuint _indexBuffer;        // Element array (only when indexed)
 
     int _bufferSize;
     int _elementType;
     GLuint _glType;
     int _valuesPerVertex;
+    int _numberOfIndices;
+    bool _indexed;
+    GLenum _usage;
+
+    // Allocated sizes of the indexed buffers (they can hold more data than currently used)
+    int _bufferCapacity;
+    int _indexCapacity;
+
+    bool _useUniformColor; /**< Whether the color is passed as the "uniformColor" uniform instead of per vertex. */
+    glm::vec3 _uniformColor;
 
     GLuint _renderShader;
     GLuint _selectionShader;
@@ -69,6 +81,7 @@ private:
     GLfloat * _vertexMPBuffer;
     GLfloat * _normalMPBuffer;
     GLfloat * _colorMPBuffer;
+    GLuint * _indexMPBuffer;
 
 public:
     /**
@@ -178,6 +191,36 @@ public:
                     const int bufferSize, GLuint glType, int pointsPerElement, GLenum usage,
                     GLuint renderShader, GLuint selectionShader);
 
+    /**
+     * @brief Initializes the object as indexed geometry: vertices are shared and the primitives are
+     * described by an element buffer, so they are drawn with glDrawElements(). The whole entity is
+     * painted with a single color, passed to the shaders as a uniform.
+     * @param vertexBufferData Each vertex has to provide 3 GLfloat values that represent its cartesian coordinates.
+     * @param normalBufferData Each vertex has to provide 3 GLfloat values that represent its normal (ignored for GL_LINES).
+     * @param bufferSize Number of GLfloat values present in the vertexBufferData array.
+     * @param indexBufferData Vertex indices of the primitives (as many per primitive as required by glType).
+     * @param numberOfIndices Number of values present in the indexBufferData array.
+     * @param color Normalized RGB color of the entity.
+     * @param glType Type of primitive to be rendered (@see GLEntity#initialize()).
+     * @param usage Expected usage pattern of the data store (@see GLEntity#initialize()).
+     * @param renderShader
+     * @param selectionShader
+     * @see OpenGL#glDrawElements()
+     */
+    void initializeIndexed(const GLfloat vertexBufferData[], const GLfloat normalBufferData[],
+                           const int bufferSize, const GLuint indexBufferData[],
+                           const int numberOfIndices, glm::vec3 color, GLuint glType, GLenum usage,
+                           GLuint renderShader, GLuint selectionShader);
+
+    /**
+     * @brief Replaces the geometry of an indexed entity, reusing its VAO and buffers.
+     * The buffers are only reallocated when the new data doesn't fit in them.
+     * @pre The method initializeIndexed() must have been called beforehand.
+     * @see GLEntity#initializeIndexed()
+     */
+    void setIndexedData(const GLfloat * vertexBufferData, const GLfloat * normalBufferData,
+                        const int bufferSize, const GLuint * indexBufferData, const int numberOfIndices);
+
     /**
      * @brief Renders the object.
      * @pre The method initialize() must have been called beforehand.
@@ -193,12 +236,27 @@ public:
      * @param zNear
      * @param zFar
      * @param drawStippledLines
+     * @param instances Number of copies drawn at once (ignored when illuminated), their own attributes set with setInstanceAttribute().
      * @see GLEntity#initialize()
      */
     void paint(SelectionMode selectionMode, const glm::mat4 * view, const glm::mat4 * projection,
                const glm::mat4 * extModel, GLuint texture, GLfloat xLeft, GLfloat xRight,
                GLfloat yBottom, GLfloat yTop, GLfloat zNear, GLfloat zFar,
-               bool drawStippledLines = false, bool illuminated = false) const;
+               bool drawStippledLines = false, bool illuminated = false, int instances = 1) const;
+
+    /**
+     * @brief Makes a shader attribute advance once per instance instead of once per vertex, reading it
+     * from a buffer filled by the caller.
+     * @pre The method initialize() must have been called beforehand.
+     * @param location Layout of the attribute in the shader (0 to 3 are the vertex data).
+     * @param buffer Buffer with the attribute of every instance.
+     * @param components Number of values of the attribute (1 to 4).
+     * @param type GL_FLOAT, or an integer type read as integers (for int, ivec and uvec attributes).
+     * @param stride Bytes from the attribute of an instance to the one of the next.
+     * @param offset Bytes from the start of the buffer to the attribute of the first instance.
+     * @see OpenGL#glVertexAttribDivisor()
+     */
+    void setInstanceAttribute(GLuint location, GLuint buffer, int components, GLenum type, int stride, int offset);
 
 
     void setVertexData(const int offset, const int bufferSize, const GLfloat * vertexBufferData);
@@ -381,6 +381,8 @@ GLWidget3DEngine::GLWidget3DEngine(QWidget *parent) : QGLWidget(parent)
     _doNotUpdateGL = false;
 
     _cameraDistanceModifier = 0.0f;
+
+    _intermediateCache = 0;
 }
 
 GLWidget3DEngine::~GLWidget3DEngine()
@@ -1093,6 +1095,7 @@ void GLWidget3DEngine::mouseReleaseEvent( QMouseEvent* event )
             if(_interactionState == CONTROL_POINT_INTERACTION)
             {
                 interactionControlPointExistingEntity(event->pos());
+                updateEntityLevelOfDetail(_entities->selected(), COARSE_LOD);
                 _entities->selected()->requestParentUpdate();
                 _interactionState = NO_INTERACTION;
             }
@@ -1451,6 +1454,18 @@ void GLWidget3DEngine::importEntitiesFromXML(QString xml)
 
 cv::Mat GLWidget3DEngine::renderSceneToImageAsSolidAllIlluminated()
 {
+    QByteArray key;
+    if(_intermediateCache != 0)
+    {
+        key = IntermediateCache::Key("solid rendering").add(sceneKey()).result();
+
+        cv::Mat cached;
+        if(_intermediateCache->load(key, cached))
+        {
+            return cached;
+        }
+    }
+
     makeCurrent();
     S3DFBO * offscreenFBO = new S3DFBO(image.cols, image.rows,
                                     GL_RGB,GL_RGB,GL_FLOAT,GL_LINEAR,
@@ -1515,6 +1530,11 @@ cv::Mat GLWidget3DEngine::renderSceneToImageAsSolidAllIlluminated()
 
     updateGL();
 
+    if(_intermediateCache != 0)
+    {
+        _intermediateCache->store(key, corrected);
+    }
+
     return corrected;
 }
 
@@ -1627,18 +1647,102 @@ cv::Mat GLWidget3DEngine::renderSceneToImageAsSolidOneEntityIlluminated(Entity3D
 }
 
 
-void GLWidget3DEngine::generateSolidRenderings()
+bool GLWidget3DEngine::updateEntityLevelOfDetail(Entity3D * entity, LevelOfDetail levelOfDetail)
 {
+    makeCurrent();
+
+    // The solid renderings are made with the perspective camera, at the image's resolution.
+    projectionMode = PERSPECTIVE;
+    resetProjection_VirtualScene();
+    glm::mat4 perspectiveView = _virtualScenePerspectiveCamera.view();
+
+    return entity->updateLevelOfDetail(&perspectiveView, &projection, image.rows, levelOfDetail);
+}
+
+void GLWidget3DEngine::applyLevelOfDetail(LevelOfDetail levelOfDetail)
+{
+    QVector<EntityTreeNode *> * nodes = _entities->traverseBreadthFirst();
+    QSet<Entity3D *> changed;
+
+    // Bottom-up (reversed breadth-first), so each operation is recalculated once and after its operands.
+    for(int i=nodes->size()-1; i>=0; --i)
+    {
+        EntityTreeNode * node = nodes->at(i);
+        bool hasChanged = updateEntityLevelOfDetail(node->getEntity(), levelOfDetail);
+
+        if(node->isOperation())
+        {
+            foreach(EntityTreeNode * child, node->children)
+            {
+                if(changed.contains(child->getEntity()))
+                {
+                    hasChanged = true;
+                }
+            }
+
+            if(hasChanged)
+            {
+                node->getEntity()->updateGeometry(false);
+            }
+        }
+
+        if(hasChanged)
+        {
+            changed.insert(node->getEntity());
+        }
+    }
+
+    nodes->clear();
+    delete nodes;
+    nodes = 0;
+}
+
+bool GLWidget3DEngine::generateSolidRenderings(bool onlyCached)
+{
+    if(onlyCached && _intermediateCache == 0)
+    {
+        return false;
+    }
+
     _entities->correctEntityPositions();
 
     QVector<EntityTreeNode *> * nodes = _entities->traverseBreadthFirst();
 
-    foreach(EntityTreeNode * node, *nodes)
+    QByteArray scene;
+    if(_intermediateCache != 0)
+    {
+        scene = sceneKey();
+    }
+
+    for(int i=0; i<nodes->size(); ++i)
     {
+        EntityTreeNode * node = nodes->at(i);
         cv::Mat solidRendering;
         if(node->hasParent())
         {
-            solidRendering = renderSceneToImageAsSolidOneEntityIlluminated(node->getEntity());
+            // Nodes are told apart by their breadth first position.
+            QByteArray key;
+            if(_intermediateCache != 0)
+            {
+                key = IntermediateCache::Key("node solid rendering").add(scene).add(i).result();
+            }
+
+            if(_intermediateCache == 0 || !_intermediateCache->load(key, solidRendering))
+            {
+                if(onlyCached)
+                {
+                    nodes->clear();
+                    delete nodes;
+                    nodes = 0;
+                    return false;
+                }
+
+                solidRendering = renderSceneToImageAsSolidOneEntityIlluminated(node->getEntity());
+                if(_intermediateCache != 0)
+                {
+                    _intermediateCache->store(key, solidRendering);
+                }
+            }
         }
         else
         {
@@ -1648,6 +1752,53 @@ void GLWidget3DEngine::generateSolidRenderings()
         }
         node->setSolidRendering(solidRendering);
     }
+
+    nodes->clear();
+    delete nodes;
+    nodes = 0;
+
+    return true;
+}
+
+bool GLWidget3DEngine::loadCachedSolidRenderings(cv::Mat & solidRendering)
+{
+    if(_intermediateCache == 0)
+    {
+        return false;
+    }
+
+    _entities->correctEntityPositions();
+
+    // Same key as renderSceneToImageAsSolidAllIlluminated.
+    QByteArray key = IntermediateCache::Key("solid rendering").add(sceneKey()).result();
+
+    return _intermediateCache->load(key, solidRendering) && generateSolidRenderings(true);
 }
 
+void GLWidget3DEngine::setIntermediateCache(IntermediateCache * cache)
+{
+    _intermediateCache = cache;
+}
 
+QByteArray GLWidget3DEngine::sceneKey()
+{
+    IntermediateCache::Key key("scene");
+
+    key.add(image.rows).add(image.cols);
+    key.add(_cameraFOV).add(_cameraDistance);
+    key.add(_virtualScenePerspectiveCamera.view());
+
+    // The XML rounds the numbers, so the exact model matrices are added too.
+    key.add(_entities->toXML());
+
+    QVector<EntityTreeNode *> * nodes = _entities->traverseBreadthFirst();
+    foreach(EntityTreeNode * node, *nodes)
+    {
+        key.add(node->getEntity()->model());
+    }
+    nodes->clear();
+    delete nodes;
+    nodes = 0;
+
+    return key.result();
+}
@@ -65,6 +65,7 @@
 #include "entitytreecontroller.h"
 #include "heightindicator.h"
 #include "stippledot.h"
+#include "intermediatecache.h"
 
 
 
@@ -212,6 +213,8 @@ private:
 
     bool _doNotUpdateGL;
 
+    IntermediateCache * _intermediateCache; /**< Keeps the solid renderings between runs, if any. Not owned. */
+
 private:
 
     cv::Mat fboTexturetoImage(S3DFBO * fbo, int height, int width);
@@ -238,6 +241,8 @@ private:
 
     EntityTreeNode * createNodesFromXML(QDomNode xmlNode);
 
+    bool updateEntityLevelOfDetail(Entity3D * entity, LevelOfDetail levelOfDetail);
+
 public:
 
     bool isImageLoaded() const;
@@ -319,7 +324,39 @@ public:
 
     cv::Mat renderSceneToImageAsSolidOneEntityIlluminated(Entity3D * illuminated);
 
-    void generateSolidRenderings();
+    /**
+     * @brief Adapts the tessellation of every entity to its projected size on the image.
+     * Operations whose operands changed are recalculated (once each, bottom-up).
+     * @param levelOfDetail COARSE_LOD while editing the scene, FINE_LOD for the solid renderings.
+     */
+    void applyLevelOfDetail(LevelOfDetail levelOfDetail);
+
+    /**
+     * @brief Renders (or reads from the cache) the solid rendering of every entity of the CSG tree.
+     * @param onlyCached If true nothing is rendered: it stops at the first rendering not cached.
+     * @return False if onlyCached and some rendering is not cached (or there is no cache).
+     */
+    bool generateSolidRenderings(bool onlyCached = false);
+
+    /**
+     * @brief Reads the solid renderings of the entities and of the whole scene from the cache, so a
+     * scene rendered before needs no fine tessellation (and no recalculated operations).
+     * @param solidRendering Receives the solid rendering of the whole scene.
+     * @return False if some rendering is not cached: generateSolidRenderings and
+     * renderSceneToImageAsSolidAllIlluminated have to be called then.
+     */
+    bool loadCachedSolidRenderings(cv::Mat & solidRendering);
+
+    /**
+     * @brief Sets the cache the solid renderings are read from and stored in (0, the default, disables it).
+     */
+    void setIntermediateCache(IntermediateCache * cache);
+
+    /**
+     * @brief Key of everything the solid renderings depend on: image size, camera and CSG tree.
+     * The positions of the entities have to be corrected first (see generateSolidRenderings).
+     */
+    QByteArray sceneKey();
 };
 
 
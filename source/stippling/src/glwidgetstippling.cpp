@@ -12,6 +12,37 @@
 
 #include "glwidgetstippling.h"
 
+#include "random.h"
+
+#include <cstddef>
+#include <cstring>
+
+/**
+ * @brief Random number a dot is dispersed with: the first number of the stream keyed by the position the dot was generated at.
+ * The angle is drawn from the low half and the length from the high half, so the vertex
+ * shader (which has no 64 bit integers) gets the same offset as the CPU dispersion.
+ */
+static inline quint64 stippleDotRandom(quint64 seed, glm::vec2 position)
+{
+    quint32 x, y;
+    memcpy(&x, &position.x, sizeof(x));
+    memcpy(&y, &position.y, sizeof(y));
+
+    return Random(seed, Random::key(int(x), int(y))).next64();
+}
+
+/**
+ * @brief Fills the cosine and sine of every integer angle in degrees, the directions a dot may be dispersed along.
+ */
+static void dispersionDirections(float * cosines, float * sines)
+{
+    for(int alpha=0; alpha<360; ++alpha)
+    {
+        cosines[alpha] = float(cos(alpha * PI / 180.0));
+        sines[alpha] = float(sin(alpha * PI / 180.0));
+    }
+}
+
 cv::Mat GLWidgetStippling::fboTexturetoImage(S3DFBO * fbo, int height, int width)
 {
     fbo->renderFBO();
@@ -114,7 +145,7 @@ void GLWidgetStippling::glSetup()
     out << endl;
 }
 
-GLuint GLWidgetStippling::prepareShaderProgram(const QString& vertexShaderPath, const QString& fragmentShaderPath)
+GLuint GLWidgetStippling::prepareShaderProgram(const QString& vertexShaderPath, const QString& fragmentShaderPath, bool required)
 {
     struct Shader
     {
@@ -164,6 +195,12 @@ GLuint GLWidgetStippling::prepareShaderProgram(const QString& vertexShaderPath,
             qWarning() << logMsg;
             delete [] logMsg;
 
+            if(!required)
+            {
+                glDeleteShader(shader);
+                glDeleteProgram(program);
+                return 0;
+            }
             exit( EXIT_FAILURE );
         }
 
@@ -188,6 +225,11 @@ GLuint GLWidgetStippling::prepareShaderProgram(const QString& vertexShaderPath,
         qWarning() << logMsg ;
         delete [] logMsg;
 
+        if(!required)
+        {
+            glDeleteProgram(program);
+            return 0;
+        }
         exit( EXIT_FAILURE );
     }
 
@@ -242,10 +284,10 @@ void GLWidgetStippling::initializeAxes()
                        colorShaderID, pickingShaderID);
 }
 
-void GLWidgetStippling::initializeSprite(GLEntity & dot, glm::vec2 spriteSize,
-                                         glm::vec2 spritesMatrixSize,
-                                         glm::vec2 spritesMatrixPosition)
+void GLWidgetStippling::initializeSpriteQuad()
 {
+    glm::vec2 spriteSize = _spriteAtlas.spriteSize();
+
     const GLfloat vertexBufferData[] =
     {
         0.0f, 0.0f, 0.0f,
@@ -263,40 +305,40 @@ void GLWidgetStippling::initializeSprite(GLEntity & dot, glm::vec2 spriteSize,
     // One normal for each vertex.
     const GLfloat * normalBufferData = 0;
 
-    float unitX = 1.0f / float(spritesMatrixSize.x);
-    float unitY = 1.0f / float(spritesMatrixSize.y);
-
-    float minX = spritesMatrixPosition.x * unitX;
-    float maxX = (spritesMatrixPosition.x + 1) * unitX;
-    float minY = spritesMatrixPosition.y * unitY;
-    float maxY = (spritesMatrixPosition.y + 1) * unitY;
-
-    // One uv coord for each vertex.
+    // One uv coord for each vertex, relative to the cell of the sprite (its top row is drawn on top).
     const GLfloat uvBufferData[] =
     {
-        minX, maxY,
-        maxX, maxY,
-        maxX, minY,
+        0.0f, 1.0f,
+        1.0f, 1.0f,
+        1.0f, 0.0f,
 
-        maxX, minY,
-        minX, minY,
-        minX, maxY,
+        1.0f, 0.0f,
+        0.0f, 0.0f,
+        0.0f, 1.0f,
     };
 
     int numberOfValuesInStaticBuffers = sizeof(vertexBufferData)/sizeof(GLfloat);
 
-    dot.initialize(vertexBufferData, colorBufferData, normalBufferData, uvBufferData,
-                   numberOfValuesInStaticBuffers, GL_TRIANGLES, 3, GL_DYNAMIC_DRAW,
-                   textureShaderID, pickingShaderID);
+    _spriteQuad.initialize(vertexBufferData, colorBufferData, normalBufferData, uvBufferData,
+                           numberOfValuesInStaticBuffers, GL_TRIANGLES, 3, GL_STATIC_DRAW,
+                           stippleDotShaderID, pickingShaderID);
+
+    // Every dot is an instance of the quad, see the layouts of stippleDotShader.vert.
+    if(_dotInstanceBuffer == 0)
+    {
+        glGenBuffers(1, &_dotInstanceBuffer);
+    }
+    _spriteQuad.setInstanceAttribute(4, _dotInstanceBuffer, 2, GL_FLOAT, sizeof(DotInstance), offsetof(DotInstance, position));
+    _spriteQuad.setInstanceAttribute(5, _dotInstanceBuffer, 4, GL_FLOAT, sizeof(DotInstance), offsetof(DotInstance, uvRect));
+    _spriteQuad.setInstanceAttribute(6, _dotInstanceBuffer, 2, GL_UNSIGNED_INT, sizeof(DotInstance), offsetof(DotInstance, random));
+    _spriteQuad.setInstanceAttribute(7, _dotInstanceBuffer, 1, GL_INT, sizeof(DotInstance), offsetof(DotInstance, useDispersion));
 }
 
 void GLWidgetStippling::initializeSprites()
 {
-    spritesImg = cv::imread("./resources/precdots10alpha.png", CV_LOAD_IMAGE_UNCHANGED);
-
-    if(! spritesImg.data ) // Check for invalid input
+    if(!_spriteAtlas.load(SpriteAtlas::defaultDescriptorFile()))
     {
-        QMessageBox::information(this, tr("PROJECT"), tr("Could not open or find the image \"/resources/sprites.png\"."));
+        QMessageBox::information(this, tr("PROJECT"), tr("Could not open or find the sprite atlas \"%1\".").arg(SpriteAtlas::defaultDescriptorFile()));
         return;
     }
 
@@ -306,31 +348,13 @@ void GLWidgetStippling::initializeSprites()
     glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
 
-    // 2d texture, level of detail 0 (normal), 3 components (red, green, blue), x size from image, y size from image,
-    // border 0 (normal), rgb color data, unsigned byte data, and finally the data itself.
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, spritesImg.cols, spritesImg.rows, 0, GL_BGRA, GL_UNSIGNED_BYTE, spritesImg.ptr());
-
-    // TODO REFACTOR Create a SpriteMatrix class to take care of this responsibility
-    spriteSize = glm::vec2(10, 10);
-    spritesMatrixSize = glm::vec2(29,29);
-
-    sprites.clear();
-    sprites.reserve(spritesMatrixSize.x * spritesMatrixSize.y);
-    for(int i=0; i<spritesMatrixSize.x * spritesMatrixSize.y; ++i)
-    {
-        int id = _idManager.getNewID();
-        GLEntity dot = GLEntity(id, _idManager.encodeID(id));
-
-        int chosenRow = int(i / spritesMatrixSize.x);
-        int chosenColumn = i % int(spritesMatrixSize.x);
-
-        initializeSprite(dot, spriteSize, spritesMatrixSize, glm::vec2(chosenColumn, chosenRow));
+    // 2d texture, level of detail 0 (normal), 4 components (red, green, blue, alpha), x size from image, y size from image,
+    // border 0 (normal), bgra color data, unsigned byte data, and finally the data itself.
+    const cv::Mat & image = _spriteAtlas.image();
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.cols, image.rows, 0, GL_BGRA, GL_UNSIGNED_BYTE, image.ptr());
 
-        sprites.push_back(dot);
-    }
-    // Now sprites holds all the dots from the sprite matrix.
-    // To represent a StippleDot all that's necessary is to acess the sprites array
-    // using the chosen dot integer value as index and invoke its paint method.
+    // A single quad draws every sprite: each dot sets the cell of the atlas it is textured with.
+    initializeSpriteQuad();
 }
 
 void GLWidgetStippling::initializeStipplingTextureHolder(int rows, int cols)
@@ -418,11 +442,22 @@ GLWidgetStippling::GLWidgetStippling(QWidget *parent) : QGLWidget(parent)
     _stipplingTextureID = 0;
 
     spritesTextureID = 0;
+    _spriteQuad = GLEntity(_idManager.NONE(), _idManager.encodeID(_idManager.NONE()));
+    _dotInstanceBuffer = 0;
+    _directionsTextureID = 0;
+    _gpuDispersionAvailable = false;
 
     _stipplingDots = 0;
+    _cpuStippleDotDispersion = 0;
+    _previewStippleDotDispersion = -1;
     _dotGenerationWorker = 0;
     _dotGenerationWorkerThread = 0;
 
+    _isPreviewingGeneration = false;
+    _generationPreviewTimer = new QTimer(this);
+    _generationPreviewTimer->setInterval(250);
+    connect(_generationPreviewTimer, SIGNAL(timeout()), this, SLOT(collectGeneratedDots()));
+
     isDeletePressed = false;
 
     _areStipplingTexturesReady = false;
@@ -432,6 +467,12 @@ GLWidgetStippling::GLWidgetStippling(QWidget *parent) : QGLWidget(parent)
     _stipplingPerformedAtLeastOnce = false;
 
     _entities = 0;
+
+    _profiler = 0;
+
+    _intermediateCache = 0;
+
+    _stippledPhotographSize = glm::ivec2(0, 0);
 }
 
 GLWidgetStippling::~GLWidgetStippling()
@@ -471,6 +512,39 @@ void GLWidgetStippling::initializeGL()
     stippleShaderID = prepareShaderProgram(":shaders/stippleShader.vert",":shaders/stippleShader.frag");
     xyColorShaderID = prepareShaderProgram(":shaders/xyColorShader.vert", ":shaders/xyColorShader.frag");
     xzColorShaderID = prepareShaderProgram(":shaders/xzColorShader.vert", ":shaders/xzColorShader.frag");
+    // Without the dispersion shader the dots are still drawn, and dispersed on the CPU.
+    stippleDotShaderID = prepareShaderProgram(":shaders/stippleDotShader.vert", ":shaders/textureShader.frag", false);
+    _gpuDispersionAvailable = (stippleDotShaderID != 0);
+    if(!_gpuDispersionAvailable)
+    {
+        out << "Error: the dispersion shader could not be built, the stipple dots will be dispersed on the CPU." << endl;
+        stippleDotShaderID = prepareShaderProgram(":shaders/stippleDotFixedShader.vert", ":shaders/textureShader.frag");
+    }
+    else
+    {
+        // The dispersion directions never change, they are loaded once. A texture instead of a
+        // uniform array, which could exceed the uniform components of the vertex shader.
+        float cosines[360];
+        float sines[360];
+        dispersionDirections(cosines, sines);
+        GLfloat directions[2*360];
+        for(int alpha=0; alpha<360; ++alpha)
+        {
+            directions[2*alpha] = cosines[alpha];
+            directions[2*alpha + 1] = sines[alpha];
+        }
+
+        glGenTextures(1, &_directionsTextureID);
+        glBindTexture(GL_TEXTURE_1D, _directionsTextureID);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexImage1D(GL_TEXTURE_1D, 0, GL_RG32F, 360, 0, GL_RG, GL_FLOAT, directions);
+        glBindTexture(GL_TEXTURE_1D, 0);
+
+        // Texture unit 1, the sprites are on unit 0.
+        glUseProgram(stippleDotShaderID);
+        glUniform1i(glGetUniformLocation(stippleDotShaderID, "directions"), 1);
+    }
 
     // Enable depth test
     glEnable(GL_DEPTH_TEST);
@@ -529,7 +603,8 @@ void GLWidgetStippling::resetProjection(bool isTileRenderingModeON)
 
 void GLWidgetStippling::paintGL()
 {
-    if(_renderUsingMultipleTiles)
+    // The partial results are only rendered to the visible area.
+    if(_renderUsingMultipleTiles && !_isPreviewingGeneration)
     {
         renderUsingMultipleTiles();
     }
@@ -677,8 +752,22 @@ void GLWidgetStippling::paintScene(bool isCoordCaptureModeON, bool isTileRenderi
         }
 
         glm::vec4 renderArea = glm::vec4(startX, startY, endX, endY);
+        glm::vec2 spriteSize = _spriteAtlas.spriteSize();
         int padding = qMax(spriteSize.x, spriteSize.y);
 
+        bool gpuDispersion = _stipplingDots != 0 && _gpuDispersionAvailable &&
+                (_previewStippleDotDispersion >= 0 || _configuration->gpuStippleDotDispersion());
+        unsigned int dispersion = 0;
+        if(gpuDispersion)
+        {
+            dispersion = _previewStippleDotDispersion >= 0 ? (unsigned int)_previewStippleDotDispersion
+                                                           : _configuration->stippleDotDispersion();
+            dispersion /= 10; // Same factor as the CPU dispersion.
+
+            // The dots are stored where any CPU offset left them, but drawn from where they were generated.
+            padding += dispersion + _cpuStippleDotDispersion;
+        }
+
 
 
         /*
@@ -688,17 +777,62 @@ void GLWidgetStippling::paintScene(bool isCoordCaptureModeON, bool isTileRenderi
         */
         if(_stipplingDots != 0)
         {
-            glBindTexture( GL_TEXTURE_2D, spritesTextureID );
+            quint64 seed = Random::seedOf(_configuration->rngSeed());
 
+            // The dots are drawn at once, as instances of the sprite quad.
+            _dotInstances.resize(0);
             foreach(QVector<StippleDot *> * subvector, _stipplingDots->getDotsInPaddedArea(renderArea, padding))
             {
                 foreach(StippleDot * dot, *subvector)
                 {
-                    glm::mat4 model = dot->model();
-                    sprites.at(dot->chosenDot()).paint(_selectionMode, &view, &projection, &model, spritesTextureID, 0, 0, 0, 0, 0, 0);
+                    DotInstance instance;
+                    glm::vec2 position;
+                    if(gpuDispersion)
+                    {
+                        position = dot->position();
+
+                        quint64 random = stippleDotRandom(seed, position);
+                        instance.random[0] = quint32(random);
+                        instance.random[1] = quint32(random >> 32);
+                        instance.useDispersion = dot->canHaveOffsetApplied() ? 1 : 0;
+                    }
+                    else
+                    {
+                        position = dot->finalPostion();
+
+                        instance.random[0] = 0;
+                        instance.random[1] = 0;
+                        instance.useDispersion = 0;
+                    }
+                    instance.position[0] = position.x;
+                    instance.position[1] = position.y;
+
+                    glm::vec4 uvRect = _spriteAtlas.uvRect(dot->chosenDot());
+                    instance.uvRect[0] = uvRect.x;
+                    instance.uvRect[1] = uvRect.y;
+                    instance.uvRect[2] = uvRect.z;
+                    instance.uvRect[3] = uvRect.w;
+
+                    _dotInstances.append(instance);
+                }
+            }
+            numDotsRendered = _dotInstances.size();
+
+            if(numDotsRendered > 0)
+            {
+                glBindBuffer(GL_ARRAY_BUFFER, _dotInstanceBuffer);
+                glBufferData(GL_ARRAY_BUFFER, sizeof(DotInstance) * numDotsRendered, _dotInstances.constData(), GL_STREAM_DRAW);
 
-                    ++numDotsRendered;
+                glUseProgram(stippleDotShaderID);
+                if(_gpuDispersionAvailable)
+                {
+                    glUniform1ui(glGetUniformLocation(stippleDotShaderID, "dispersion"), dispersion);
+                    glActiveTexture(GL_TEXTURE1);
+                    glBindTexture(GL_TEXTURE_1D, _directionsTextureID);
+                    glActiveTexture(GL_TEXTURE0);
                 }
+                _spriteQuad.paint(_selectionMode, &view, &projection, 0, spritesTextureID, 0, 0, 0, 0, 0, 0,
+                                  false, false, numDotsRendered);
             }
         }
 
@@ -723,6 +857,9 @@ void GLWidgetStippling::singleTileRenderCurrentScene()
         _stipplingTextureID = _fboStipplingToTexture->getTexture();
     }
 
+    StageProfiler::ScopedStage stage(_profiler, StageProfiler::TILE_RENDER);
+    stage.addItems(1);
+
     initializeStipplingTextureHolder(tileHeight, tileWidth);
 
     resetProjection(false);
@@ -754,7 +891,7 @@ void GLWidgetStippling::tileRenderCurrentScene()
     _tilesFBOs.clear();
     _tilesPos.clear();
 
-
+    StageProfiler::ScopedStage stage(_profiler, StageProfiler::TILE_RENDER);
 
     int tileWidth = _configuration->tileWidth();
     int tileHeight = _configuration->tileHeight();
@@ -823,6 +960,7 @@ void GLWidgetStippling::tileRenderCurrentScene()
             tileFBO->renderFramebuffer();
 
             _tilesFBOs.push_back(tileFBO);
+            stage.addItems(1);
             _tilesPos.push_back(glm::vec3((j * tileWidth), (i * tileHeight), 0));
         }
     }
@@ -831,8 +969,21 @@ void GLWidgetStippling::tileRenderCurrentScene()
 }
 
 void GLWidgetStippling::stippleImage(cv::Mat toStipple, DotGenerationWorker::DitheringMethod ditheringMethod,
-                                     cv::Mat solid3DModel)
+                                     cv::Mat solid3DModel, const QByteArray & sceneKey, bool runInBackground)
 {
+    if(isStippling())
+    {
+        out << "Error: the stipple dots are already being generated." << endl;
+        return;
+    }
+
+    if(_spriteAtlas.isEmpty())
+    {
+        out << "Error: there are no sprites to draw the stipple dots with." << endl;
+        emit stipplingEnded(false);
+        return;
+    }
+
     _isStipplingTextureReady = false;
 
     resetViewingTransformations();
@@ -849,12 +1000,38 @@ void GLWidgetStippling::stippleImage(cv::Mat toStipple, DotGenerationWorker::Dit
         _fboStipplingToTexture = 0;
     }
 
-    _dotGenerationWorkerThread = new QThread();
+    // The former worker was kept to generate the dots again incrementally. Its process() has returned.
+    if(_dotGenerationWorker != 0)
+    {
+        delete _dotGenerationWorker;
+        _dotGenerationWorker = 0;
+    }
 
-    _dotGenerationWorker = new DotGenerationWorker(toStipple, ditheringMethod, spriteSize, spritesMatrixSize,
+    _stippledPhotographSize = glm::ivec2(toStipple.cols, toStipple.rows);
+
+    _dotGenerationWorker = new DotGenerationWorker(toStipple, ditheringMethod, _spriteAtlas,
                                                   solid3DModel,
                                                   _configuration,
                                                   _entities);
+    _dotGenerationWorker->setIntermediateCache(_intermediateCache, sceneKey);
+
+    if(!runInBackground)
+    {
+        // The worker lives in this thread, so finished() reaches stippleImageEnded directly.
+        connect(_dotGenerationWorker, SIGNAL(finished()), this, SLOT(stippleImageEnded()));
+        _dotGenerationWorker->process();
+        return;
+    }
+
+    // The dots are rendered as they are generated, on a tree of copies owned by this widget.
+    _dotGenerationWorker->setProgressiveOutput(true);
+    _stipplingDots = new QuadTree(_dotGenerationWorker->stippledImageArea(), DotGenerationWorker::QUADTREE_DEPTH);
+    stippledImageRows = _stipplingDots->getRootArea().w;
+    stippledImageCols = _stipplingDots->getRootArea().z;
+    _cpuStippleDotDispersion = 0;
+    _isPreviewingGeneration = true;
+
+    _dotGenerationWorkerThread = new QThread();
 
     _dotGenerationWorker->moveToThread(_dotGenerationWorkerThread);
 
@@ -862,11 +1039,61 @@ void GLWidgetStippling::stippleImage(cv::Mat toStipple, DotGenerationWorker::Dit
     connect(_dotGenerationWorker, SIGNAL(finished()), this, SLOT(stippleImageEnded()));
 
     _dotGenerationWorkerThread->start();
+    _generationPreviewTimer->start();
+}
+
+bool GLWidgetStippling::isStippling() const
+{
+    return _dotGenerationWorkerThread != 0;
+}
+
+bool GLWidgetStippling::hasStipplingDots() const
+{
+    return _stipplingDots != 0 && !isStippling();
+}
+
+void GLWidgetStippling::cancelStippling()
+{
+    if(isStippling())
+    {
+        _dotGenerationWorker->cancel();
+    }
+}
+
+void GLWidgetStippling::collectGeneratedDots()
+{
+    if(!_isPreviewingGeneration || _dotGenerationWorker == 0)
+    {
+        return;
+    }
+
+    QList<StippleDotBand *> bands = _dotGenerationWorker->takeCompletedBands();
+    if(bands.isEmpty())
+    {
+        return;
+    }
+
+    foreach(StippleDotBand * band, bands)
+    {
+        foreach(const StippleDot & dot, band->dots)
+        {
+            _stipplingDots->add(new StippleDot(dot));
+        }
+        delete band;
+    }
+
+    makeCurrent();
+    singleTileRenderCurrentScene();
 }
 
 void GLWidgetStippling::stippleImageEnded()
 {
-    _stipplingDots = _dotGenerationWorker->getStipplingDots();
+    QuadTree * stipplingDots = _dotGenerationWorker->getStipplingDots();
+
+    // The partial results are replaced by the whole tree (or dropped, if cancelled).
+    _generationPreviewTimer->stop();
+    qDeleteAll(_dotGenerationWorker->takeCompletedBands());
+    _isPreviewingGeneration = false;
 
     //out << "Got Stippling dots, deleting the worker thread..." << endl;
 
@@ -879,6 +1106,69 @@ void GLWidgetStippling::stippleImageEnded()
 
     //out << "Worker thread deleted." << endl;
 
+    if(stipplingDots == 0)
+    {
+        out << "The stippling process was cancelled." << endl;
+        setStipplingDots(0, false);
+        _isStipplingTextureReady = false;
+        updateGL();
+        emit stipplingEnded(false);
+        return;
+    }
+
+    setStipplingDots(stipplingDots, true);
+
+    emit stipplingEnded(true);
+}
+
+void GLWidgetStippling::restippleEntity(EntityTreeNode * node)
+{
+    if(isStippling() || _dotGenerationWorker == 0 || _stipplingDots == 0 || !_stipplingPerformedAtLeastOnce)
+    {
+        return;
+    }
+
+    if(!_dotGenerationWorker->regenerateNode(node, _stipplingDots))
+    {
+        return;
+    }
+
+    // The new dots have no offsets yet, they get the ones of the dispersion already applied.
+    if(_cpuStippleDotDispersion != 0)
+    {
+        disperseStippleDots(_cpuStippleDotDispersion);
+    }
+
+    makeCurrent();
+    if(_renderUsingMultipleTiles)
+    {
+        tileRenderCurrentScene();
+    }
+    else
+    {
+        singleTileRenderCurrentScene();
+    }
+
+    updateGL();
+}
+
+void GLWidgetStippling::setStipplingDots(QuadTree * stipplingDots, bool renderTextures)
+{
+    if(_stipplingDots != 0 && _stipplingDots != stipplingDots)
+    {
+        delete _stipplingDots;
+    }
+    _stipplingDots = stipplingDots;
+    _cpuStippleDotDispersion = 0;
+
+    if(_stipplingDots == 0)
+    {
+        return;
+    }
+
+    // The 3D engine shares the GUI thread, make sure the textures are rendered with this context.
+    makeCurrent();
+
     glm::vec4 quadTreeArea = _stipplingDots->getRootArea();
 
     stippledImageRows = quadTreeArea.w;
@@ -886,6 +1176,11 @@ void GLWidgetStippling::stippleImageEnded()
 
     //out << "Stippled image size: " << stippledImageRows << " x " << stippledImageCols << " px" << endl;
 
+    if(!renderTextures)
+    {
+        return;
+    }
+
     out << "First texture render starting..." << endl;
     // Single texture rendering mode first rendering
     tileRenderCurrentScene();
@@ -902,6 +1197,76 @@ void GLWidgetStippling::stippleImageEnded()
     _stipplingPerformedAtLeastOnce = true;
 }
 
+glm::vec2 GLWidgetStippling::getSpriteSize() const
+{
+    return _spriteAtlas.spriteSize();
+}
+
+glm::vec2 GLWidgetStippling::getSpritesMatrixSize() const
+{
+    return _spriteAtlas.matrixSize();
+}
+
+const SpriteAtlas & GLWidgetStippling::spriteAtlas() const
+{
+    return _spriteAtlas;
+}
+
+bool GLWidgetStippling::loadSpriteAtlas(QString descriptorFile)
+{
+    if(isStippling())
+    {
+        out << "Error: the stipple dots are being generated." << endl;
+        return false;
+    }
+
+    glm::vec2 previousSpriteSize = _spriteAtlas.spriteSize();
+    int previousNumberOfSprites = _spriteAtlas.numberOfSprites();
+
+    if(!_spriteAtlas.load(descriptorFile))
+    {
+        return false;
+    }
+
+    makeCurrent();
+
+    glBindTexture( GL_TEXTURE_2D, spritesTextureID );
+    const cv::Mat & image = _spriteAtlas.image();
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.cols, image.rows, 0, GL_BGRA, GL_UNSIGNED_BYTE, image.ptr());
+
+    if(_spriteAtlas.spriteSize() != previousSpriteSize)
+    {
+        initializeSpriteQuad();
+    }
+
+    if(_stipplingDots == 0)
+    {
+        return true;
+    }
+
+    // The dots are placed according to the size of the sprites, and refer to them by index.
+    if(_spriteAtlas.spriteSize() != previousSpriteSize || _spriteAtlas.numberOfSprites() < previousNumberOfSprites)
+    {
+        out << "The stipple dots do not fit the sprites of " << descriptorFile << ", they have to be generated again." << endl;
+        setStipplingDots(0, false);
+        if(_dotGenerationWorker != 0)
+        {
+            delete _dotGenerationWorker;
+            _dotGenerationWorker = 0;
+        }
+        _isStipplingTextureReady = false;
+    }
+    else
+    {
+        tileRenderCurrentScene();
+        singleTileRenderCurrentScene();
+    }
+
+    updateGL();
+
+    return true;
+}
+
 
 
 
@@ -1134,36 +1499,83 @@ void GLWidgetStippling::resetViewingTransformations()
 
 
 
-void GLWidgetStippling::applyStippleDotDispersion()
+/**
+ * @brief Applies the dispersion offsets to some leaves of the quadtree, as a cv::parallel_for_ body.
+ * The random angle and length of every dot are a hash of the seed and the dot's position, so
+ * the result depends neither on the number of threads nor on the leaf a dot is stored in.
+ */
+class DispersionBody : public cv::ParallelLoopBody
 {
-    unsigned int dispersion = _configuration->stippleDotDispersion();
-    dispersion /= 10; // Factor down the dispersion, so it can be better tuned.
-
-    if(_stipplingDots != 0)
+private:
+    const QVector<QVector<StippleDot *> *> & _leaves;
+    quint64 _seed;
+    unsigned int _dispersion;
+    const float * _cosines; /**< Cosine of every integer angle in degrees. */
+    const float * _sines; /**< Sine of every integer angle in degrees. */
+
+public:
+    DispersionBody(const QVector<QVector<StippleDot *> *> & leaves, quint64 seed, unsigned int dispersion,
+                   const float * cosines, const float * sines)
+        : _leaves(leaves), _seed(seed), _dispersion(dispersion), _cosines(cosines), _sines(sines)
     {
-        srand(_configuration->rngSeed());
+    }
 
-        foreach(QVector<StippleDot *> * subvector, _stipplingDots->getDotsInFullArea())
+    void operator()(const cv::Range & range) const
+    {
+        for(int i=range.start; i<range.end; ++i)
         {
-            foreach(StippleDot * dot, *subvector)
+            foreach(StippleDot * dot, *_leaves[i])
             {
-                float alpha = rand() % 360;
-                float length = rand() % (dispersion + 1);
-
-                int offsetX = int(length * cos(alpha));
-                int offsetY = int(length * sin(alpha));
-
-                if(dispersion == 0)
-                {
-                    offsetX = 0;
-                    offsetY = 0;
-                }
+                quint64 random = stippleDotRandom(_seed, dot->position());
+                int alpha = int(quint32(random) % 360);
+                float length = float(quint32(random >> 32) % (_dispersion + 1));
 
-                glm::vec2 offset = glm::vec2(offsetX, offsetY);
-                dot->setOffset(offset);
+                dot->setOffset(glm::vec2(int(length * _cosines[alpha]), int(length * _sines[alpha])));
             }
         }
     }
+};
+
+void GLWidgetStippling::disperseStippleDots(unsigned int dispersion)
+{
+    StageProfiler::ScopedStage stage(_profiler, StageProfiler::DISPERSION);
+
+    // The angle is drawn in degrees.
+    float cosines[360];
+    float sines[360];
+    dispersionDirections(cosines, sines);
+
+    QVector<QVector<StippleDot *> *> leaves = _stipplingDots->getDotsInFullArea();
+    foreach(QVector<StippleDot *> * leaf, leaves)
+    {
+        stage.addItems(leaf->size());
+    }
+
+    cv::parallel_for_(cv::Range(0, leaves.size()),
+                      DispersionBody(leaves, Random::seedOf(_configuration->rngSeed()), dispersion, cosines, sines));
+
+    // Only the dots that crossed a leaf border are moved.
+    _stipplingDots->rebucket();
+
+    _cpuStippleDotDispersion = dispersion;
+}
+
+void GLWidgetStippling::applyStippleDotDispersion()
+{
+    unsigned int dispersion = _configuration->stippleDotDispersion();
+    dispersion /= 10; // Factor down the dispersion, so it can be better tuned.
+
+    if(_configuration->gpuStippleDotDispersion() && _gpuDispersionAvailable)
+    {
+        // The vertex shader disperses the dots as they are drawn, only the offsets
+        // left by a former CPU dispersion have to be removed.
+        dispersion = 0;
+    }
+
+    if(_stipplingDots != 0 && (dispersion != 0 || _cpuStippleDotDispersion != 0))
+    {
+        disperseStippleDots(dispersion);
+    }
 
     if(_renderUsingMultipleTiles)
     {
@@ -1179,136 +1591,163 @@ void GLWidgetStippling::applyStippleDotDispersion()
 
 
 
-void GLWidgetStippling::saveStippledImageToDisk(QString fileName)
+bool GLWidgetStippling::saveStippledImageToDisk(QString fileName, bool showResult)
 {
     // THIS ALGORITHM IS OPTIMIZED TO REDUCE MEMORY CONSUMPTION WHEN WRITING
     // THE FULL STIPPLED IMAGE TO DISK.
 
     out << "Beginning tile rendering process..." << endl;
 
-    S3DFBO *fboTiling;
+    makeCurrent();
 
-    // Maximum possible fbo size (both dimensions are equal).
-    GLint dims[2];
-    glGetIntegerv(GL_MAX_VIEWPORT_DIMS, &dims[0]);
+    // Rendered over whole tiles, so it may be larger than the stippled image.
+    cv::Mat fullResolutionScene;
+    {
+        StageProfiler::ScopedStage stage(_profiler, StageProfiler::TILE_RENDER);
 
-    int tileWidth = dims[0];
-    int tileHeight = dims[0];
+        S3DFBO *fboTiling;
 
-    tileWidth = 500;
-    tileHeight = 500;
+        // Maximum possible fbo size (both dimensions are equal).
+        GLint dims[2];
+        glGetIntegerv(GL_MAX_VIEWPORT_DIMS, &dims[0]);
 
-    fboTiling = new S3DFBO(tileWidth, tileHeight,
-                     GL_RGB,GL_RGB,GL_FLOAT,GL_NEAREST,
-                     true,true);
+        int tileWidth = dims[0];
+        int tileHeight = dims[0];
 
-    float iMaxFloat = stippledImageRows / float(tileHeight);
-    float jMaxFloat = stippledImageCols / float(tileWidth);
-    int iMax = stippledImageRows / tileHeight;
-    int jMax = stippledImageCols / tileWidth;
-    if(iMaxFloat - iMax > 0.0f)
-    {
-        ++iMax;
-    }
-    if(jMaxFloat - jMax > 0.0f)
-    {
-        ++jMax;
-    }
+        tileWidth = 500;
+        tileHeight = 500;
 
-    cv::Mat fullResolutionScene;
-    fullResolutionScene.create(tileHeight * iMax, tileWidth * jMax, CV_8UC3);
+        fboTiling = new S3DFBO(tileWidth, tileHeight,
+                         GL_RGB,GL_RGB,GL_FLOAT,GL_NEAREST,
+                         true,true);
 
-    cv::Mat tile;
-    tile.create(tileHeight, tileWidth, CV_8UC3);
+        float iMaxFloat = stippledImageRows / float(tileHeight);
+        float jMaxFloat = stippledImageCols / float(tileWidth);
+        int iMax = stippledImageRows / tileHeight;
+        int jMax = stippledImageCols / tileWidth;
+        if(iMaxFloat - iMax > 0.0f)
+        {
+            ++iMax;
+        }
+        if(jMaxFloat - jMax > 0.0f)
+        {
+            ++jMax;
+        }
 
+        fullResolutionScene.create(tileHeight * iMax, tileWidth * jMax, CV_8UC3);
 
-    /*
-    out << "stippledImageRows: " << stippledImageRows << endl;
-    out << "stippledImageCols: " << stippledImageCols << endl;
-    out << "tileHeight: " << tileHeight << endl;
-    out << "tileWidth: " << tileWidth << endl;
-    out << "iMax: " << iMax << endl;
-    out << "jMax: " << jMax << endl;
-    */
+        cv::Mat tile;
+        tile.create(tileHeight, tileWidth, CV_8UC3);
 
-    for(int i=0; i<iMax; ++i) // Tile matrix Rows
-    {
-        for(int j=0; j<jMax; ++j) // Tile matrix Columns
+
+        /*
+        out << "stippledImageRows: " << stippledImageRows << endl;
+        out << "stippledImageCols: " << stippledImageCols << endl;
+        out << "tileHeight: " << tileHeight << endl;
+        out << "tileWidth: " << tileWidth << endl;
+        out << "iMax: " << iMax << endl;
+        out << "jMax: " << jMax << endl;
+        */
+
+        for(int i=0; i<iMax; ++i) // Tile matrix Rows
         {
-            //out << "i: " << i << endl;
-            //out << "j: " << j << endl;
+            for(int j=0; j<jMax; ++j) // Tile matrix Columns
+            {
+                //out << "i: " << i << endl;
+                //out << "j: " << j << endl;
 
-            // Set the projection/view so the scene rendered is the appropiate tile.
-            tiling_cameraDistance = 0.0f;
+                // Set the projection/view so the scene rendered is the appropiate tile.
+                tiling_cameraDistance = 0.0f;
 
-            tiling_zNear = tiling_cameraDistance - 100.0f;
-            tiling_zFar = tiling_cameraDistance + 100.0f;
+                tiling_zNear = tiling_cameraDistance - 100.0f;
+                tiling_zFar = tiling_cameraDistance + 100.0f;
 
-            tiling_cameraPosX = tileWidth/2.0f;
-            tiling_cameraPosY = tileHeight/2.0f;
+                tiling_cameraPosX = tileWidth/2.0f;
+                tiling_cameraPosY = tileHeight/2.0f;
 
-            tiling_cameraPosOffsetX = j * tileWidth;
-            tiling_cameraPosOffsetY = i * tileHeight;
+                tiling_cameraPosOffsetX = j * tileWidth;
+                tiling_cameraPosOffsetY = i * tileHeight;
 
-            //out << "tiling_cameraPosOffsetX: " << tiling_cameraPosOffsetX << endl;
-            //out << "tiling_cameraPosOffsetY: " << tiling_cameraPosOffsetY << endl;
+                //out << "tiling_cameraPosOffsetX: " << tiling_cameraPosOffsetX << endl;
+                //out << "tiling_cameraPosOffsetY: " << tiling_cameraPosOffsetY << endl;
 
-            // Activate the tiling fbo so all rendering occurs off screen.
-            fboTiling->renderFBO();
+                // Activate the tiling fbo so all rendering occurs off screen.
+                fboTiling->renderFBO();
 
-            // Render the tile.
-            paintScene(false, true);
+                // Render the tile.
+                paintScene(false, true);
 
-            // Read the pixels and store them in the tile image.
-            glFlush();
-            glFinish();
-            glPixelStorei(GL_PACK_ALIGNMENT, 1);
-            glPixelStorei(GL_PACK_ROW_LENGTH, tile.step/tile.elemSize());
-            glReadPixels(0, 0, tile.cols, tile.rows, GL_BGR, GL_UNSIGNED_BYTE, tile.data);
+                // Read the pixels and store them in the tile image.
+                glFlush();
+                glFinish();
+                glPixelStorei(GL_PACK_ALIGNMENT, 1);
+                glPixelStorei(GL_PACK_ROW_LENGTH, tile.step/tile.elemSize());
+                glReadPixels(0, 0, tile.cols, tile.rows, GL_BGR, GL_UNSIGNED_BYTE, tile.data);
 
-            // Deactivate the tiling fbo so all rendering occurs on screen.
-            fboTiling->renderFramebuffer();
+                // Deactivate the tiling fbo so all rendering occurs on screen.
+                fboTiling->renderFramebuffer();
 
 
-            cv::Mat flipped;
-            cv::flip(tile, flipped, 0);
+                cv::Mat flipped;
+                cv::flip(tile, flipped, 0);
 
-            cv::Mat mirrored;
-            cv::flip(flipped, mirrored, 1);
+                cv::Mat mirrored;
+                cv::flip(flipped, mirrored, 1);
 
-            /*
-            std::stringstream tileName;
-            tileName << "tile" << ((i*jMax)+j) << ".png";
-            out << "Writing " << QString::fromStdString(tileName.str()) << " to disc." << endl;
-            imwrite(tileName.str(), mirrored);
-            */
+                /*
+                std::stringstream tileName;
+                tileName << "tile" << ((i*jMax)+j) << ".png";
+                out << "Writing " << QString::fromStdString(tileName.str()) << " to disc." << endl;
+                imwrite(tileName.str(), mirrored);
+                */
 
-            //out << "tile.cols: " << tile.cols << endl;
-            //out << "tile.rows: " << tile.rows << endl;
+                //out << "tile.cols: " << tile.cols << endl;
+                //out << "tile.rows: " << tile.rows << endl;
 
-            // Copy the data from the tile in the right area of the full resolution scene image.
-            cv::Mat cropped = fullResolutionScene(cv::Rect(tiling_cameraPosOffsetX, tiling_cameraPosOffsetY, mirrored.cols, mirrored.rows));
-            mirrored.copyTo(cropped);
+                // Copy the data from the tile in the right area of the full resolution scene image.
+                cv::Mat cropped = fullResolutionScene(cv::Rect(tiling_cameraPosOffsetX, tiling_cameraPosOffsetY, mirrored.cols, mirrored.rows));
+                mirrored.copyTo(cropped);
 
-            //out << "Completed tile " << (((i*jMax)+j)+1) << " out of " << (iMax * jMax) << " tiles." << endl;
+                //out << "Completed tile " << (((i*jMax)+j)+1) << " out of " << (iMax * jMax) << " tiles." << endl;
+            }
         }
-    }
 
-    delete fboTiling;
-    fboTiling = 0;
+        delete fboTiling;
+        fboTiling = 0;
 
-    // Crop the unrelevant parts (rendered over a larger area for simplicity's sake)
-    cv::Mat cropped = fullResolutionScene(cv::Rect(0, 0, stippledImageCols, stippledImageRows));
+        stage.addItems(iMax * jMax);
+    }
 
-    // Flip the image to correct the different coordinate systems that OpenGL and OpenCV use.
     cv::Mat stippledImage;
-    cv::flip(cropped, stippledImage, 0);
+    bool written;
+    {
+        StageProfiler::ScopedStage stage(_profiler, StageProfiler::EXPORT);
 
-    imwrite(fileName.toStdString(), stippledImage);
+        // Crop the unrelevant parts (rendered over a larger area for simplicity's sake)
+        cv::Mat cropped = fullResolutionScene(cv::Rect(0, 0, stippledImageCols, stippledImageRows));
+
+        // Flip the image to correct the different coordinate systems that OpenGL and OpenCV use.
+        cv::flip(cropped, stippledImage, 0);
+
+        written = imwrite(fileName.toStdString(), stippledImage);
+
+        stage.addItems(qint64(stippledImage.rows) * stippledImage.cols);
+    }
 
     out << "Tile rendering process ended." << endl;
 
-    imshow("Generated image", stippledImage);
+    if(!written)
+    {
+        out << "Error: the stippled image " << fileName << " could not be written." << endl;
+        return false;
+    }
+
+    if(showResult)
+    {
+        imshow("Generated image", stippledImage);
+    }
+
+    return true;
 }
 
 
@@ -1324,6 +1763,7 @@ void GLWidgetStippling::reApplyConfiguration()
     // the configuration is changed and accepted.
 
     _renderUsingMultipleTiles = _configuration->useTileRendering();
+    _previewStippleDotDispersion = -1;
     if(_stipplingPerformedAtLeastOnce)
     {
         if(_renderUsingMultipleTiles)
@@ -1341,7 +1781,174 @@ void GLWidgetStippling::reApplyConfiguration()
 
 
 
+void GLWidgetStippling::previewStippleDotDispersion(unsigned int stippleDotDispersion)
+{
+    if(!_gpuDispersionAvailable)
+    {
+        return;
+    }
+
+    _previewStippleDotDispersion = int(stippleDotDispersion);
+
+    // Only the visible dots are drawn again, the tiles are rendered once the dispersion is accepted.
+    if(_stipplingPerformedAtLeastOnce && !_renderUsingMultipleTiles)
+    {
+        singleTileRenderCurrentScene();
+    }
+}
+
+void GLWidgetStippling::endStippleDotDispersionPreview()
+{
+    if(_previewStippleDotDispersion < 0)
+    {
+        return;
+    }
+    _previewStippleDotDispersion = -1;
+
+    if(_stipplingPerformedAtLeastOnce && !_renderUsingMultipleTiles)
+    {
+        singleTileRenderCurrentScene();
+    }
+}
+
 void GLWidgetStippling::setEntityTreeController(EntityTreeController * entities)
 {
     _entities = entities;
 }
+
+void GLWidgetStippling::setProfiler(StageProfiler * profiler)
+{
+    _profiler = profiler;
+}
+
+void GLWidgetStippling::setIntermediateCache(IntermediateCache * cache)
+{
+    _intermediateCache = cache;
+}
+
+bool GLWidgetStippling::saveStippledImageAsSVG(QString fileName)
+{
+    if(_stipplingDots == 0 || isStippling())
+    {
+        out << "Error: there are no stipple dots to be exported." << endl;
+        return false;
+    }
+
+    StageProfiler::ScopedStage stage(_profiler, StageProfiler::EXPORT);
+
+    // Offsets computed on the GPU replace the stored ones, so they are stored in the dots
+    // meanwhile (the same ones, by construction).
+    bool gpuDispersion = _gpuDispersionAvailable &&
+            (_previewStippleDotDispersion >= 0 || _configuration->gpuStippleDotDispersion());
+    unsigned int cpuDispersion = _cpuStippleDotDispersion;
+    if(gpuDispersion)
+    {
+        unsigned int dispersion = _previewStippleDotDispersion >= 0 ? (unsigned int)_previewStippleDotDispersion
+                                                                    : _configuration->stippleDotDispersion();
+        disperseStippleDots(dispersion / 10);
+    }
+
+    bool written = SVGStippleExporter::write(fileName, _stipplingDots, _spriteAtlas, _backgroundColor);
+
+    if(gpuDispersion)
+    {
+        disperseStippleDots(cpuDispersion);
+    }
+
+    stage.addItems(1);
+
+    return written;
+}
+
+unsigned int GLWidgetStippling::cpuStippleDotDispersion() const
+{
+    return _cpuStippleDotDispersion;
+}
+
+bool GLWidgetStippling::saveStipplingDots(QString fileName)
+{
+    if(_stipplingDots == 0 || isStippling())
+    {
+        out << "Error: there are no stipple dots to be saved." << endl;
+        return false;
+    }
+
+    DotSetInfo info;
+    info.imageSize = _stippledPhotographSize;
+    info.area = _stipplingDots->getRootArea();
+    info.spriteSize = _spriteAtlas.spriteSize();
+    info.matrixSize = glm::ivec2(_spriteAtlas.matrixSize());
+    info.rngSeed = _configuration->rngSeed();
+    info.dispersion = _cpuStippleDotDispersion;
+    info.configurationHash = DotSetFile::configurationHash(*_configuration);
+
+    return DotSetFile::save(fileName, _stipplingDots, info);
+}
+
+bool GLWidgetStippling::loadStipplingDots(QString fileName)
+{
+    DotSetInfo info;
+    QuadTree * dots = readStipplingDots(fileName, info);
+    if(dots == 0)
+    {
+        return false;
+    }
+
+    showStipplingDots(dots, info);
+
+    return true;
+}
+
+QuadTree * GLWidgetStippling::readStipplingDots(QString fileName, DotSetInfo & info)
+{
+    if(isStippling())
+    {
+        out << "Error: the stipple dots are being generated." << endl;
+        return 0;
+    }
+
+    QuadTree * dots = DotSetFile::load(fileName, info, DotGenerationWorker::QUADTREE_DEPTH);
+    if(dots == 0)
+    {
+        return 0;
+    }
+
+    if(info.spriteSize != _spriteAtlas.spriteSize() || info.matrixSize != glm::ivec2(_spriteAtlas.matrixSize()))
+    {
+        out << "Error: the dot set " << fileName << " was generated with a different sprite atlas." << endl;
+        delete dots;
+        return 0;
+    }
+
+    if(info.configurationHash != DotSetFile::configurationHash(*_configuration))
+    {
+        out << "The dot set " << fileName << " was generated with a different configuration." << endl;
+    }
+
+    return dots;
+}
+
+void GLWidgetStippling::showStipplingDots(QuadTree * dots, const DotSetInfo & info)
+{
+    // The dots can not be generated again incrementally, they do not come from the last worker.
+    if(_dotGenerationWorker != 0)
+    {
+        delete _dotGenerationWorker;
+        _dotGenerationWorker = 0;
+    }
+
+    _isStipplingTextureReady = false;
+    resetViewingTransformations();
+
+    if(_fboStipplingToTexture != 0)
+    {
+        delete _fboStipplingToTexture;
+        _fboStipplingToTexture = 0;
+    }
+
+    _stippledPhotographSize = info.imageSize;
+
+    // The offsets are already in the dots.
+    setStipplingDots(dots, true);
+    _cpuStippleDotDispersion = info.dispersion;
+}
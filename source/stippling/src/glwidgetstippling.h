@@ -45,6 +45,7 @@
 #include <QFile>
 #include <QString>
 #include <QThread>
+#include <QTimer>
 
 
 #include <opencv2/core/core.hpp>
@@ -64,6 +65,10 @@
 #include "dotgenerationworker.h"
 #include "configuration.h"
 #include "entitytreecontroller.h"
+#include "stageprofiler.h"
+#include "dotsetfile.h"
+#include "spriteatlas.h"
+#include "svgstippleexporter.h"
 
 
 
@@ -82,6 +87,9 @@ private:
     GLuint stippleShaderID;
     GLuint xyColorShaderID;
     GLuint xzColorShaderID;
+    GLuint stippleDotShaderID; /**< Draws the sprites, applying the dispersion offsets when asked to. */
+    GLuint _directionsTextureID; /**< Unit vector of every integer angle in degrees (360 GL_RG32F texels), read by the dispersion. */
+    bool _gpuDispersionAvailable; /**< False if the dispersion shader could not be linked: the dots are dispersed on the CPU then. */
 
     // Uniform id
     GLuint matrixID;
@@ -164,15 +172,27 @@ private:
 
 
 
-    QVector<GLEntity> sprites;
+    SpriteAtlas _spriteAtlas;
+    GLEntity _spriteQuad; /**< Quad of a dot, shared by every sprite (the shader picks the cell of the atlas). */
 
-    glm::vec2 spriteSize;
-    glm::vec2 spritesMatrixSize;
-
-    cv::Mat spritesImg;
+    /**
+     * @brief Attributes of a dot drawn as an instance of the sprite quad.
+     */
+    struct DotInstance
+    {
+        GLfloat position[2]; /**< Bottom left corner of the quad. */
+        GLfloat uvRect[4]; /**< Cell of the sprite in the atlas: left, top, width and height. */
+        GLuint random[2]; /**< Random number of the dot (low and high halves), for the GPU dispersion. */
+        GLint useDispersion; /**< 0 if the dot must stay where it was generated. */
+    };
+    GLuint _dotInstanceBuffer; /**< Instances of the sprite quad drawn by paintScene, one DotInstance per dot. */
+    QVector<DotInstance> _dotInstances; /**< Filled by paintScene, kept between frames so it is not reallocated. */
     GLuint spritesTextureID;
 
     QuadTree * _stipplingDots;
+    unsigned int _cpuStippleDotDispersion; /**< Dispersion (in pixels) of the offsets stored in the dots, 0 if none. */
+    int _previewStippleDotDispersion; /**< Dispersion being previewed on the GPU, -1 if none. */
+    glm::ivec2 _stippledPhotographSize; /**< Columns and rows of the photograph the dots come from. */
     bool stipplingMode;
     int stippledImageRows;
     int stippledImageCols;
@@ -180,6 +200,8 @@ private:
 
     QThread * _dotGenerationWorkerThread;
     DotGenerationWorker * _dotGenerationWorker;
+    QTimer * _generationPreviewTimer; /**< Collects the dots generated so far while a worker runs. */
+    bool _isPreviewingGeneration; /**< The dots being rendered are a partial copy of the ones being generated. */
 
     Configuration * _configuration;
 
@@ -203,6 +225,10 @@ private:
 
     EntityTreeController * _entities;
 
+    StageProfiler * _profiler;
+
+    IntermediateCache * _intermediateCache; /**< Handed to the dot generation workers. Not owned. */
+
 private:
 
     cv::Mat fboTexturetoImage(S3DFBO * fbo, int height, int width);
@@ -211,18 +237,28 @@ private:
 
     void glSetup();
 
-    GLuint prepareShaderProgram(const QString& vertexShaderPath, const QString& fragmentShaderPath);
+    /**
+     * @param required If true the application exits when the program can not be built, otherwise 0 is returned.
+     */
+    GLuint prepareShaderProgram(const QString& vertexShaderPath, const QString& fragmentShaderPath, bool required = true);
 
     void initializeAxes();
 
-    void initializeSprite(GLEntity & dot, glm::vec2 spriteSize,
-                          glm::vec2 spritesMatrixSize,
-                          glm::vec2 spritesMatrixPosition);
+    void initializeSpriteQuad();
 
+    /**
+     * @brief Loads the default sprite atlas and its texture.
+     */
     void initializeSprites();
 
     void initializeStipplingTextureHolder(int rows, int cols);
 
+    /**
+     * @brief Applies the dispersion offsets to every stipple dot on the CPU.
+     * @param dispersion Maximum offset, in pixels (0 removes the offsets).
+     */
+    void disperseStippleDots(unsigned int dispersion);
+
 public:
 
     bool isImageLoaded() const;
@@ -249,12 +285,92 @@ public:
 
     void tileRenderCurrentScene();
 
+    /**
+     * @brief Generates the stipple dots of an image.
+     * @param toStipple Image to be stippled.
+     * @param ditheringMethod Dithering applied before generating the dots.
+     * @param solid3DModel Solid rendering of the CSG tree (same size as the image).
+     * @param sceneKey Key of the solid renderings (see GLWidget3DEngine::sceneKey), used to cache the edge images.
+     * @param runInBackground If true the dots are generated in a worker thread and
+     * stippleImageEnded is called once done, otherwise the call blocks until the dots are rendered.
+     * In the background the dots are rendered as they are generated, and the generation can be cancelled.
+     */
     void stippleImage(cv::Mat toStipple, DotGenerationWorker::DitheringMethod ditheringMethod,
-                      cv::Mat solid3DModel);
+                      cv::Mat solid3DModel, const QByteArray & sceneKey, bool runInBackground = true);
+
+    /**
+     * @brief True while the dots are being generated in the background.
+     */
+    bool isStippling() const;
+
+    /**
+     * @brief True if there are stipple dots to be rendered (and no dots are being generated).
+     */
+    bool hasStipplingDots() const;
+
+    /**
+     * @brief Replaces the stipple dots being rendered (the former ones are deleted).
+     * @param stipplingDots Dots generated by a DotGenerationWorker, the widget takes their ownership. May be 0.
+     * @param renderTextures If true the preview textures are rendered and the widget repainted,
+     * which is not needed to save the stippled image to disk.
+     */
+    void setStipplingDots(QuadTree * stipplingDots, bool renderTextures);
+
+    glm::vec2 getSpriteSize() const;
+    glm::vec2 getSpritesMatrixSize() const;
+
+    /**
+     * @brief Sprites the dots are drawn with.
+     */
+    const SpriteAtlas & spriteAtlas() const;
+
+    /**
+     * @brief Draws the dots with the sprites of another atlas (@see SpriteAtlas).
+     * The current dots are discarded if their sprites do not fit in the new atlas.
+     * @return False (after printing why) if the atlas could not be loaded or the dots are being generated.
+     */
+    bool loadSpriteAtlas(QString descriptorFile);
 
 public slots:
     void stippleImageEnded();
 
+    /**
+     * @brief Stops the dot generation running in the background, if any. The dots generated so far are discarded.
+     */
+    void cancelStippling();
+
+    /**
+     * @brief Generates again the dots of the pixels covered by an entity, after its specific
+     * configuration changed, and renders them. The rest of the dots are kept.
+     */
+    void restippleEntity(EntityTreeNode * node);
+
+    /**
+     * @brief Draws the stippled image with the given dispersion, computed on the GPU, until
+     * the configuration is applied again or the preview ends. Nothing is previewed without the
+     * dispersion shader.
+     * @param stippleDotDispersion Dispersion, as set on the configuration.
+     */
+    void previewStippleDotDispersion(unsigned int stippleDotDispersion);
+
+    /**
+     * @brief Draws the stippled image with the configured dispersion again.
+     */
+    void endStippleDotDispersionPreview();
+
+private slots:
+    /**
+     * @brief Adds the dots completed by the worker since the last call to the ones being rendered, and renders them.
+     */
+    void collectGeneratedDots();
+
+signals:
+    /**
+     * @brief Emitted once a dot generation ends.
+     * @param completed False if it was cancelled.
+     */
+    void stipplingEnded(bool completed);
+
 
 
 
@@ -285,10 +401,57 @@ public:
 
 
 
+    /**
+     * @brief Applies the configured dispersion to the stipple dots and renders them again.
+     * If the GPU dispersion is enabled the offsets are computed by the vertex shader as the
+     * dots are drawn, and the CPU pass is skipped.
+     */
     void applyStippleDotDispersion();
 
 
-    void saveStippledImageToDisk(QString fileName);
+    /**
+     * @brief Renders the stippled image at full resolution and writes it to disk.
+     * @param fileName Output image file.
+     * @param showResult If true the written image is also shown in a window.
+     * @return False (after printing why) if the image could not be written.
+     */
+    bool saveStippledImageToDisk(QString fileName, bool showResult = true);
+
+    /**
+     * @brief Writes the stippled image as a SVG document (see SVGStippleExporter), with the current dispersion.
+     * @return False (after printing why) if there are no dots or the file could not be written.
+     */
+    bool saveStippledImageAsSVG(QString fileName);
+
+    /**
+     * @brief Dispersion (in pixels) of the offsets stored in the dots, 0 if none (or computed on the GPU).
+     */
+    unsigned int cpuStippleDotDispersion() const;
+
+    /**
+     * @brief Writes the stipple dots, with their offsets, to a dot set file (see DotSetFile).
+     * @return False (after printing why) if there are no dots or the file could not be written.
+     */
+    bool saveStipplingDots(QString fileName);
+
+    /**
+     * @brief Replaces the stipple dots by the ones of a dot set file (see DotSetFile) and renders them.
+     * @return False (after printing why) if the dots are being generated or the file could not be read.
+     */
+    bool loadStipplingDots(QString fileName);
+
+    /**
+     * @brief Reads and checks a dot set file (see loadStipplingDots) without changing the current dots.
+     * @param info Receives the description of the dot set.
+     * @return The dots (the caller takes their ownership, or hands them to showStipplingDots), or 0
+     * (after printing why) if the dots are being generated or the file could not be used.
+     */
+    QuadTree * readStipplingDots(QString fileName, DotSetInfo & info);
+
+    /**
+     * @brief Replaces the stipple dots by the ones read by readStipplingDots and renders them.
+     */
+    void showStipplingDots(QuadTree * dots, const DotSetInfo & info);
 
 
 
@@ -298,6 +461,16 @@ public:
 
 
     void setEntityTreeController(EntityTreeController * entities);
+
+    /**
+     * @brief Attaches a profiler (0 to detach), which will receive the dispersion, tile render and export measures.
+     */
+    void setProfiler(StageProfiler * profiler);
+
+    /**
+     * @brief Sets the cache of the dithered and edge images (0, the default, disables it).
+     */
+    void setIntermediateCache(IntermediateCache * cache);
 };
 
 
@@ -0,0 +1,206 @@
+/**
+ * @file intermediatecache.cpp
+ * @brief IntermediateCache class source file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#include "intermediatecache.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryFile>
+#include <QDesktopServices>
+#include <QMutexLocker>
+
+#include <cstring>
+
+#include "util.h"
+
+static const char CACHE_MAGIC[8] = {'S', 'T', 'P', 'L', 'M', 'A', 'T', '1'};
+
+IntermediateCache::Key::Key(const QString & kind) : _hash(QCryptographicHash::Sha1)
+{
+    add(kind);
+}
+
+IntermediateCache::Key & IntermediateCache::Key::add(const QByteArray & data)
+{
+    // The length avoids ambiguities between consecutive inputs.
+    add(data.size());
+    _hash.addData(data);
+    return *this;
+}
+
+IntermediateCache::Key & IntermediateCache::Key::add(const QString & text)
+{
+    return add(text.toUtf8());
+}
+
+IntermediateCache::Key & IntermediateCache::Key::add(int value)
+{
+    qint32 data = value;
+    _hash.addData(reinterpret_cast<const char *>(&data), sizeof(data));
+    return *this;
+}
+
+IntermediateCache::Key & IntermediateCache::Key::add(float value)
+{
+    _hash.addData(reinterpret_cast<const char *>(&value), sizeof(value));
+    return *this;
+}
+
+IntermediateCache::Key & IntermediateCache::Key::add(const glm::mat4 & matrix)
+{
+    _hash.addData(reinterpret_cast<const char *>(glm::value_ptr(matrix)), 16 * sizeof(float));
+    return *this;
+}
+
+IntermediateCache::Key & IntermediateCache::Key::add(const cv::Mat & image)
+{
+    add(image.rows);
+    add(image.cols);
+    add(image.type());
+
+    int rowSize = image.cols * int(image.elemSize());
+    for(int row=0; row<image.rows; ++row)
+    {
+        _hash.addData(reinterpret_cast<const char *>(image.ptr(row)), rowSize);
+    }
+    return *this;
+}
+
+QByteArray IntermediateCache::Key::result() const
+{
+    return _hash.result().toHex();
+}
+
+IntermediateCache::IntermediateCache(const QString & directory, qint64 maxSize)
+{
+    _directory = directory;
+    _maxSize = maxSize;
+}
+
+QString IntermediateCache::defaultDirectory()
+{
+    return QDir(QDesktopServices::storageLocation(QDesktopServices::CacheLocation)).filePath("intermediates");
+}
+
+QString IntermediateCache::directory() const
+{
+    return _directory;
+}
+
+QString IntermediateCache::filePath(const QByteArray & key) const
+{
+    return QDir(_directory).filePath(QString::fromLatin1(key) + ".mat");
+}
+
+bool IntermediateCache::load(const QByteArray & key, cv::Mat & image) const
+{
+    QFile file(filePath(key));
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    qint64 size = file.size();
+    if(size < HEADER_SIZE)
+    {
+        return false;
+    }
+
+    uchar * data = file.map(0, size);
+    if(data == 0)
+    {
+        return false;
+    }
+
+    Header header;
+    memcpy(&header, data, sizeof(header));
+
+    bool valid = memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+                 header.rows >= 0 && header.cols >= 0 && CV_MAT_TYPE(header.type) == header.type &&
+                 size == HEADER_SIZE + qint64(header.rows) * header.cols * CV_ELEM_SIZE(header.type);
+    if(valid)
+    {
+        // The mapping ends with the file, so the pixels are copied once, straight from the mapped pages.
+        image = cv::Mat(header.rows, header.cols, header.type, data + HEADER_SIZE).clone();
+    }
+
+    file.unmap(data);
+
+    return valid;
+}
+
+bool IntermediateCache::store(const QByteArray & key, const cv::Mat & image)
+{
+    if(!QDir().mkpath(_directory))
+    {
+        out << "Error: the cache directory " << _directory << " could not be created." << endl;
+        return false;
+    }
+
+    cv::Mat continuous = image.isContinuous() ? image : image.clone();
+
+    char headerData[HEADER_SIZE];
+    memset(headerData, 0, HEADER_SIZE);
+    Header header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.rows = continuous.rows;
+    header.cols = continuous.cols;
+    header.type = continuous.type();
+    header.reserved = 0;
+    memcpy(headerData, &header, sizeof(header));
+
+    QTemporaryFile file(QDir(_directory).filePath("XXXXXX.tmp"));
+    qint64 dataSize = qint64(continuous.total()) * continuous.elemSize();
+    bool written = file.open() &&
+                   file.write(headerData, HEADER_SIZE) == HEADER_SIZE &&
+                   file.write(reinterpret_cast<const char *>(continuous.data), dataSize) == dataSize;
+    if(!written)
+    {
+        out << "Error: the cache file " << file.fileName() << " could not be written." << endl;
+        return false;
+    }
+    file.close();
+
+    // Another thread or process may have stored the same image meanwhile, then this copy is dropped.
+    file.setAutoRemove(false);
+    QString temporaryName = file.fileName();
+    if(!QFile::rename(temporaryName, filePath(key)))
+    {
+        QFile::remove(temporaryName);
+    }
+
+    prune();
+
+    return true;
+}
+
+void IntermediateCache::prune()
+{
+    QMutexLocker locker(&_pruneMutex);
+
+    QDir dir(_directory);
+    QFileInfoList files = dir.entryInfoList(QStringList("*.mat"), QDir::Files, QDir::Time | QDir::Reversed);
+
+    qint64 size = 0;
+    foreach(const QFileInfo & file, files)
+    {
+        size += file.size();
+    }
+
+    // Oldest first. Files removed by someone else meanwhile are just skipped.
+    for(int i=0; i<files.size() && size > _maxSize; ++i)
+    {
+        QFile::remove(files[i].filePath());
+        size -= files[i].size();
+    }
+}
@@ -0,0 +1,130 @@
+/**
+ * @file intermediatecache.h
+ * @brief IntermediateCache class header file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#ifndef INTERMEDIATECACHE_H
+#define INTERMEDIATECACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QMutex>
+
+#include <opencv2/core/core.hpp>
+
+#include <glm/glm.hpp>
+
+/**
+ * @brief IntermediateCache class.
+ * Directory of images produced by the stippling pipeline (solid renderings, dithered images and
+ * edge masks), keyed by a hash of everything they were computed from, so that they survive from
+ * one run to the next. Each image is a file holding a fixed size header followed by its rows,
+ * which is memory mapped to be read back.
+ * When the directory grows over its maximum size the oldest files are removed.
+ * Every method can be called from any thread.
+ */
+class IntermediateCache
+{
+public:
+    static const qint64 DEFAULT_MAX_SIZE = Q_INT64_C(2048) * 1024 * 1024; /**< 2 GB. */
+
+    /**
+     * @brief Builds the key of a cached image by hashing (SHA-1) its kind and its inputs.
+     */
+    class Key
+    {
+    private:
+        QCryptographicHash _hash;
+
+        // Not copyable.
+        Key(const Key &);
+        Key & operator=(const Key &);
+
+    public:
+        /**
+         * @param kind Name of the stage that produces the image.
+         */
+        Key(const QString & kind);
+
+        Key & add(const QByteArray & data);
+        Key & add(const QString & text);
+        Key & add(int value);
+        Key & add(float value);
+        Key & add(const glm::mat4 & matrix);
+
+        /**
+         * @brief Adds the size, type and pixels of an image.
+         */
+        Key & add(const cv::Mat & image);
+
+        /**
+         * @return The key, as hexadecimal text.
+         */
+        QByteArray result() const;
+    };
+
+private:
+    /**
+     * @brief Header of a cached image file. The pixels start at HEADER_SIZE, without padding between rows.
+     */
+    struct Header
+    {
+        char magic[8];
+        qint32 rows;
+        qint32 cols;
+        qint32 type; /**< OpenCV type (depth and channels). */
+        qint32 reserved;
+    };
+
+    static const int HEADER_SIZE = 32; /**< Header plus padding, so the pixels are aligned. */
+
+    QString _directory;
+    qint64 _maxSize;
+
+    QMutex _pruneMutex;
+
+    QString filePath(const QByteArray & key) const;
+
+    /**
+     * @brief Removes the oldest files until the directory fits in its maximum size.
+     */
+    void prune();
+
+public:
+    /**
+     * @param directory Directory of the cache, created when the first image is stored.
+     * @param maxSize Maximum size of the directory, in bytes.
+     */
+    IntermediateCache(const QString & directory = defaultDirectory(), qint64 maxSize = DEFAULT_MAX_SIZE);
+
+    /**
+     * @brief Per user cache directory of the application.
+     */
+    static QString defaultDirectory();
+
+    QString directory() const;
+
+    /**
+     * @brief Reads a cached image.
+     * @param key Key of the image.
+     * @param image Receives a copy of the image (untouched if it is not cached).
+     * @return True if the image was cached and its file is valid.
+     */
+    bool load(const QByteArray & key, cv::Mat & image) const;
+
+    /**
+     * @brief Caches an image. The file is written aside and renamed, so readers never see it half written.
+     * @return False (after printing why) if the image could not be written.
+     */
+    bool store(const QByteArray & key, const cv::Mat & image);
+};
+
+#endif // INTERMEDIATECACHE_H
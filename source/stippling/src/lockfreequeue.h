@@ -0,0 +1,90 @@
+/**
+ * @file lockfreequeue.h
+ * @brief LockFreeQueue class header file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#ifndef LOCKFREEQUEUE_H
+#define LOCKFREEQUEUE_H
+
+#include <QAtomicPointer>
+#include <QList>
+#include <QtAlgorithms>
+
+/**
+ * @brief LockFreeQueue class.
+ * Unbounded queue that hands items from producer threads to a single consumer without locks,
+ * so a producer never waits for the consumer. The items are pushed on an atomic list, and the
+ * consumer detaches the whole list at once (there is no single item pop, so no ABA problem).
+ * The queue owns the items it holds; takeAll transfers them to the caller.
+ */
+template <typename T>
+class LockFreeQueue
+{
+private:
+    struct Node
+    {
+        T * item;
+        Node * next;
+    };
+
+    QAtomicPointer<Node> _head; /**< Last pushed item, 0 if empty. */
+
+    // Not copyable.
+    LockFreeQueue(const LockFreeQueue &);
+    LockFreeQueue & operator=(const LockFreeQueue &);
+
+public:
+    LockFreeQueue() : _head(0)
+    {
+    }
+
+    ~LockFreeQueue()
+    {
+        qDeleteAll(takeAll());
+    }
+
+    /**
+     * @brief Adds an item (the queue takes its ownership). Safe to call from any thread.
+     */
+    void push(T * item)
+    {
+        Node * node = new Node;
+        node->item = item;
+
+        Node * head;
+        do
+        {
+            head = _head;
+            node->next = head;
+        } while(!_head.testAndSetRelease(head, node));
+    }
+
+    /**
+     * @brief Removes every item, in the order they were pushed (the caller takes their ownership).
+     * Only one thread may consume.
+     */
+    QList<T *> takeAll()
+    {
+        Node * node = _head.fetchAndStoreAcquire(0);
+
+        QList<T *> items;
+        while(node != 0)
+        {
+            items.prepend(node->item);
+            Node * next = node->next;
+            delete node;
+            node = next;
+        }
+
+        return items;
+    }
+};
+
+#endif // LOCKFREEQUEUE_H
@@ -31,6 +31,9 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->stippling_openGLViewport->setEntityTreeController(&entities);
     ui->superiorView_openGLViewport->setEntityTreeController(&entities);
 
+    ui->openGLViewport->setIntermediateCache(&_intermediateCache);
+    ui->stippling_openGLViewport->setIntermediateCache(&_intermediateCache);
+
     maxWidth_glWidget = 800;
     maxHeight_glWidget = 600;
 
@@ -67,8 +70,13 @@ MainWindow::MainWindow(QWidget *parent) :
     // Stippling menu
     connect(ui->actionWith_Floyd_Steinberg_dithering, SIGNAL(triggered()), this, SLOT(startStipplingProcessFloydSteinbergDithering()));
     connect(ui->actionWith_Stucki_dithering, SIGNAL(triggered()), this, SLOT(startStipplingProcessStuckiDithering()));
+    connect(ui->actionCancel_stippling, SIGNAL(triggered()), ui->stippling_openGLViewport, SLOT(cancelStippling()));
+    connect(ui->stippling_openGLViewport, SIGNAL(stipplingEnded(bool)), this, SLOT(stipplingEnded(bool)));
     connect(ui->actionRe_apply_Stipple_Dot_dispersion, SIGNAL(triggered()), this, SLOT(reApplyStipplingDotDispersion()));
     connect(ui->actionGenerate_final_image, SIGNAL(triggered()), this, SLOT(generateFinalImage()));
+    connect(ui->actionSave_dot_set, SIGNAL(triggered()), this, SLOT(saveDotSet()));
+    connect(ui->actionOpen_dot_set, SIGNAL(triggered()), this, SLOT(openDotSet()));
+    connect(ui->actionOpen_sprite_atlas, SIGNAL(triggered()), this, SLOT(openSpriteAtlas()));
 
     // Top bar
     connect(ui->selectionToolButton, SIGNAL(released()), this, SLOT(selectionTool()));
@@ -90,6 +98,7 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(&entities, SIGNAL(modifiedTree()), ui->superiorView_openGLViewport, SLOT(update()));
     connect(&entities, SIGNAL(modifiedInformation()), ui->openGLViewport, SLOT(updateGL()));
     connect(&entities, SIGNAL(modifiedInformation()), ui->treeWidget_Entities, SLOT(updateSelected()));
+    connect(&entities, SIGNAL(modifiedConfiguration(EntityTreeNode*)), ui->stippling_openGLViewport, SLOT(restippleEntity(EntityTreeNode*)));
     connect(&entities, SIGNAL(modifiedInformation()), ui->superiorView_openGLViewport, SLOT(update()));
 
 
@@ -152,6 +161,8 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->menuGenerate_and_render->setEnabled(false);
     ui->actionRe_apply_Stipple_Dot_dispersion->setEnabled(false);
     ui->actionGenerate_final_image->setEnabled(false);
+    ui->actionCancel_stippling->setEnabled(false);
+    ui->actionSave_dot_set->setEnabled(false);
 
 }
 
@@ -503,6 +514,11 @@ void MainWindow::openConfigurationDialog()
     configDialog->activateWindow();
 
     connect( configDialog, SIGNAL(accepted()), this, SLOT(updateConfiguration()) );
+
+    // With the GPU dispersion the stippled image follows the dispersion while it is being tuned.
+    connect( configDialog, SIGNAL(stippleDotDispersionPreviewed(unsigned int)),
+             ui->stippling_openGLViewport, SLOT(previewStippleDotDispersion(unsigned int)) );
+    connect( configDialog, SIGNAL(rejected()), ui->stippling_openGLViewport, SLOT(endStippleDotDispersionPreview()) );
 }
 
 void MainWindow::updateConfiguration()
@@ -798,9 +814,36 @@ void MainWindow::startStipplingProcessStuckiDithering()
 
 void MainWindow::startStipplingProcess(DotGenerationWorker::DitheringMethod method)
 {
-    ui->openGLViewport->generateSolidRenderings();
-    cv::Mat solidRendering = ui->openGLViewport->renderSceneToImageAsSolidAllIlluminated();
+    // The renderings use the finest tessellation, editing goes back to a coarse one afterwards.
+    // A scene rendered before is read from the cache instead, without tessellating it again.
+    cv::Mat solidRendering;
+    if(!ui->openGLViewport->loadCachedSolidRenderings(solidRendering))
+    {
+        ui->openGLViewport->applyLevelOfDetail(FINE_LOD);
+        ui->openGLViewport->generateSolidRenderings();
+        solidRendering = ui->openGLViewport->renderSceneToImageAsSolidAllIlluminated();
+        ui->openGLViewport->applyLevelOfDetail(COARSE_LOD);
+    }
+    QByteArray sceneKey = ui->openGLViewport->sceneKey();
+
+    showStipplingViewport();
+
+    // Until the dots are generated only the generation can be cancelled.
+    ui->menuGenerate_and_render->setEnabled(false);
+    ui->actionRe_apply_Stipple_Dot_dispersion->setEnabled(false);
+    ui->actionGenerate_final_image->setEnabled(false);
+    ui->actionCancel_stippling->setEnabled(true);
+    ui->actionSave_dot_set->setEnabled(false);
+    ui->actionOpen_dot_set->setEnabled(false);
+    ui->actionOpen_sprite_atlas->setEnabled(false);
 
+    ui->stippling_openGLViewport->stippleImage(image, method, solidRendering, sceneKey);
+
+    _mode = MODE_STIPPLING;
+}
+
+void MainWindow::showStipplingViewport()
+{
     ui->openGLContainer->hide();
     ui->topBar->hide();
     //ui->dockWidget_entities->hide();
@@ -816,14 +859,18 @@ void MainWindow::startStipplingProcess(DotGenerationWorker::DitheringMethod meth
     ui->menuEntities->setEnabled(false);
     ui->actionCamera_controls->setEnabled(false);
 
-    ui->actionRe_apply_Stipple_Dot_dispersion->setEnabled(true);
-    ui->actionGenerate_final_image->setEnabled(true);
-
     resizeOpenGLContainer();
+}
 
-    ui->stippling_openGLViewport->stippleImage(image, method, solidRendering);
-
-    _mode = MODE_STIPPLING;
+void MainWindow::stipplingEnded(bool completed)
+{
+    ui->menuGenerate_and_render->setEnabled(true);
+    ui->actionRe_apply_Stipple_Dot_dispersion->setEnabled(completed);
+    ui->actionGenerate_final_image->setEnabled(completed);
+    ui->actionCancel_stippling->setEnabled(false);
+    ui->actionSave_dot_set->setEnabled(completed);
+    ui->actionOpen_dot_set->setEnabled(true);
+    ui->actionOpen_sprite_atlas->setEnabled(true);
 }
 
 void MainWindow::reApplyStipplingDotDispersion()
@@ -834,18 +881,33 @@ void MainWindow::reApplyStipplingDotDispersion()
 void MainWindow::generateFinalImage()
 {
     QFileDialog fileDialog(this);
+    QString selFilter = tr("PNG Image (*.png)");
     // fileDialog.setDefaultSuffix(".png"); // Does not work under linux
     QString fileName = fileDialog.getSaveFileName(this,
-             tr("Generate final image (png)"), "",
-             tr("PNG Image (*.png);"));
+             tr("Generate final image (png or svg)"), "",
+             tr("PNG Image (*.png);;SVG Image (*.svg)"), &selFilter);
 
 
     while(fileName.isEmpty())
     {
         // fileDialog.setDefaultSuffix(".png"); // Does not work under linux
         fileName = fileDialog.getSaveFileName(this,
-                     tr("Generate final image (png)"), "",
-                     tr("PNG Image (*.png);"));
+                     tr("Generate final image (png or svg)"), "",
+                     tr("PNG Image (*.png);;SVG Image (*.svg)"), &selFilter);
+    }
+
+    // The SVG document holds the dots as vectors, to be rasterized at any resolution.
+    if(fileName.endsWith(".svg") || selFilter.contains("svg"))
+    {
+        if(!fileName.endsWith(".svg"))
+        {
+            fileName += ".svg";
+        }
+        if(!ui->stippling_openGLViewport->saveStippledImageAsSVG(fileName))
+        {
+            QMessageBox::information(this, tr("Unable to write the image"), fileName);
+        }
+        return;
     }
 
     // Fast hack to solve the extension problem
@@ -855,5 +917,98 @@ void MainWindow::generateFinalImage()
         fileName += ".png";
     }
 
-    ui->stippling_openGLViewport->saveStippledImageToDisk(fileName);
+    if(!ui->stippling_openGLViewport->saveStippledImageToDisk(fileName))
+    {
+        QMessageBox::information(this, tr("Unable to write the image"), fileName);
+    }
+}
+
+void MainWindow::saveDotSet()
+{
+    QFileDialog fileDialog(this);
+    // fileDialog.setDefaultSuffix(".dots"); // Does not work under linux
+    QString fileName = fileDialog.getSaveFileName(this,
+             tr("Save dot set"), "",
+             tr("Dot set (*.dots);"));
+
+    if(fileName.isEmpty())
+    {
+        return;
+    }
+
+    // Fast hack to solve the extension problem
+    if(!fileName.endsWith(".dots"))
+    {
+        fileName += ".dots";
+    }
+
+    if(!ui->stippling_openGLViewport->saveStipplingDots(fileName))
+    {
+        QMessageBox::information(this, tr("Unable to save the dot set"), fileName);
+    }
+}
+
+void MainWindow::openDotSet()
+{
+    QString selFilter = tr("Dot set (*.dots)");
+    QString fileName = QFileDialog::getOpenFileName(
+            this,
+            tr("Open dot set"),
+            QDir::currentPath(),
+            tr("Dot set (*.dots)"),
+            &selFilter
+    );
+
+    if(fileName.isEmpty())
+    {
+        return;
+    }
+
+    // The file is checked before leaving the current view.
+    DotSetInfo info;
+    QuadTree * dots = ui->stippling_openGLViewport->readStipplingDots(fileName, info);
+    if(dots == 0)
+    {
+        QMessageBox::information(this, tr("Unable to open the dot set"), fileName);
+        return;
+    }
+
+    showStipplingViewport();
+
+    ui->stippling_openGLViewport->showStipplingDots(dots, info);
+
+    _mode = MODE_STIPPLING;
+
+    ui->actionRe_apply_Stipple_Dot_dispersion->setEnabled(true);
+    ui->actionGenerate_final_image->setEnabled(true);
+    ui->actionSave_dot_set->setEnabled(true);
+}
+
+void MainWindow::openSpriteAtlas()
+{
+    QString selFilter = tr("Sprite atlas (*.xml)");
+    QString fileName = QFileDialog::getOpenFileName(
+            this,
+            tr("Open sprite atlas"),
+            QDir::currentPath(),
+            tr("Sprite atlas (*.xml)"),
+            &selFilter
+    );
+
+    if(fileName.isEmpty())
+    {
+        return;
+    }
+
+    if(!ui->stippling_openGLViewport->loadSpriteAtlas(fileName))
+    {
+        QMessageBox::information(this, tr("Unable to open the sprite atlas"), fileName);
+        return;
+    }
+
+    // The dots are discarded when they do not fit the new sprites.
+    bool hasDots = ui->stippling_openGLViewport->hasStipplingDots();
+    ui->actionRe_apply_Stipple_Dot_dispersion->setEnabled(hasDots);
+    ui->actionGenerate_final_image->setEnabled(hasDots);
+    ui->actionSave_dot_set->setEnabled(hasDots);
 }
@@ -81,6 +81,8 @@ private:
 
     EntityTreeController entities;
 
+    IntermediateCache _intermediateCache; /**< Solid renderings, dithered and edge images of former runs. */
+
 
     enum Mode {MODE_3DENGINE, MODE_STIPPLING};
     Mode _mode;
@@ -137,10 +139,20 @@ private slots:
     void startStipplingProcessFloydSteinbergDithering();
     void startStipplingProcessStuckiDithering();
 
+    /**
+     * @brief Updates the stippling menu once the dots are generated (or the generation is cancelled).
+     */
+    void stipplingEnded(bool completed);
+
     void reApplyStipplingDotDispersion();
 
     void generateFinalImage();
 
+    void saveDotSet();
+    void openDotSet();
+
+    void openSpriteAtlas();
+
 protected:
     void resizeEvent(QResizeEvent *event);
     void closeEvent(QCloseEvent *event);
@@ -149,6 +161,12 @@ protected:
 
 private:
     void resizeOpenGLContainer();
+
+    /**
+     * @brief Replaces the 3D engine by the stippling viewport, and disables the scene edition.
+     */
+    void showStipplingViewport();
+
     void startStipplingProcess(DotGenerationWorker::DitheringMethod method);
 };
 
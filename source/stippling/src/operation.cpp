@@ -49,52 +49,7 @@ Operation::Operation(IDManager * idManager, const GLuint entityRenderShader,
 
     recalculateGeometry();
 
-    GLfloat * vertexColor = new GLfloat[lines_NumberOfValues];
-    // Setting the color of each vertex
-    for(int i=0; i<lines_NumberOfValues; i+=3)
-    {
-        vertexColor[i] = color.r;
-        vertexColor[i+1] = color.g;
-        vertexColor[i+2] = color.b;
-    }
-
-    const GLfloat * normalBufferData = 0;
-
-    const GLfloat * uvBufferData = 0;
-
-    _wireframe.initialize(lines, vertexColor, normalBufferData, uvBufferData,
-                          lines_NumberOfValues, GL_LINES, 3, GL_DYNAMIC_DRAW,
-                          entityRenderShader, selectionShader);
-
-    deleteLines();
-    if(vertexColor != 0)
-    {
-        delete[] vertexColor;
-        vertexColor = 0;
-    }
-
-    vertexColor = new GLfloat[triangles_NumberOfValues];
-    // Setting the color of each vertex
-    for(int i=0; i<triangles_NumberOfValues; i+=3)
-    {
-        vertexColor[i] = color.r;
-        vertexColor[i+1] = color.g;
-        vertexColor[i+2] = color.b;
-    }
-
-    uvBufferData = 0;
-
-    _solid.initialize(triangles, vertexColor, normals, uvBufferData,
-                      triangles_NumberOfValues, GL_TRIANGLES, 3, GL_DYNAMIC_DRAW,
-                      entityRenderShader, selectionShader);
-
-    deleteTriangles();
-    deleteNormals();
-    if(vertexColor != 0)
-    {
-        delete[] vertexColor;
-        vertexColor = 0;
-    }
+    initializeGLEntities(entityRenderShader, selectionShader);
 }
 
 Operation::Operation(IDManager * idManager, QDomNode node, const GLuint entityRenderShader,
@@ -170,52 +125,7 @@ Operation::Operation(IDManager * idManager, QDomNode node, const GLuint entityRe
 
     recalculateGeometry();
 
-    GLfloat * vertexColor = new GLfloat[lines_NumberOfValues];
-    // Setting the color of each vertex
-    for(int i=0; i<lines_NumberOfValues; i+=3)
-    {
-        vertexColor[i] = color.r;
-        vertexColor[i+1] = color.g;
-        vertexColor[i+2] = color.b;
-    }
-
-    const GLfloat * normalBufferData = 0;
-
-    const GLfloat * uvBufferData = 0;
-
-    _wireframe.initialize(lines, vertexColor, normalBufferData, uvBufferData,
-                          lines_NumberOfValues, GL_LINES, 3, GL_DYNAMIC_DRAW,
-                          entityRenderShader, selectionShader);
-
-    deleteLines();
-    if(vertexColor != 0)
-    {
-        delete[] vertexColor;
-        vertexColor = 0;
-    }
-
-    vertexColor = new GLfloat[triangles_NumberOfValues];
-    // Setting the color of each vertex
-    for(int i=0; i<triangles_NumberOfValues; i+=3)
-    {
-        vertexColor[i] = color.r;
-        vertexColor[i+1] = color.g;
-        vertexColor[i+2] = color.b;
-    }
-
-    uvBufferData = 0;
-
-    _solid.initialize(triangles, vertexColor, normals, uvBufferData,
-                      triangles_NumberOfValues, GL_TRIANGLES, 3, GL_DYNAMIC_DRAW,
-                      entityRenderShader, selectionShader);
-
-    deleteTriangles();
-    deleteNormals();
-    if(vertexColor != 0)
-    {
-        delete[] vertexColor;
-        vertexColor = 0;
-    }
+    initializeGLEntities(entityRenderShader, selectionShader);
 }
 
 Operation::~Operation()
@@ -256,147 +166,21 @@ void Operation::recalculateGeometry()
 
         //_mesh.saveOFFMesh( QString("debug " + name() + ".off").toStdString() );
 
-        unsigned int nVertices;
-        float * vertices = _mesh.verticesCache(nVertices);
-        unsigned int nFaces;
-        std::vector<unsigned int> nVerticesPerFace;
-        unsigned int ** faces = _mesh.facesCache(nFaces, nVerticesPerFace);
-
-        /*
-        out << endl;
-        out << "==============================" << endl;
-        out << "    Debugging CGAL mesh output" << endl;
-        out << "nVertices = " << nVertices << endl;
-        out << "vertices = " << endl << "{" << endl;
-        for(int i=0; i<3*nVertices; i=i+3)
-        {
-            out << "( " << vertices[i] << ", " << vertices[i+1] << ", " << vertices[i+2] << " )";
-            if(i<(3*nVertices)-3)
-            {
-                out << "," << endl;
-            }
-        }
-        out << endl << "}" << endl;
-        out << "nFaces = " << nFaces << endl;
-        out << "nVerticesPerFace = {";
-        for(int i=0; i<nFaces; ++i)
-        {
-            out << " " << nVerticesPerFace.at(i);
-            if(i<nFaces-1)
-            {
-                out << ",";
-            }
-        }
-        out << " }" << endl;
-        out << "faces = " << endl << "{" << endl;
-        for(int i=0; i<nFaces; ++i)
-        {
-            for(int j=0; j<nVerticesPerFace.at(i); ++j)
-            {
-                out << " " << faces[i][j];
-                if(j<nVerticesPerFace.at(i)-1)
-                {
-                    out << ",";
-                }
-            }
-            if(i<nFaces-1)
-            {
-                out << ";" << endl;
-            }
-        }
-        out << ";" << endl << " }" << endl;
-        out << "==============================" << endl;
-        out << endl;
-        */
-
-        generateLines(nVertices, vertices, nFaces, &nVerticesPerFace, faces);
-        generateTriangles(nVertices, vertices, nFaces, &nVerticesPerFace, faces);
-        generateNormals(nVertices, vertices, nFaces, &nVerticesPerFace, faces);
-
-        if(vertices != 0)
-        {
-            delete[] vertices;
-            vertices = 0;
-        }
-        for(int f=0; f<int(nFaces); ++f)
-        {
-            if(faces[f] != 0)
-            {
-                delete[] faces[f];
-                faces[f] = 0;
-            }
-        }
-        if(faces != 0)
-        {
-            delete[] faces;
-            faces = 0;
-        }
+        generateGeometryFromMesh();
     }
     else
     {
-        lines_NumberOfValues = 0;
-        triangles_NumberOfTriangles = 0;
+        clearGeometry();
     }
 }
 
-void Operation::updateGeometry()
+void Operation::updateGeometry(const bool propagateToParent)
 {
     recalculateGeometry();
 
-    int id = _wireframe.id();
-    _wireframe = GLEntity(id, _idManager->encodeID(id));
-
-    GLfloat * vertexColor = new GLfloat[lines_NumberOfValues];
-    // Setting the color of each vertex
-    for(int i=0; i<lines_NumberOfValues; i+=3)
-    {
-        vertexColor[i] = _color.r;
-        vertexColor[i+1] = _color.g;
-        vertexColor[i+2] = _color.b;
-    }
-
-    const GLfloat * normalBufferData = 0;
-
-    const GLfloat * uvBufferData = 0;
-
-    _wireframe.initialize(lines, vertexColor, normalBufferData, uvBufferData,
-                          lines_NumberOfValues, GL_LINES, 3, GL_DYNAMIC_DRAW,
-                          _entityRenderShader, _selectionShader);
-
-    deleteLines();
-    if(vertexColor != 0)
-    {
-        delete[] vertexColor;
-        vertexColor = 0;
-    }
-
-    id = _solid.id();
-    _solid = GLEntity(id, _idManager->encodeID(id));
-
-    vertexColor = new GLfloat[triangles_NumberOfValues];
-    // Setting the color of each vertex
-    for(int i=0; i<triangles_NumberOfValues; i+=3)
-    {
-        vertexColor[i] = _color.r;
-        vertexColor[i+1] = _color.g;
-        vertexColor[i+2] = _color.b;
-    }
-
-    uvBufferData = 0;
-
-    _solid.initialize(triangles, vertexColor, normals, uvBufferData,
-                      triangles_NumberOfValues, GL_TRIANGLES, 3, GL_DYNAMIC_DRAW,
-                      _entityRenderShader, _selectionShader);
-
-    deleteTriangles();
-    deleteNormals();
-    if(vertexColor != 0)
-    {
-        delete[] vertexColor;
-        vertexColor = 0;
-    }
+    updateGLEntities();
 
-    if(_parent != 0 && _parent->isOperation())
+    if(propagateToParent && _parent != 0 && _parent->isOperation())
     {
         _parent->updateGeometry();
     }
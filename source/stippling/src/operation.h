@@ -65,9 +65,10 @@ public:
     void setRightOperator(Entity3D * rightOperator);
 
     /**
-     * @brief Recalculates its geometry by refreshing the operation calculation. Also reinitializes its GLEntities so they hold relevant values.
+     * @brief Recalculates its geometry by refreshing the operation calculation. Also uploads the new geometry to its GLEntities so they hold relevant values.
+     * @param propagateToParent Whether the parent operation (if any) has to be updated afterwards.
      */
-    void updateGeometry();
+    void updateGeometry(const bool propagateToParent = true);
 };
 
 #endif // OPERATION_H
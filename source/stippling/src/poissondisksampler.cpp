@@ -0,0 +1,237 @@
+/**
+ * @file poissondisksampler.cpp
+ * @brief PoissonDiskSampler class source file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#include "poissondisksampler.h"
+
+#include "random.h"
+
+#include <cmath>
+
+/**
+ * @brief Candidate directions and distances drawn at once by a tile.
+ */
+static const int CANDIDATE_BATCH = 64;
+
+/**
+ * @brief Samples some tiles of a pass, as a cv::parallel_for_ body.
+ */
+class PoissonDiskTileBody : public cv::ParallelLoopBody
+{
+private:
+    PoissonDiskSampler & _sampler;
+    const QVector<int> & _tiles;
+
+public:
+    PoissonDiskTileBody(PoissonDiskSampler & sampler, const QVector<int> & tiles)
+        : _sampler(sampler), _tiles(tiles)
+    {
+    }
+
+    void operator()(const cv::Range & range) const
+    {
+        for(int i=range.start; i<range.end; ++i)
+        {
+            _sampler.sampleTile(_tiles[i] / _sampler._tileColumns, _tiles[i] % _sampler._tileColumns);
+        }
+    }
+};
+
+PoissonDiskSampler::PoissonDiskSampler(const cv::Mat & radius, float minimumRadius, float maximumRadius)
+{
+    _radius = radius;
+    _minimumRadius = minimumRadius;
+    _maximumRadius = qMax(minimumRadius, maximumRadius);
+
+    // Two points in the same cell would be closer than its diagonal.
+    _cellSize = _minimumRadius / std::sqrt(2.0f);
+    _gridColumns = qMax(1, int(std::ceil(_radius.cols / _cellSize)));
+    _gridRows = qMax(1, int(std::ceil(_radius.rows / _cellSize)));
+
+    // A point looks for others up to its radius away, so a tile between two others keeps them apart.
+    _tileCells = qMax(32, int(std::ceil(_maximumRadius / _cellSize)));
+    _tileColumns = (_gridColumns + _tileCells - 1) / _tileCells;
+    _tileRows = (_gridRows + _tileCells - 1) / _tileCells;
+
+    _seed = 0;
+    _attempts = 30;
+}
+
+float PoissonDiskSampler::radiusAt(const glm::vec2 & point) const
+{
+    int row = qBound(0, int(point.y), _radius.rows - 1);
+    int column = qBound(0, int(point.x), _radius.cols - 1);
+
+    float radius = _radius.at<float>(row, column);
+    if(radius <= 0.0f)
+    {
+        return 0.0f;
+    }
+
+    return qBound(_minimumRadius, radius, _maximumRadius);
+}
+
+bool PoissonDiskSampler::isFarEnough(const glm::vec2 & candidate, float radius) const
+{
+    int centerColumn = int(candidate.x / _cellSize);
+    int centerRow = int(candidate.y / _cellSize);
+    int reach = int(std::ceil(radius / _cellSize));
+
+    int firstRow = qMax(0, centerRow - reach);
+    int lastRow = qMin(_gridRows - 1, centerRow + reach);
+    int firstColumn = qMax(0, centerColumn - reach);
+    int lastColumn = qMin(_gridColumns - 1, centerColumn + reach);
+
+    for(int row=firstRow; row<=lastRow; ++row)
+    {
+        const glm::vec2 * cells = _grid.constData() + row * _gridColumns;
+        for(int column=firstColumn; column<=lastColumn; ++column)
+        {
+            if(cells[column].x < 0.0f)
+            {
+                continue;
+            }
+
+            glm::vec2 d = cells[column] - candidate;
+            if(d.x * d.x + d.y * d.y < radius * radius)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void PoissonDiskSampler::sampleTile(int tileRow, int tileColumn)
+{
+    int firstRow = tileRow * _tileCells;
+    int lastRow = qMin(_gridRows, firstRow + _tileCells);
+    int firstColumn = tileColumn * _tileCells;
+    int lastColumn = qMin(_gridColumns, firstColumn + _tileCells);
+
+    // Candidates must fall in the tile (and in the image), the only part of the grid it writes.
+    float left = firstColumn * _cellSize;
+    float right = qMin(lastColumn * _cellSize, float(_radius.cols));
+    float top = firstRow * _cellSize;
+    float bottom = qMin(lastRow * _cellSize, float(_radius.rows));
+
+    glm::vec2 * grid = _grid.data();
+    QVector<glm::vec2> & points = _tilePoints[tileRow * _tileColumns + tileColumn];
+    QVector<glm::vec2> active;
+    Random random(_seed, Random::key(tileRow, tileColumn));
+
+    float cosines[CANDIDATE_BATCH];
+    float sines[CANDIDATE_BATCH];
+    float lengths[CANDIDATE_BATCH];
+    int nextCandidate = CANDIDATE_BATCH;
+
+    // Every empty cell seeds a new front, so areas cut off by blank pixels are sampled too.
+    for(int row=firstRow; row<lastRow; ++row)
+    {
+        for(int column=firstColumn; column<lastColumn; ++column)
+        {
+            if(grid[row * _gridColumns + column].x >= 0.0f)
+            {
+                continue;
+            }
+
+            glm::vec2 seed((column + random.uniform()) * _cellSize, (row + random.uniform()) * _cellSize);
+            float seedRadius = radiusAt(seed);
+            if(seed.x >= right || seed.y >= bottom || seedRadius == 0.0f || !isFarEnough(seed, seedRadius))
+            {
+                continue;
+            }
+
+            grid[row * _gridColumns + column] = seed;
+            points.append(seed);
+            active.append(seed);
+
+            while(!active.isEmpty())
+            {
+                int index = random.next(active.size());
+                glm::vec2 point = active[index];
+                float radius = radiusAt(point);
+
+                bool found = false;
+                for(int attempt=0; attempt<_attempts && !found; ++attempt)
+                {
+                    if(nextCandidate == CANDIDATE_BATCH)
+                    {
+                        random.directions(cosines, sines, CANDIDATE_BATCH);
+                        random.uniforms(lengths, CANDIDATE_BATCH);
+                        nextCandidate = 0;
+                    }
+                    float distance = radius * (1.0f + lengths[nextCandidate]);
+                    glm::vec2 candidate = point + distance * glm::vec2(cosines[nextCandidate], sines[nextCandidate]);
+                    ++nextCandidate;
+                    if(candidate.x < left || candidate.x >= right || candidate.y < top || candidate.y >= bottom)
+                    {
+                        continue;
+                    }
+
+                    float candidateRadius = radiusAt(candidate);
+                    if(candidateRadius == 0.0f || !isFarEnough(candidate, candidateRadius))
+                    {
+                        continue;
+                    }
+
+                    grid[int(candidate.y / _cellSize) * _gridColumns + int(candidate.x / _cellSize)] = candidate;
+                    points.append(candidate);
+                    active.append(candidate);
+                    found = true;
+                }
+
+                if(!found)
+                {
+                    active[index] = active.last();
+                    active.remove(active.size() - 1);
+                }
+            }
+        }
+    }
+}
+
+QVector<glm::vec2> PoissonDiskSampler::sample(quint64 seed, int attempts)
+{
+    _seed = seed;
+    _attempts = attempts;
+
+    _grid.fill(glm::vec2(-1.0f, -1.0f), _gridColumns * _gridRows);
+    _tilePoints.clear();
+    _tilePoints.resize(_tileColumns * _tileRows);
+
+    // Passes of the tiles with the same parity of row and column.
+    for(int pass=0; pass<4; ++pass)
+    {
+        QVector<int> tiles;
+        for(int tileRow=pass / 2; tileRow<_tileRows; tileRow+=2)
+        {
+            for(int tileColumn=pass % 2; tileColumn<_tileColumns; tileColumn+=2)
+            {
+                tiles.append(tileRow * _tileColumns + tileColumn);
+            }
+        }
+
+        cv::parallel_for_(cv::Range(0, tiles.size()), PoissonDiskTileBody(*this, tiles));
+    }
+
+    QVector<glm::vec2> points;
+    foreach(const QVector<glm::vec2> & tilePoints, _tilePoints)
+    {
+        points += tilePoints;
+    }
+
+    _grid.clear();
+    _tilePoints.clear();
+
+    return points;
+}
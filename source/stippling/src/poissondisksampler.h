@@ -0,0 +1,86 @@
+/**
+ * @file poissondisksampler.h
+ * @brief PoissonDiskSampler class header file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#ifndef POISSONDISKSAMPLER_H
+#define POISSONDISKSAMPLER_H
+
+#include <QVector>
+
+#include <opencv2/core/core.hpp>
+
+#include <glm/glm.hpp>
+
+/**
+ * @brief PoissonDiskSampler class.
+ * Poisson disk sampling with a variable radius (Bridson 2007): new points are tried around the
+ * active ones, at between one and two times their radius, and kept if no point lies closer than
+ * the radius at the new point. The result is as evenly spread as a relaxation, at a fraction of the cost.
+ * Points are looked up on a uniform grid whose cells are small enough to hold a single point.
+ * The image is split in tiles at least as wide as the largest radius, sampled in four passes: the
+ * tiles of a pass are not neighbours, so they are sampled in parallel, and the later passes see the
+ * points of the earlier ones across the borders of the tiles, so no pair of points is too close.
+ * Coordinates are in pixels of the radius image, (0, 0) being the top left corner of the first pixel.
+ */
+class PoissonDiskSampler
+{
+private:
+    cv::Mat _radius;
+    float _minimumRadius;
+    float _maximumRadius;
+
+    float _cellSize; /**< Side of a cell, in pixels. */
+    int _gridColumns;
+    int _gridRows;
+    QVector<glm::vec2> _grid; /**< Point of every cell, (-1, -1) if empty. */
+
+    int _tileCells; /**< Side of a tile, in cells. */
+    int _tileColumns;
+    int _tileRows;
+    QVector< QVector<glm::vec2> > _tilePoints; /**< Points found in every tile. */
+
+    quint64 _seed;
+    int _attempts;
+
+    friend class PoissonDiskTileBody;
+
+    /**
+     * @return Radius at a point, 0 where no points may be placed.
+     */
+    float radiusAt(const glm::vec2 & point) const;
+
+    /**
+     * @return True if no point is closer to a candidate than its radius.
+     */
+    bool isFarEnough(const glm::vec2 & candidate, float radius) const;
+
+    void sampleTile(int tileRow, int tileColumn);
+
+public:
+    /**
+     * @param radius Radius of the disks at every pixel (CV_32FC1); pixels with 0 get no points,
+     * the rest are clamped to [minimumRadius, maximumRadius]. Shared, not copied.
+     * @param minimumRadius Smallest radius (positive), it sets the size of the grid.
+     * @param maximumRadius Largest radius, it sets the size of the tiles.
+     */
+    PoissonDiskSampler(const cv::Mat & radius, float minimumRadius, float maximumRadius);
+
+    /**
+     * @brief Samples the whole image.
+     * The points only depend on the seed, not on the number of threads.
+     * @param seed Seed of the random numbers.
+     * @param attempts Candidates tried around an active point before it is retired.
+     * @return The points, tile by tile.
+     */
+    QVector<glm::vec2> sample(quint64 seed, int attempts = 30);
+};
+
+#endif // POISSONDISKSAMPLER_H
@@ -81,52 +81,7 @@ Prism::Prism(IDManager * idManager, const float size, const GLuint entityRenderS
 
     recalculateGeometry();
 
-    GLfloat * vertexColor = new GLfloat[lines_NumberOfValues];
-    // Setting the color of each vertex
-    for(int i=0; i<lines_NumberOfValues; i+=3)
-    {
-        vertexColor[i] = color.r;
-        vertexColor[i+1] = color.g;
-        vertexColor[i+2] = color.b;
-    }
-
-    const GLfloat * normalBufferData = 0;
-
-    const GLfloat * uvBufferData = 0;
-
-    _wireframe.initialize(lines, vertexColor, normalBufferData, uvBufferData,
-                          lines_NumberOfValues, GL_LINES, 3, GL_DYNAMIC_DRAW,
-                          entityRenderShader, selectionShader);
-
-    deleteLines();
-    if(vertexColor != 0)
-    {
-        delete[] vertexColor;
-        vertexColor = 0;
-    }
-
-    vertexColor = new GLfloat[triangles_NumberOfValues];
-    // Setting the color of each vertex
-    for(int i=0; i<triangles_NumberOfValues; i+=3)
-    {
-        vertexColor[i] = color.r;
-        vertexColor[i+1] = color.g;
-        vertexColor[i+2] = color.b;
-    }
-
-    uvBufferData = 0;
-
-    _solid.initialize(triangles, vertexColor, normals, uvBufferData,
-                      triangles_NumberOfValues, GL_TRIANGLES, 3, GL_DYNAMIC_DRAW,
-                      entityRenderShader, selectionShader);
-
-    deleteTriangles();
-    deleteNormals();
-    if(vertexColor != 0)
-    {
-        delete[] vertexColor;
-        vertexColor = 0;
-    }
+    initializeGLEntities(entityRenderShader, selectionShader);
 }
 
 Prism::Prism(IDManager * idManager, QDomNode node, const GLuint entityRenderShader,
@@ -214,52 +169,7 @@ Prism::Prism(IDManager * idManager, QDomNode node, const GLuint entityRenderShad
 
     recalculateGeometry();
 
-    GLfloat * vertexColor = new GLfloat[lines_NumberOfValues];
-    // Setting the color of each vertex
-    for(int i=0; i<lines_NumberOfValues; i+=3)
-    {
-        vertexColor[i] = color.r;
-        vertexColor[i+1] = color.g;
-        vertexColor[i+2] = color.b;
-    }
-
-    const GLfloat * normalBufferData = 0;
-
-    const GLfloat * uvBufferData = 0;
-
-    _wireframe.initialize(lines, vertexColor, normalBufferData, uvBufferData,
-                          lines_NumberOfValues, GL_LINES, 3, GL_DYNAMIC_DRAW,
-                          entityRenderShader, selectionShader);
-
-    deleteLines();
-    if(vertexColor != 0)
-    {
-        delete[] vertexColor;
-        vertexColor = 0;
-    }
-
-    vertexColor = new GLfloat[triangles_NumberOfValues];
-    // Setting the color of each vertex
-    for(int i=0; i<triangles_NumberOfValues; i+=3)
-    {
-        vertexColor[i] = color.r;
-        vertexColor[i+1] = color.g;
-        vertexColor[i+2] = color.b;
-    }
-
-    uvBufferData = 0;
-
-    _solid.initialize(triangles, vertexColor, normals, uvBufferData,
-                      triangles_NumberOfValues, GL_TRIANGLES, 3, GL_DYNAMIC_DRAW,
-                      entityRenderShader, selectionShader);
-
-    deleteTriangles();
-    deleteNormals();
-    if(vertexColor != 0)
-    {
-        delete[] vertexColor;
-        vertexColor = 0;
-    }
+    initializeGLEntities(entityRenderShader, selectionShader);
 }
 
 Prism::~Prism()
@@ -310,154 +220,56 @@ void Prism::recalculateGeometry()
         baseTop.append(cornerTop);
     }
 
-    Surface surface;
+    _primitiveVertices.clear();
+    _primitivePolygons.clear();
 
-    // Adding the vertices to the surface
-    //int vertexIndex = 0;
-    //out << "Prism's vertices:" << endl;
+    // Adding the vertices
     foreach(glm::vec3 cornerBottom, baseBottom)
     {
-        //out << "vertex #" << vertexIndex << " = " << endl;
-        //Util::printVector(cornerBottom);
-        //++vertexIndex;
-        surface.addVertex(cornerBottom);
+        _primitiveVertices.push_back(cornerBottom.x);
+        _primitiveVertices.push_back(cornerBottom.y);
+        _primitiveVertices.push_back(cornerBottom.z);
     }
     foreach(glm::vec3 cornerTop, baseTop)
     {
-        //out << "vertex #" << vertexIndex << " = " << endl;
-        //Util::printVector(cornerTop);
-        //++vertexIndex;
-        surface.addVertex(cornerTop);
+        _primitiveVertices.push_back(cornerTop.x);
+        _primitiveVertices.push_back(cornerTop.y);
+        _primitiveVertices.push_back(cornerTop.z);
     }
 
-    QVector<unsigned int> tempFaces;
+    std::vector<unsigned int> polygon;
 
-    // Adding the bottom face to the surface
-    for(int i=0; i<baseBottom.size()-2; ++i)
+    // Adding the bottom face
+    polygon.clear();
+    for(int i=0; i<baseBottom.size(); ++i)
     {
-       tempFaces.clear();
-
-       tempFaces.push_back(0);
-       tempFaces.push_back(Util::mod(-1-i,baseBottom.size()));
-       tempFaces.push_back(Util::mod(-2-i,baseBottom.size()));
-
-       surface.addFace(tempFaces);
+        polygon.push_back(Util::mod(-i,baseBottom.size()));
     }
+    _primitivePolygons.push_back(polygon);
 
-    // Adding the top face to the surface
-    for(int i=0; i<baseTop.size()-2; ++i)
+    // Adding the top face
+    polygon.clear();
+    for(int i=0; i<baseTop.size(); ++i)
     {
-       tempFaces.clear();
-
-       tempFaces.push_back(baseBottom.size());
-       tempFaces.push_back(baseBottom.size() + Util::mod(1+i,baseTop.size()));
-       tempFaces.push_back(baseBottom.size() + Util::mod(2+i,baseTop.size()));
-
-       surface.addFace(tempFaces);
+        polygon.push_back(baseBottom.size() + i);
     }
+    _primitivePolygons.push_back(polygon);
 
-    // Adding the lateral faces to the surface
+    // Adding the lateral faces
     for(int i=0; i<baseBottom.size(); ++i)
     {
-        tempFaces.clear();
-
-        tempFaces.push_back(i);
-        tempFaces.push_back(Util::mod(i+1,baseBottom.size()));
-        tempFaces.push_back(baseBottom.size() + Util::mod(i+1,baseTop.size()));
+        polygon.clear();
 
-        surface.addFace(tempFaces);
+        polygon.push_back(i);
+        polygon.push_back(Util::mod(i+1,baseBottom.size()));
+        polygon.push_back(baseBottom.size() + Util::mod(i+1,baseTop.size()));
+        polygon.push_back(baseBottom.size() + i);
 
-        tempFaces.clear();
-
-        tempFaces.push_back(i);
-        tempFaces.push_back(baseBottom.size() + Util::mod(i+1,baseTop.size()));
-        tempFaces.push_back(baseBottom.size() + i);
-
-        surface.addFace(tempFaces);
+        _primitivePolygons.push_back(polygon);
     }
 
-    // create polyhedron from surface
-    _mesh.clearCache();
-    _mesh.addSurface(surface);
-    _mesh.flushCache();
-
-    //_mesh.saveOFFMesh( QString("debug " + name() + ".off").toStdString() );
-
-    unsigned int nVertices;
-    float * vertices = _mesh.verticesCache(nVertices);
-    unsigned int nFaces;
-    std::vector<unsigned int> nVerticesPerFace;
-    unsigned int ** faces = _mesh.facesCache(nFaces, nVerticesPerFace);
-
-    /*
-    out << endl;
-    out << "==============================" << endl;
-    out << "    Debugging CGAL mesh output" << endl;
-    out << "nVertices = " << nVertices << endl;
-    out << "vertices = " << endl << "{" << endl;
-    for(int i=0; i<3*nVertices; i=i+3)
-    {
-        out << "( " << vertices[i] << ", " << vertices[i+1] << ", " << vertices[i+2] << " )";
-        if(i<(3*nVertices)-3)
-        {
-            out << "," << endl;
-        }
-    }
-    out << endl << "}" << endl;
-    out << "nFaces = " << nFaces << endl;
-    out << "nVerticesPerFace = {";
-    for(int i=0; i<nFaces; ++i)
-    {
-        out << " " << nVerticesPerFace.at(i);
-        if(i<nFaces-1)
-        {
-            out << ",";
-        }
-    }
-    out << " }" << endl;
-    out << "faces = " << endl << "{" << endl;
-    for(int i=0; i<nFaces; ++i)
-    {
-        for(int j=0; j<nVerticesPerFace.at(i); ++j)
-        {
-            out << " " << faces[i][j];
-            if(j<nVerticesPerFace.at(i)-1)
-            {
-                out << ",";
-            }
-        }
-        if(i<nFaces-1)
-        {
-            out << ";" << endl;
-        }
-    }
-    out << ";" << endl << " }" << endl;
-    out << "==============================" << endl;
-    out << endl;
-    */
-
-    generateLines(nVertices, vertices, nFaces, &nVerticesPerFace, faces);
-    generateTriangles(nVertices, vertices, nFaces, &nVerticesPerFace, faces);
-    generateNormals(nVertices, vertices, nFaces, &nVerticesPerFace, faces);
-
-    if(vertices != 0)
-    {
-        delete[] vertices;
-        vertices = 0;
-    }
-    for(int f=0; f<int(nFaces); ++f)
-    {
-        if(faces[f] != 0)
-        {
-            delete[] faces[f];
-            faces[f] = 0;
-        }
-    }
-    if(faces != 0)
-    {
-        delete[] faces;
-        faces = 0;
-    }
+    // The CGAL mesh is only built when an operation needs it
+    generateGeometryFromPolygons();
 }
 
 void Prism::interactSpecifically(ControlPoint * cp)
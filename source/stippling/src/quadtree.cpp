@@ -139,7 +139,85 @@ QVector<QVector<StippleDot *> *> QuadTree::getDotsInPaddedArea(glm::vec4 area, i
     return _root->getDotsInArea(paddedArea);
 }
 
-void QuadTree::add(StippleDot * dot)
+bool QuadTree::add(StippleDot * dot)
 {
-    _root->add(dot);
+    QuadTreeNode * leaf = _root->getLeaf(dot->finalPostion());
+    if(leaf == 0)
+    {
+        leaf = _root->getLeaf(dot->position());
+    }
+    if(leaf == 0)
+    {
+        delete dot;
+        return false;
+    }
+
+    leaf->_dots.append(dot);
+    return true;
+}
+
+/**
+ * @brief Splits the dots of some leaves in the ones that stay and the ones that left, as a cv::parallel_for_ body.
+ */
+class LeavingDotsBody : public cv::ParallelLoopBody
+{
+private:
+    const QVector<QuadTreeNode *> & _leaves;
+    QVector<QVector<StippleDot *> > & _leaving;
+    QuadTreeNode * _root;
+
+public:
+    LeavingDotsBody(const QVector<QuadTreeNode *> & leaves, QVector<QVector<StippleDot *> > & leaving, QuadTreeNode * root)
+        : _leaves(leaves), _leaving(leaving), _root(root)
+    {
+    }
+
+    void operator()(const cv::Range & range) const
+    {
+        for(int i=range.start; i<range.end; ++i)
+        {
+            QVector<StippleDot *> & dots = _leaves[i]->_dots;
+
+            int kept = 0;
+            for(int j=0; j<dots.size(); ++j)
+            {
+                StippleDot * dot = dots[j];
+                glm::vec2 position = dot->finalPostion();
+
+                // Most dots stay well inside their leaf, only the ones near a border need the full search.
+                QuadTreeNode * leaf = _leaves[i]->isStrictlyInside(position) ? _leaves[i] : _root->getLeaf(position);
+                if(leaf == 0 || leaf == _leaves[i])
+                {
+                    dots[kept++] = dot;
+                }
+                else
+                {
+                    _leaving[i].append(dot);
+                }
+            }
+            dots.resize(kept);
+        }
+    }
+};
+
+int QuadTree::rebucket()
+{
+    QVector<QuadTreeNode *> leaves;
+    _root->getLeaves(leaves);
+
+    // Leaves are independent, so they are split in parallel. The dots that left are few, they are added serially.
+    QVector<QVector<StippleDot *> > leaving(leaves.size());
+    cv::parallel_for_(cv::Range(0, leaves.size()), LeavingDotsBody(leaves, leaving, _root));
+
+    int moved = 0;
+    for(int i=0; i<leaving.size(); ++i)
+    {
+        foreach(StippleDot * dot, leaving[i])
+        {
+            _root->getLeaf(dot->finalPostion())->_dots.append(dot);
+            ++moved;
+        }
+    }
+
+    return moved;
 }
@@ -37,7 +37,20 @@ public:
     QVector<QVector<StippleDot *> *> getDotsInArea(glm::vec4 area);
     QVector<QVector<StippleDot *> *> getDotsInPaddedArea(glm::vec4 area, int padding);
 
-    void add(StippleDot * dot);
+    /**
+     * @brief Adds a dot to the leaf of its final position. Dots moved out of the tree's area by
+     * their offset go to the leaf of their generation position, where rebucket keeps them.
+     * @return False if both positions are out of the tree's area: the dot is deleted.
+     */
+    bool add(StippleDot * dot);
+
+    /**
+     * @brief Moves the dots whose final position (after an offset change) left their leaf to
+     * the leaf that now contains it, so the area queries stay correct. Dots moved out of the
+     * tree's area are kept where they are.
+     * @return Number of dots moved.
+     */
+    int rebucket();
 };
 
 #endif // QUADTREE_H
@@ -89,6 +89,46 @@ QVector<QVector<StippleDot *> *> * QuadTreeNode::getChildrensDotVectors()
     return &_dotVectors;
 }
 
+void QuadTreeNode::getLeaves(QVector<QuadTreeNode *> & leaves)
+{
+    if(hasChildren())
+    {
+        foreach(QuadTreeNode * node, _children)
+        {
+            node->getLeaves(leaves);
+        }
+    }
+    else
+    {
+        leaves.append(this);
+    }
+}
+
+QuadTreeNode * QuadTreeNode::getLeaf(glm::vec2 position)
+{
+    int quadrant = getQuadrant(position);
+
+    if(quadrant == -1)
+    {
+        return 0;
+    }
+    if(hasChildren())
+    {
+        return _children.at(quadrant)->getLeaf(position);
+    }
+    return this;
+}
+
+bool QuadTreeNode::isStrictlyInside(glm::vec2 position) const
+{
+    // Truncated as doesPositionBelongTo does.
+    int x = position.x;
+    int y = position.y;
+
+    return (x > qMin(_area.x, _area.z)) && (x < qMax(_area.x, _area.z))
+        && (y > qMin(_area.y, _area.w)) && (y < qMax(_area.y, _area.w));
+}
+
 QuadTreeNode::QuadTreeNode(glm::vec4 area)
 {
     _area = glm::vec4(int(area.x), int(area.y), int(area.z), int(area.w));
@@ -105,6 +145,11 @@ QuadTreeNode::~QuadTreeNode()
     }
     _children.clear();
 
+    // The tree owns the dots added to it (each one is stored in a single leaf).
+    foreach(StippleDot * dot, _dots)
+    {
+        delete dot;
+    }
     _dots.clear();
 }
 
@@ -404,7 +449,7 @@ QVector<QVector<StippleDot *> *> QuadTreeNode::getDotsInArea(glm::vec4 area)
     return dotVectors;
 }
 
-void QuadTreeNode::add(StippleDot * dot)
+bool QuadTreeNode::add(StippleDot * dot)
 {
     /*
     out << "Node area:" << endl;
@@ -414,16 +459,18 @@ void QuadTreeNode::add(StippleDot * dot)
 
     int quadrant = getQuadrant(dot->finalPostion());
 
-    if(quadrant != -1)
+    if(quadrant == -1)
     {
-        if(hasChildren())
-        {
-            _children.at(quadrant)->add(dot);
-        }
-        else
-        {
-            _dots.append(dot);
-        }
+        delete dot;
+        return false;
     }
+
+    if(hasChildren())
+    {
+        return _children.at(quadrant)->add(dot);
+    }
+
+    _dots.append(dot);
+    return true;
 }
 
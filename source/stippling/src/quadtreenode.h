@@ -47,6 +47,7 @@
 class QuadTreeNode
 {
     friend class QuadTree;
+    friend class LeavingDotsBody;
 protected:
     QVector<QuadTreeNode *> _children;
     QVector<StippleDot *> _dots;
@@ -61,6 +62,22 @@ protected:
 
 	QVector<QVector<StippleDot *> *> * getChildrensDotVectors();
 
+    /**
+     * @brief Appends the leaf descendants (or this node, if it is a leaf) in depth first order.
+     */
+    void getLeaves(QVector<QuadTreeNode *> & leaves);
+
+    /**
+     * @brief Leaf a position would be added to, or 0 if it is out of this node's area.
+     */
+    QuadTreeNode * getLeaf(glm::vec2 position);
+
+    /**
+     * @brief True if a position is inside the area and not on its border. Such a position can
+     * only be added to this node (at any level, borders are the only shared positions).
+     */
+    bool isStrictlyInside(glm::vec2 position) const;
+
 public:
     /**
      * @brief Constructor.
@@ -92,7 +109,11 @@ public:
     QVector<QVector<StippleDot *> *> getDots(QVector<bool> quadcode);
     QVector<QVector<StippleDot *> *> getDotsInArea(glm::vec4 area);
 
-    void add(StippleDot * dot);
+    /**
+     * @brief Adds a dot to the leaf of its final position. The tree owns the dots it holds.
+     * @return False if the position is out of this node's area: the dot is deleted.
+     */
+    bool add(StippleDot * dot);
 };
 
 #endif // QUADTREENODE_H
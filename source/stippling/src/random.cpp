@@ -0,0 +1,37 @@
+/**
+ * @file random.cpp
+ * @brief Random class source file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#include "random.h"
+
+#include <cmath>
+
+void Random::uniforms(float * values, int n)
+{
+    // The counters of the numbers are known beforehand, so the hashes do not wait for each other.
+    quint64 state = _state;
+    for(int i=0; i<n; ++i)
+    {
+        values[i] = float(Util::splitMix64(state + quint64(i) * Q_UINT64_C(0x9e3779b97f4a7c15)) >> 40) * (1.0f / 16777216.0f);
+    }
+    _state = state + quint64(n) * Q_UINT64_C(0x9e3779b97f4a7c15);
+}
+
+void Random::directions(float * cosines, float * sines, int n)
+{
+    uniforms(cosines, n);
+    for(int i=0; i<n; ++i)
+    {
+        float angle = float(2.0 * PI) * cosines[i];
+        sines[i] = std::sin(angle);
+        cosines[i] = std::cos(angle);
+    }
+}
@@ -0,0 +1,98 @@
+/**
+ * @file random.h
+ * @brief Random class header file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include "util.h"
+
+#include <QtGlobal>
+
+/**
+ * @brief Random class.
+ * Seedable random number stream shared by every stage that needs random numbers, in place of the
+ * global rand(): the numbers only depend on the seed and the key of the stream, so any thread can
+ * draw them, in any order, and they are the same on every platform.
+ * The stream with seed s and key k is the SplitMix64 sequence (Steele et al. 2014) started at s ^ k:
+ * the n-th number (from 0) is Util::splitMix64((s ^ k) + n * 0x9e3779b97f4a7c15). Every number is a
+ * hash of a counter, so a stream costs nothing to create: every pixel, dot or tile has its own one.
+ */
+class Random
+{
+private:
+    quint64 _state;
+
+public:
+    /**
+     * @param seed Seed, see seedOf.
+     * @param key Key of the stream, see key.
+     */
+    Random(quint64 seed, quint64 key = 0)
+    {
+        _state = seed ^ key;
+    }
+
+    /**
+     * @brief Seed of the streams of a configuration seed (Configuration::rngSeed), so close seeds give unrelated streams.
+     */
+    static quint64 seedOf(unsigned int rngSeed)
+    {
+        return Util::splitMix64(rngSeed);
+    }
+
+    /**
+     * @brief Key of the stream of a pair of integers, as a pixel (row, column).
+     */
+    static quint64 key(int high, int low)
+    {
+        return (quint64(quint32(high)) << 32) | quint32(low);
+    }
+
+    /**
+     * @return The next 64 random bits.
+     */
+    quint64 next64()
+    {
+        quint64 random = Util::splitMix64(_state);
+        _state += Q_UINT64_C(0x9e3779b97f4a7c15);
+        return random;
+    }
+
+    /**
+     * @return A random integer in [0, n), from the high half of next64.
+     */
+    int next(int n)
+    {
+        return int((next64() >> 32) % quint64(n));
+    }
+
+    /**
+     * @return A random number in [0, 1), from the 24 high bits of next64.
+     */
+    float uniform()
+    {
+        return float(next64() >> 40) * (1.0f / 16777216.0f);
+    }
+
+    /**
+     * @brief Fills an array with the next uniform numbers, the same ones as calling uniform n times.
+     */
+    void uniforms(float * values, int n);
+
+    /**
+     * @brief Fills two arrays with the cosines and sines of the next random angles, uniform in [0, 2 pi).
+     * Every angle takes one uniform.
+     */
+    void directions(float * cosines, float * sines, int n);
+};
+
+#endif // RANDOM_H
@@ -0,0 +1,384 @@
+/**
+ * @file regressionharness.cpp
+ * @brief RegressionHarness class source file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#include "regressionharness.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+ImageComparison::ImageComparison()
+{
+    goldenFound = false;
+    sizeMatches = false;
+    differentPixels = 0;
+    maxDifference = 0;
+    psnr = 0.0;
+    ssim = 0.0;
+}
+
+bool ImageComparison::identical() const
+{
+    return goldenFound && sizeMatches && differentPixels == 0;
+}
+
+DotSetComparison::DotSetComparison()
+{
+    goldenFound = false;
+    dots = 0;
+    goldenDots = 0;
+    matchingDots = 0;
+}
+
+bool DotSetComparison::identical() const
+{
+    return goldenFound && dots == goldenDots && matchingDots == dots;
+}
+
+RegressionHarness::RegressionHarness(BatchStippler * stippler, QString goldensDirectory, QString resultsDirectory, double minimumSSIM)
+{
+    _stippler = stippler;
+    _goldensDirectory = goldensDirectory;
+    _resultsDirectory = resultsDirectory;
+    _minimumSSIM = minimumSSIM;
+}
+
+void RegressionHarness::addCase(const RegressionCase & regressionCase)
+{
+    _cases.append(regressionCase);
+}
+
+bool RegressionHarness::saveDotSet(QString fileName, QuadTree * dots)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        return false;
+    }
+
+    QStringList lines;
+    if(dots != 0)
+    {
+        QVector<QVector<StippleDot *> *> leaves = dots->getDotsInFullArea();
+        foreach(QVector<StippleDot *> * leaf, leaves)
+        {
+            foreach(StippleDot * dot, *leaf)
+            {
+                glm::vec2 position = dot->finalPostion();
+                lines << QString::number(position.x, 'f', 2) + " " + QString::number(position.y, 'f', 2) + " " + QString::number(dot->chosenDot());
+            }
+        }
+    }
+    lines.sort();
+
+    QTextStream fo(&file);
+    foreach(const QString & line, lines)
+    {
+        fo << line << "\n";
+    }
+
+    return true;
+}
+
+bool RegressionHarness::loadDotSet(QString fileName, QStringList & dots)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        return false;
+    }
+
+    QTextStream in(&file);
+    while(!in.atEnd())
+    {
+        QString line = in.readLine();
+        if(!line.isEmpty())
+        {
+            dots << line;
+        }
+    }
+
+    return true;
+}
+
+bool RegressionHarness::copyFile(QString source, QString destination)
+{
+    if(QFile::exists(destination) && !QFile::remove(destination))
+    {
+        return false;
+    }
+    return QFile::copy(source, destination);
+}
+
+ImageComparison RegressionHarness::compareImages(cv::Mat image, cv::Mat golden)
+{
+    ImageComparison result;
+
+    result.goldenFound = !golden.empty();
+    if(!result.goldenFound)
+    {
+        return result;
+    }
+
+    result.sizeMatches = image.size() == golden.size() && image.type() == golden.type();
+    if(!result.sizeMatches)
+    {
+        return result;
+    }
+
+    cv::Mat difference;
+    cv::absdiff(image, golden, difference);
+
+    double maxDifference;
+    cv::minMaxLoc(difference.reshape(1), 0, &maxDifference);
+    result.maxDifference = int(maxDifference);
+
+    // A pixel is different if any of its channels is.
+    std::vector<cv::Mat> channels;
+    cv::split(difference, channels);
+    cv::Mat differentChannels = channels[0];
+    for(size_t i=1; i<channels.size(); ++i)
+    {
+        cv::max(differentChannels, channels[i], differentChannels);
+    }
+    result.differentPixels = cv::countNonZero(differentChannels);
+
+    if(result.differentPixels == 0)
+    {
+        result.psnr = std::numeric_limits<double>::infinity();
+        result.ssim = 1.0;
+        return result;
+    }
+
+    cv::Mat squared;
+    difference.convertTo(squared, CV_32F);
+    squared = squared.mul(squared);
+    cv::Scalar sums = cv::sum(squared);
+    double mse = (sums[0] + sums[1] + sums[2] + sums[3]) / (double(image.total()) * image.channels());
+    result.psnr = 10.0 * log10(255.0 * 255.0 / mse);
+
+    result.ssim = structuralSimilarity(image, golden);
+
+    return result;
+}
+
+DotSetComparison RegressionHarness::compareDotSets(const QStringList & dots, const QStringList & golden)
+{
+    DotSetComparison result;
+
+    result.goldenFound = !golden.isEmpty();
+    result.dots = dots.size();
+    result.goldenDots = golden.size();
+
+    // Both lists are sorted.
+    int i = 0, j = 0;
+    while(i < dots.size() && j < golden.size())
+    {
+        int order = QString::compare(dots[i], golden[j]);
+        if(order == 0)
+        {
+            ++result.matchingDots;
+            ++i;
+            ++j;
+        }
+        else if(order < 0)
+        {
+            ++i;
+        }
+        else
+        {
+            ++j;
+        }
+    }
+
+    return result;
+}
+
+double RegressionHarness::structuralSimilarity(cv::Mat a, cv::Mat b)
+{
+    cv::Mat grayA = a, grayB = b;
+    if(a.channels() > 1)
+    {
+        cv::cvtColor(a, grayA, CV_BGR2GRAY);
+        cv::cvtColor(b, grayB, CV_BGR2GRAY);
+    }
+
+    const double C1 = (0.01 * 255) * (0.01 * 255);
+    const double C2 = (0.03 * 255) * (0.03 * 255);
+    const int radius = 5; // 11x11 window
+
+    // The stippled renders are large, so the map is computed in bands of rows. Each band
+    // carries a halo of the window radius, so its inner rows get the same values as if the
+    // whole image was filtered at once.
+    const int bandRows = 256;
+    double sum = 0.0;
+
+    for(int first=0; first<grayA.rows; first+=bandRows)
+    {
+        int last = std::min(first + bandRows, grayA.rows);
+        int haloFirst = std::max(first - radius, 0);
+        int haloLast = std::min(last + radius, grayA.rows);
+
+        cv::Mat x, y;
+        grayA.rowRange(haloFirst, haloLast).convertTo(x, CV_32F);
+        grayB.rowRange(haloFirst, haloLast).convertTo(y, CV_32F);
+
+        cv::Mat muX, muY, sigmaXX, sigmaYY, sigmaXY;
+        cv::Size window(2*radius + 1, 2*radius + 1);
+        cv::GaussianBlur(x, muX, window, 1.5);
+        cv::GaussianBlur(y, muY, window, 1.5);
+        cv::GaussianBlur(x.mul(x), sigmaXX, window, 1.5);
+        cv::GaussianBlur(y.mul(y), sigmaYY, window, 1.5);
+        cv::GaussianBlur(x.mul(y), sigmaXY, window, 1.5);
+
+        cv::Mat muXX = muX.mul(muX);
+        cv::Mat muYY = muY.mul(muY);
+        cv::Mat muXY = muX.mul(muY);
+        sigmaXX -= muXX;
+        sigmaYY -= muYY;
+        sigmaXY -= muXY;
+
+        cv::Mat numerator = (2*muXY + C1).mul(2*sigmaXY + C2);
+        cv::Mat denominator = (muXX + muYY + C1).mul(sigmaXX + sigmaYY + C2);
+        cv::Mat map;
+        cv::divide(numerator, denominator, map);
+
+        sum += cv::sum(map.rowRange(first - haloFirst, last - haloFirst))[0];
+    }
+
+    return sum / double(grayA.total());
+}
+
+void RegressionHarness::printImageComparison(QString name, QString output, const ImageComparison & comparison, bool passed, qint64 time) const
+{
+    out << name << "\t" << output << "\t";
+    if(!comparison.goldenFound)
+    {
+        out << "missing golden";
+    }
+    else if(!comparison.sizeMatches)
+    {
+        out << "size mismatch";
+    }
+    else
+    {
+        out << (passed ? "ok" : "FAILED") << "\t" << comparison.differentPixels << "\t" << comparison.maxDifference << "\t"
+            << QString::number(comparison.psnr, 'f', 2) << "\t" << QString::number(comparison.ssim, 'f', 5);
+    }
+    out << "\t" << time << endl;
+}
+
+int RegressionHarness::run(bool updateGoldens)
+{
+    int failed = 0;
+
+    if(!updateGoldens)
+    {
+        out << "case\toutput\tstatus\tdiff\tmax\tPSNR\tSSIM\ttime (ms)" << endl;
+    }
+
+    foreach(const RegressionCase & regressionCase, _cases)
+    {
+        QDir results(QDir(_resultsDirectory).filePath(regressionCase.name));
+        QDir goldens(QDir(_goldensDirectory).filePath(regressionCase.name));
+        QDir().mkpath(results.path());
+
+        BatchJob job = regressionCase.job;
+        job.outputFile = results.filePath("final.png");
+        job.profileFile = results.filePath("profile.json");
+
+        BatchJobState state(job);
+        if(!_stippler->load(&state))
+        {
+            out << regressionCase.name << "\tFAILED (inputs could not be loaded)" << endl;
+            ++failed;
+            continue;
+        }
+
+        _stippler->renderSolids(&state);
+        state.worker->setDebugOutput(false);
+        BatchStippler::generateDots(&state);
+
+        cv::imwrite(results.filePath("dithered.png").toStdString(), state.worker->ditheredImage());
+        if(!saveDotSet(results.filePath("dots.txt"), state.worker->getStipplingDots()))
+        {
+            out << "Error: the dot set of " << regressionCase.name << " could not be written." << endl;
+        }
+
+        // The dots are released once the final image is written.
+        _stippler->saveFinalImage(&state);
+
+        QStringList outputs;
+        outputs << "dithered.png" << "dots.txt" << "final.png";
+
+        if(updateGoldens)
+        {
+            QDir().mkpath(goldens.path());
+            bool updated = true;
+            foreach(const QString & output, outputs)
+            {
+                updated = copyFile(results.filePath(output), goldens.filePath(output)) && updated;
+            }
+            out << regressionCase.name << "\t" << (updated ? "goldens updated" : "FAILED (goldens could not be written)") << endl;
+            if(!updated)
+            {
+                ++failed;
+            }
+            continue;
+        }
+
+        qint64 ditheringTime = state.profiler.stageRecord(StageProfiler::DITHERING).wallTime / 1000000;
+
+        ImageComparison dithered = compareImages(cv::imread(results.filePath("dithered.png").toStdString(), CV_LOAD_IMAGE_UNCHANGED),
+                                                 cv::imread(goldens.filePath("dithered.png").toStdString(), CV_LOAD_IMAGE_UNCHANGED));
+        bool ditheredPassed = dithered.identical();
+        printImageComparison(regressionCase.name, "dithered", dithered, ditheredPassed, ditheringTime);
+
+        QStringList dots, goldenDots;
+        loadDotSet(results.filePath("dots.txt"), dots);
+        loadDotSet(goldens.filePath("dots.txt"), goldenDots);
+        DotSetComparison dotSet = compareDotSets(dots, goldenDots);
+        bool dotsPassed = dotSet.identical();
+        out << regressionCase.name << "\tdots\t";
+        if(!dotSet.goldenFound)
+        {
+            out << "missing golden";
+        }
+        else
+        {
+            out << (dotsPassed ? "ok" : "FAILED") << "\t"
+                << (dotSet.dots - dotSet.matchingDots) + (dotSet.goldenDots - dotSet.matchingDots) << "\t"
+                << dotSet.dots << "/" << dotSet.goldenDots << "\t-\t-";
+        }
+        out << "\t" << state.timings.dotGeneration << endl;
+
+        ImageComparison finalRender = compareImages(cv::imread(results.filePath("final.png").toStdString(), CV_LOAD_IMAGE_COLOR),
+                                                    cv::imread(goldens.filePath("final.png").toStdString(), CV_LOAD_IMAGE_COLOR));
+        bool finalPassed = finalRender.identical() || (finalRender.goldenFound && finalRender.sizeMatches && finalRender.ssim >= _minimumSSIM);
+        printImageComparison(regressionCase.name, "final", finalRender, finalPassed, state.timings.finalImage);
+
+        if(!ditheredPassed || !dotsPassed || !finalPassed)
+        {
+            ++failed;
+        }
+    }
+
+    out << (_cases.size() - failed) << " of " << _cases.size() << " cases passed." << endl;
+
+    return failed;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file regressionharness.h
+ * @brief RegressionHarness class header file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#ifndef REGRESSIONHARNESS_H
+#define REGRESSIONHARNESS_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <opencv2/core/core.hpp>
+
+#include "batchstippler.h"
+
+/**
+ * @brief A regression case: a named job whose outputs are compared against its goldens.
+ */
+struct RegressionCase
+{
+    QString name; /**< Also the name of the directory that holds its goldens and results. */
+    BatchJob job;
+};
+
+/**
+ * @brief Result of comparing an image against its golden.
+ */
+struct ImageComparison
+{
+    bool goldenFound;
+    bool sizeMatches;
+    qint64 differentPixels; /**< Pixels with any channel different. */
+    int maxDifference; /**< Largest difference of a channel (0-255). */
+    double psnr; /**< Peak signal to noise ratio, in dB (infinite if identical). */
+    double ssim; /**< Mean structural similarity of the luminance (1 if identical). */
+
+    ImageComparison();
+
+    bool identical() const;
+};
+
+/**
+ * @brief Result of comparing a dot set against its golden.
+ */
+struct DotSetComparison
+{
+    bool goldenFound;
+    int dots; /**< Dots generated. */
+    int goldenDots; /**< Dots in the golden. */
+    int matchingDots; /**< Dots with the same position and sprite in both sets. */
+
+    DotSetComparison();
+
+    bool identical() const;
+};
+
+/**
+ * @brief RegressionHarness class.
+ * Runs the stippling pipeline on a set of cases and compares the dithered image, the
+ * generated dots and the final render of each one against stored goldens, so the hot
+ * paths can be optimized without silently changing the output. The dithered image and
+ * the dots must be identical. The final render may also pass with a SSIM above a
+ * threshold, as the GL rasterization is allowed to differ slightly between drivers.
+ * The time spent producing each output is reported beside its comparison.
+ */
+class RegressionHarness
+{
+private:
+    BatchStippler * _stippler;
+
+    QString _goldensDirectory; /**< One subdirectory per case: dithered.png, dots.txt and final.png. */
+    QString _resultsDirectory; /**< Same layout, plus the stage profile of the run. */
+
+    double _minimumSSIM; /**< Final renders with a lower SSIM (and not identical) fail. */
+
+    QVector<RegressionCase> _cases;
+
+    /**
+     * @brief Writes the dots of a tree, one "x y sprite" line per dot, sorted so the
+     * file does not depend on the tree layout.
+     * @return False if the file could not be written.
+     */
+    static bool saveDotSet(QString fileName, QuadTree * dots);
+
+    /**
+     * @brief Reads the lines of a dot set file (as written by saveDotSet).
+     * @return False if the file could not be opened.
+     */
+    static bool loadDotSet(QString fileName, QStringList & dots);
+
+    static bool copyFile(QString source, QString destination);
+
+    void printImageComparison(QString name, QString output, const ImageComparison & comparison, bool passed, qint64 time) const;
+
+public:
+    /**
+     * @param stippler Runs the pipeline stages. Not owned.
+     * @param goldensDirectory Directory of the goldens.
+     * @param resultsDirectory Directory the outputs of this run are written to.
+     * @param minimumSSIM Lowest SSIM a final render different from its golden may have.
+     */
+    RegressionHarness(BatchStippler * stippler, QString goldensDirectory, QString resultsDirectory, double minimumSSIM = 0.99);
+
+    void addCase(const RegressionCase & regressionCase);
+
+    /**
+     * @brief Compares two images of the same type.
+     */
+    static ImageComparison compareImages(cv::Mat image, cv::Mat golden);
+
+    /**
+     * @brief Compares two dot sets (sorted lines, as loaded by loadDotSet).
+     */
+    static DotSetComparison compareDotSets(const QStringList & dots, const QStringList & golden);
+
+    /**
+     * @brief Mean SSIM (Wang et al. 2004, 11x11 gaussian window) of the luminance of two images of the same size.
+     */
+    static double structuralSimilarity(cv::Mat a, cv::Mat b);
+
+    /**
+     * @brief Runs every case and compares its outputs against the goldens.
+     * @param updateGoldens If true, the outputs replace the goldens instead.
+     * @return Number of failed cases.
+     */
+    int run(bool updateGoldens);
+};
+
+#endif // REGRESSIONHARNESS_H
@@ -50,6 +50,11 @@ void SpecificEntityConfigurationDialog::setEdgeDetectionMethod()
         hasSpecificEdgeDetectionMethod = true;
         method = CANNY;
     }
+    else if(value == "Silhouette")
+    {
+        hasSpecificEdgeDetectionMethod = true;
+        method = SILHOUETTE;
+    }
 
     _configuration->setHasSpecificEdgeDetectionMethod(hasSpecificEdgeDetectionMethod);
     _configuration->setEdgeDetectionMethod(method);
@@ -83,6 +88,7 @@ SpecificEntityConfigurationDialog::SpecificEntityConfigurationDialog(QWidget *pa
     ui->edgeDetectionMethod->addItem("Same as general configuration", "Same as general configuration");
     ui->edgeDetectionMethod->addItem("Sobel", "Sobel");
     ui->edgeDetectionMethod->addItem("Canny", "Canny");
+    ui->edgeDetectionMethod->addItem("Silhouette", "Silhouette");
 
     connect(ui->percentageSilhouetteDispersion, SIGNAL(valueChanged(int)), this, SLOT(setPercentageSilhouetteDispersion()));
     connect(ui->percentageInternalGeneration, SIGNAL(valueChanged(int)), this, SLOT(setPercentageInternalGeneration()));
@@ -128,6 +134,10 @@ void SpecificEntityConfigurationDialog::loadConfiguration(SpecificEntityConfigur
         {
             index = "Canny";
         }
+        else if(_configuration->edgeDetectionMethod() ==  SILHOUETTE)
+        {
+            index = "Silhouette";
+        }
         ui->edgeDetectionMethod->setCurrentIndex(ui->edgeDetectionMethod->findText(index));
     }
     else
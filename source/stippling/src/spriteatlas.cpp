@@ -0,0 +1,201 @@
+/**
+ * @file spriteatlas.cpp
+ * @brief SpriteAtlas class source file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#include "spriteatlas.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDomDocument>
+
+#include <opencv2/highgui/highgui.hpp>
+
+#include "util.h"
+
+SpriteAtlas::SpriteAtlas()
+{
+    _spriteSize = glm::vec2(0.0f);
+    _matrixSize = glm::vec2(0.0f);
+    _meanCoverage = 0.0f;
+}
+
+QString SpriteAtlas::defaultDescriptorFile()
+{
+    return "./resources/precdots10alpha.xml";
+}
+
+bool SpriteAtlas::load(QString descriptorFile)
+{
+    QFile file(descriptorFile);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        out << "Error: the sprite atlas " << descriptorFile << " could not be opened." << endl;
+        return false;
+    }
+
+    QDomDocument doc;
+    QString errorMessage;
+    int errorLine;
+    if(!doc.setContent(&file, &errorMessage, &errorLine))
+    {
+        out << "Error: the sprite atlas " << descriptorFile << " is not valid XML (line " << errorLine << ": " << errorMessage << ")." << endl;
+        return false;
+    }
+    file.close();
+
+    QDomElement root = doc.documentElement();
+    QDomElement imageElem = root.firstChildElement("image");
+    QDomElement sizeElem = root.firstChildElement("spriteSize");
+    QDomElement gridElem = root.firstChildElement("grid");
+
+    glm::vec2 spriteSize(sizeElem.attribute("width").toFloat(), sizeElem.attribute("height").toFloat());
+    int columns = gridElem.attribute("columns").toInt();
+    int rows = gridElem.attribute("rows").toInt();
+
+    if(root.tagName() != "spriteAtlas" || imageElem.isNull() || spriteSize.x <= 0.0f || spriteSize.y <= 0.0f ||
+       columns <= 0 || rows <= 0)
+    {
+        out << "Error: the sprite atlas " << descriptorFile << " needs an image, a sprite size and a grid." << endl;
+        return false;
+    }
+
+    // The image is relative to the descriptor.
+    QString imageFile = QFileInfo(descriptorFile).dir().filePath(imageElem.text().trimmed());
+    cv::Mat image = cv::imread(imageFile.toStdString(), CV_LOAD_IMAGE_UNCHANGED);
+    if(!image.data || image.type() != CV_8UC4)
+    {
+        out << "Error: the sprite image " << imageFile << " could not be read as a BGRA image." << endl;
+        return false;
+    }
+    if(image.cols != columns * spriteSize.x || image.rows != rows * spriteSize.y)
+    {
+        out << "Error: the sprite image " << imageFile << " is " << image.cols << " x " << image.rows
+            << " pixels, its grid needs " << columns * spriteSize.x << " x " << rows * spriteSize.y << "." << endl;
+        return false;
+    }
+
+    _descriptorFile = descriptorFile;
+    _image = image;
+    _spriteSize = spriteSize;
+    _matrixSize = glm::vec2(columns, rows);
+
+    computeCoverage();
+
+    return true;
+}
+
+void SpriteAtlas::computeCoverage()
+{
+    int sprites = numberOfSprites();
+    _coverage.resize(sprites);
+
+    double total = 0.0;
+    for(int i=0; i<sprites; ++i)
+    {
+        cv::Mat sprite = _image(cell(i));
+
+        // Ink of a pixel: its opacity times its darkness.
+        double ink = 0.0;
+        for(int row=0; row<sprite.rows; ++row)
+        {
+            const cv::Vec4b * pixel = sprite.ptr<cv::Vec4b>(row);
+            for(int column=0; column<sprite.cols; ++column)
+            {
+                double luminance = 0.114 * pixel[column][0] + 0.587 * pixel[column][1] + 0.299 * pixel[column][2];
+                ink += (pixel[column][3] / 255.0) * (1.0 - luminance / 255.0);
+            }
+        }
+
+        _coverage[i] = float(ink / (sprite.rows * sprite.cols));
+        total += _coverage[i];
+    }
+
+    _meanCoverage = sprites > 0 ? float(total / sprites) : 0.0f;
+}
+
+bool SpriteAtlas::isEmpty() const
+{
+    return numberOfSprites() == 0;
+}
+
+QString SpriteAtlas::descriptorFile() const
+{
+    return _descriptorFile;
+}
+
+const cv::Mat & SpriteAtlas::image() const
+{
+    return _image;
+}
+
+glm::vec2 SpriteAtlas::spriteSize() const
+{
+    return _spriteSize;
+}
+
+glm::vec2 SpriteAtlas::matrixSize() const
+{
+    return _matrixSize;
+}
+
+int SpriteAtlas::numberOfSprites() const
+{
+    return int(_matrixSize.x) * int(_matrixSize.y);
+}
+
+cv::Rect SpriteAtlas::cell(int sprite) const
+{
+    if(sprite < 0 || sprite >= numberOfSprites())
+    {
+        return cv::Rect();
+    }
+
+    int columns = int(_matrixSize.x);
+    int cellWidth = _image.cols / columns;
+    int cellHeight = _image.rows / int(_matrixSize.y);
+
+    return cv::Rect((sprite % columns) * cellWidth, (sprite / columns) * cellHeight, cellWidth, cellHeight);
+}
+
+glm::vec4 SpriteAtlas::uvRect(int sprite) const
+{
+    if(sprite < 0 || sprite >= numberOfSprites())
+    {
+        return glm::vec4(0.0f);
+    }
+
+    int columns = int(_matrixSize.x);
+    float unitX = 1.0f / _matrixSize.x;
+    float unitY = 1.0f / _matrixSize.y;
+
+    return glm::vec4((sprite % columns) * unitX, (sprite / columns) * unitY, unitX, unitY);
+}
+
+float SpriteAtlas::coverage(int sprite) const
+{
+    if(sprite < 0 || sprite >= _coverage.size())
+    {
+        return 0.0f;
+    }
+
+    return _coverage.at(sprite);
+}
+
+const QVector<float> & SpriteAtlas::coverages() const
+{
+    return _coverage;
+}
+
+float SpriteAtlas::meanCoverage() const
+{
+    return _meanCoverage;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file spriteatlas.h
+ * @brief SpriteAtlas class header file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#ifndef SPRITEATLAS_H
+#define SPRITEATLAS_H
+
+#include <QString>
+#include <QVector>
+
+#include <opencv2/core/core.hpp>
+
+#include <glm/glm.hpp>
+
+/**
+ * @brief SpriteAtlas class.
+ * Image holding the sprites a stipple dot can be drawn with, laid out as a matrix of equally
+ * sized cells, as described by a small XML file:
+ *
+ *     <spriteAtlas>
+ *         <image>precdots10alpha.png</image>
+ *         <spriteSize width="10" height="10"/>
+ *         <grid columns="29" rows="29"/>
+ *     </spriteAtlas>
+ *
+ * The image (BGRA, relative to the descriptor) is split in columns x rows cells of spriteSize
+ * pixels, so it has to be exactly columns * width x rows * height pixels, and each dot drawn with
+ * a sprite covers spriteSize units of the stippled image. Sprites are numbered row by
+ * row, starting at the top left cell.
+ * The coverage of each sprite (the ink it leaves on a white background, between 0 and 1) is
+ * computed once when the atlas is loaded.
+ */
+class SpriteAtlas
+{
+private:
+    QString _descriptorFile;
+    cv::Mat _image;
+    glm::vec2 _spriteSize;
+    glm::vec2 _matrixSize;
+    QVector<float> _coverage;
+    float _meanCoverage;
+
+    void computeCoverage();
+
+public:
+    /**
+     * @brief Empty atlas, without sprites.
+     */
+    SpriteAtlas();
+
+    /**
+     * @brief Descriptor of the atlas shipped with the application.
+     */
+    static QString defaultDescriptorFile();
+
+    /**
+     * @brief Reads a descriptor and its image. The atlas is left untouched if they can not be read.
+     * @return False (after printing why) if the descriptor or the image are not valid.
+     */
+    bool load(QString descriptorFile);
+
+    bool isEmpty() const;
+
+    QString descriptorFile() const;
+
+    /**
+     * @brief Whole image of the atlas (BGRA).
+     */
+    const cv::Mat & image() const;
+
+    /**
+     * @brief Size of a dot in the stippled image.
+     */
+    glm::vec2 spriteSize() const;
+
+    /**
+     * @brief Columns and rows of the matrix of sprites.
+     */
+    glm::vec2 matrixSize() const;
+
+    int numberOfSprites() const;
+
+    /**
+     * @brief Cell of a sprite in the image, in pixels. Empty if the sprite is not in the atlas.
+     */
+    cv::Rect cell(int sprite) const;
+
+    /**
+     * @brief Cell of a sprite in texture coordinates: left, top, width and height. Empty if the sprite is not in the atlas.
+     */
+    glm::vec4 uvRect(int sprite) const;
+
+    /**
+     * @brief Ink a sprite leaves on a white background, between 0 (none) and 1 (its whole cell in black).
+     * 0 if the sprite is not in the atlas.
+     */
+    float coverage(int sprite) const;
+
+    /**
+     * @brief Coverage of every sprite, indexed by sprite.
+     */
+    const QVector<float> & coverages() const;
+
+    float meanCoverage() const;
+};
+
+#endif // SPRITEATLAS_H
@@ -0,0 +1,225 @@
+/**
+ * @file stageprofiler.cpp
+ * @brief StageProfiler class source file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#include "stageprofiler.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <QMutexLocker>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
+StageProfiler::ScopedStage::ScopedStage(StageProfiler * profiler, Stage stage)
+{
+    _profiler = profiler;
+    _stage = stage;
+    _items = 0;
+    _cpuStart = 0;
+    _residentSetSizeStart = -1;
+
+    if(_profiler != 0)
+    {
+        _residentSetSizeStart = residentSetSize();
+        _cpuStart = processCpuTime();
+        _wallTimer.start();
+    }
+}
+
+StageProfiler::ScopedStage::~ScopedStage()
+{
+    if(_profiler != 0)
+    {
+        qint64 wallTime = _wallTimer.nsecsElapsed();
+        qint64 cpuEnd = processCpuTime();
+        qint64 cpuTime = (cpuEnd >= 0 && _cpuStart >= 0) ? cpuEnd - _cpuStart : -1;
+
+        _profiler->record(_stage, wallTime, cpuTime, _items, _residentSetSizeStart);
+    }
+}
+
+void StageProfiler::ScopedStage::addItems(qint64 items)
+{
+    _items += items;
+}
+
+StageProfiler::StageProfiler(QObject * parent) : QObject(parent)
+{
+    reset();
+}
+
+void StageProfiler::reset()
+{
+    QMutexLocker locker(&_mutex);
+
+    for(int i=0; i<NUMBER_OF_STAGES; ++i)
+    {
+        _records[i].calls = 0;
+        _records[i].wallTime = 0;
+        _records[i].cpuTime = 0;
+        _records[i].residentSetSize = -1;
+        _records[i].items = 0;
+    }
+}
+
+void StageProfiler::record(Stage stage, qint64 wallTime, qint64 cpuTime, qint64 items, qint64 startResidentSetSize)
+{
+    qint64 rss = qMax(startResidentSetSize, residentSetSize());
+
+    {
+        QMutexLocker locker(&_mutex);
+
+        Record & r = _records[stage];
+        ++r.calls;
+        r.wallTime += wallTime;
+        // Once unknown, the accumulated CPU time stays unknown.
+        r.cpuTime = (cpuTime < 0 || r.cpuTime < 0) ? -1 : r.cpuTime + cpuTime;
+        r.residentSetSize = qMax(r.residentSetSize, rss);
+        r.items += items;
+    }
+
+    emit stageRecorded(int(stage), wallTime, cpuTime, rss, items);
+}
+
+StageProfiler::Record StageProfiler::stageRecord(Stage stage) const
+{
+    QMutexLocker locker(&_mutex);
+    return _records[stage];
+}
+
+QString StageProfiler::stageName(Stage stage)
+{
+    switch(stage)
+    {
+    case DITHERING:
+        return "dithering";
+    case EDGE_DETECTION:
+        return "edge_detection";
+    case OWNERSHIP_LOOKUP:
+        return "ownership_lookup";
+    case DOT_CREATION:
+        return "dot_creation";
+    case QUADTREE_INSERTION:
+        return "quadtree_insertion";
+    case DISPERSION:
+        return "dispersion";
+    case TILE_RENDER:
+        return "tile_render";
+    case EXPORT:
+        return "export";
+    default:
+        return "unknown";
+    }
+}
+
+qint64 StageProfiler::processCpuTime()
+{
+#ifdef Q_OS_WIN
+    FILETIME creationTime, exitTime, kernel, user;
+    if(!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernel, &user))
+    {
+        return -1;
+    }
+    // FILETIME counts 100 ns intervals.
+    qint64 kernelTime = (qint64(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+    qint64 userTime = (qint64(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+    return (kernelTime + userTime) * 100;
+#else
+#ifdef CLOCK_PROCESS_CPUTIME_ID
+    struct timespec time;
+    if(clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) == 0)
+    {
+        return qint64(time.tv_sec) * 1000000000 + time.tv_nsec;
+    }
+#endif
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return -1;
+    }
+    qint64 microseconds = qint64(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000
+                        + qint64(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+    return microseconds * 1000;
+#endif
+}
+
+qint64 StageProfiler::residentSetSize()
+{
+#ifdef Q_OS_LINUX
+    // Second field of statm: resident pages.
+    QFile file("/proc/self/statm");
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        return -1;
+    }
+    QList<QByteArray> fields = file.readAll().split(' ');
+    bool ok = false;
+    qint64 pages = fields.size() > 1 ? fields[1].toLongLong(&ok) : 0;
+    if(!ok)
+    {
+        return -1;
+    }
+    return pages * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+QString StageProfiler::toJSON() const
+{
+    QString json;
+    QTextStream stream(&json);
+
+    stream << "{" << endl;
+    stream << "  \"stages\": [" << endl;
+    for(int i=0; i<NUMBER_OF_STAGES; ++i)
+    {
+        Record r = stageRecord(Stage(i));
+
+        stream << "    { \"name\": \"" << stageName(Stage(i)) << "\""
+               << ", \"calls\": " << r.calls
+               << ", \"wall_ms\": " << QString::number(r.wallTime / 1.0e6, 'f', 3)
+               << ", \"process_cpu_ms\": " << (r.cpuTime < 0 ? QString("null") : QString::number(r.cpuTime / 1.0e6, 'f', 3))
+               << ", \"process_rss_bytes\": " << (r.residentSetSize < 0 ? QString("null") : QString::number(r.residentSetSize))
+               << ", \"items\": " << r.items
+               << " }" << (i < NUMBER_OF_STAGES-1 ? "," : "") << endl;
+    }
+    stream << "  ]," << endl;
+
+    // Process wide, as the stage figures.
+    qint64 rss = residentSetSize();
+    stream << "  \"process_rss_bytes\": " << (rss < 0 ? QString("null") : QString::number(rss)) << endl;
+    stream << "}" << endl;
+
+    stream.flush();
+    return json;
+}
+
+bool StageProfiler::saveJSON(QString fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        return false;
+    }
+
+    QTextStream fo(&file);
+    fo << toJSON();
+
+    return true;
+}
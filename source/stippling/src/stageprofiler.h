@@ -0,0 +1,130 @@
+/**
+ * @file stageprofiler.h
+ * @brief StageProfiler class header file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#ifndef STAGEPROFILER_H
+#define STAGEPROFILER_H
+
+#include <QObject>
+#include <QString>
+#include <QMutex>
+#include <QElapsedTimer>
+
+/**
+ * @brief StageProfiler class.
+ * Accumulates wall time, CPU time, resident set size and item counts for each stage of the
+ * stippling pipeline. Stages can be recorded from any thread. Every record is also announced
+ * through the stageRecorded signal, and the totals can be written as a JSON report.
+ * CPU time and resident set size are the ones of the whole process: they include the pool
+ * threads of cv::parallel_for_, and also anything else running meanwhile (as other jobs of a
+ * BatchScheduler).
+ */
+class StageProfiler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Stage { DITHERING, EDGE_DETECTION, OWNERSHIP_LOOKUP, DOT_CREATION, QUADTREE_INSERTION,
+                 DISPERSION, TILE_RENDER, EXPORT, NUMBER_OF_STAGES };
+
+    /**
+     * @brief Accumulated measures of a stage.
+     */
+    struct Record
+    {
+        int calls; /**< Number of times the stage was recorded. */
+        qint64 wallTime; /**< Wall time, in nanoseconds. */
+        qint64 cpuTime; /**< CPU time of the process (all its threads) during the stage, in nanoseconds (-1 if unknown). */
+        qint64 residentSetSize; /**< Largest process RSS sampled when the stage started or ended, in bytes (-1 if unknown). */
+        qint64 items; /**< Items processed (pixels, dots, tiles...). */
+    };
+
+    /**
+     * @brief Measures a stage from construction to destruction.
+     * Does nothing if the profiler is 0, so it can be used unconditionally.
+     */
+    class ScopedStage
+    {
+    private:
+        StageProfiler * _profiler;
+        Stage _stage;
+        qint64 _items;
+        QElapsedTimer _wallTimer;
+        qint64 _cpuStart;
+        qint64 _residentSetSizeStart;
+
+    public:
+        ScopedStage(StageProfiler * profiler, Stage stage);
+        ~ScopedStage();
+
+        void addItems(qint64 items);
+    };
+
+private:
+    mutable QMutex _mutex;
+    Record _records[NUMBER_OF_STAGES];
+
+public:
+    StageProfiler(QObject * parent = 0);
+
+    /**
+     * @brief Clears every record.
+     */
+    void reset();
+
+    /**
+     * @brief Adds a measure to a stage.
+     * @param stage The stage.
+     * @param wallTime Wall time, in nanoseconds.
+     * @param cpuTime Process CPU time, in nanoseconds (negative if unknown).
+     * @param items Items processed.
+     * @param startResidentSetSize Process RSS when the stage started, in bytes (negative if unknown).
+     * The one when it ended is sampled here.
+     */
+    void record(Stage stage, qint64 wallTime, qint64 cpuTime, qint64 items, qint64 startResidentSetSize = -1);
+
+    Record stageRecord(Stage stage) const;
+
+    /**
+     * @brief Name of a stage, as used in the JSON report.
+     */
+    static QString stageName(Stage stage);
+
+    /**
+     * @brief CPU time consumed by all the threads of the process, in nanoseconds, or -1 if unknown.
+     */
+    static qint64 processCpuTime();
+
+    /**
+     * @brief Current resident set size of the process, in bytes, or -1 if unknown (only known on Linux).
+     */
+    static qint64 residentSetSize();
+
+    /**
+     * @brief Returns the records as a JSON document.
+     */
+    QString toJSON() const;
+
+    /**
+     * @brief Writes the JSON report to a file.
+     * @return False if the file could not be written.
+     */
+    bool saveJSON(QString fileName) const;
+
+signals:
+    /**
+     * @brief Emitted (from the recording thread) every time a stage is recorded.
+     * Times are the ones of this record in nanoseconds, not the accumulated ones.
+     */
+    void stageRecorded(int stage, qint64 wallTime, qint64 cpuTime, qint64 residentSetSize, qint64 items);
+};
+
+#endif // STAGEPROFILER_H
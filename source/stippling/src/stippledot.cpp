@@ -52,15 +52,25 @@ int StippleDot::chosenDot() const
     return _chosenDot;
 }
 
+glm::vec2 StippleDot::position() const
+{
+    return _position;
+}
+
 glm::mat4 StippleDot::model() const
 {
     glm::mat4 model = glm::mat4(1.0f);
-    glm::vec2 temp = _position + _offset;
+    glm::vec2 temp = finalPostion();
     glm::vec3 finalPosition = glm::vec3(temp.x, temp.y, 0.0f);
     model = glm::translate(model, finalPosition);
     return model;
 }
 
+glm::vec2 StippleDot::offset() const
+{
+    return _offset;
+}
+
 glm::vec2 StippleDot::finalPostion() const
 {
     glm::vec2 finalPosition = _position;
@@ -71,6 +81,11 @@ glm::vec2 StippleDot::finalPostion() const
     return finalPosition;
 }
 
+bool StippleDot::canHaveOffsetApplied() const
+{
+    return _canHaveOffsetApplied;
+}
+
 void StippleDot::setOffset(glm::vec2 offset)
 {
     _offset = offset;
@@ -53,8 +53,11 @@ public:
     StippleDot(glm::vec2 position, glm::vec2 size, int chosenDot);
 
     int chosenDot() const;
+    glm::vec2 position() const; /**< Position where the dot was generated, without its offset. */
+    glm::vec2 offset() const; /**< Offset of the dispersion, applied only if canHaveOffsetApplied. */
     glm::mat4 model() const;
     glm::vec2 finalPostion() const;
+    bool canHaveOffsetApplied() const;
 
     void setOffset(glm::vec2 offset);
     void setCanHaveOffsetApplied(bool canHaveOffsetApplied);
@@ -0,0 +1,175 @@
+/**
+ * @file svgstippleexporter.cpp
+ * @brief SVGStippleExporter class source file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#include "svgstippleexporter.h"
+
+#include <QFile>
+#include <QBitArray>
+#include <QTextStream>
+
+#include <vector>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "util.h"
+
+/**
+ * @brief Traces a sprite as a path: the outlines (and holes) of its pixels at least half opaque,
+ * smoothed by tracing them on the sprite enlarged SPRITE_TRACING_SCALE times.
+ * @param fill Receives the mean color of those pixels.
+ * @return Path data, in pixels of the sprite. Empty if the sprite has no such pixels.
+ */
+static QString spritePath(const cv::Mat & sprite, cv::Scalar & fill)
+{
+    static const int SPRITE_TRACING_SCALE = 8;
+
+    std::vector<cv::Mat> channels;
+    cv::split(sprite, channels);
+
+    cv::Mat mask;
+    cv::threshold(channels[3], mask, 127, 255, cv::THRESH_BINARY);
+    fill = cv::mean(sprite, mask);
+
+    cv::Mat alpha, enlargedMask;
+    cv::resize(channels[3], alpha, cv::Size(), SPRITE_TRACING_SCALE, SPRITE_TRACING_SCALE, cv::INTER_CUBIC);
+    cv::threshold(alpha, enlargedMask, 127, 255, cv::THRESH_BINARY);
+
+    std::vector<std::vector<cv::Point> > contours;
+    std::vector<cv::Vec4i> hierarchy;
+    cv::findContours(enlargedMask, contours, hierarchy, CV_RETR_CCOMP, CV_CHAIN_APPROX_SIMPLE);
+
+    QString path;
+    QTextStream fo(&path);
+    fo.setRealNumberNotation(QTextStream::FixedNotation);
+    fo.setRealNumberPrecision(2);
+    for(size_t i=0; i<contours.size(); ++i)
+    {
+        std::vector<cv::Point> outline;
+        // Within an eighth of a pixel of the sprite.
+        cv::approxPolyDP(contours[i], outline, SPRITE_TRACING_SCALE / 8.0, true);
+        if(outline.size() < 3)
+        {
+            continue;
+        }
+
+        // Contours go through the centers of the border pixels.
+        for(size_t j=0; j<outline.size(); ++j)
+        {
+            fo << (j == 0 ? "M" : "L") << (outline[j].x + 0.5) / SPRITE_TRACING_SCALE << " "
+               << (outline[j].y + 0.5) / SPRITE_TRACING_SCALE;
+        }
+        fo << "Z";
+    }
+    fo.flush();
+
+    return path;
+}
+
+bool SVGStippleExporter::write(QString fileName, QuadTree * dots, const SpriteAtlas & sprites, glm::vec4 backgroundColor)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        out << "Error: the SVG file " << fileName << " could not be written." << endl;
+        return false;
+    }
+
+    glm::vec4 area = dots->getRootArea();
+    QVector<QVector<StippleDot *> *> leaves = dots->getDotsInFullArea();
+
+    int numberOfSprites = sprites.numberOfSprites();
+    glm::vec2 spriteSize = sprites.spriteSize();
+
+    // Only the sprites some dot uses are embedded. Dots of sprites out of the atlas are skipped.
+    QBitArray usedSprites(numberOfSprites);
+    qint64 skippedDots = 0;
+    foreach(QVector<StippleDot *> * leaf, leaves)
+    {
+        foreach(StippleDot * dot, *leaf)
+        {
+            int sprite = dot->chosenDot();
+            if(sprite >= 0 && sprite < numberOfSprites)
+            {
+                usedSprites.setBit(sprite);
+            }
+            else
+            {
+                ++skippedDots;
+            }
+        }
+    }
+    if(skippedDots != 0)
+    {
+        out << "Error: " << skippedDots << " dots have a sprite out of the atlas, they are not exported." << endl;
+    }
+
+    QTextStream fo(&file);
+    fo.setRealNumberNotation(QTextStream::FixedNotation);
+    fo.setRealNumberPrecision(2);
+
+    fo << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    fo << "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" version=\"1.1\""
+       << " width=\"" << area.z << "\" height=\"" << area.w << "\" viewBox=\"0 0 " << area.z << " " << area.w << "\">\n";
+
+    fo << "<defs>\n";
+    for(int i=0; i<numberOfSprites; ++i)
+    {
+        if(!usedSprites.testBit(i))
+        {
+            continue;
+        }
+
+        cv::Scalar fill;
+        QString path = spritePath(sprites.image()(sprites.cell(i)), fill);
+
+        fo << "<symbol id=\"s" << i << "\" viewBox=\"0 0 " << spriteSize.x << " " << spriteSize.y << "\">";
+        if(!path.isEmpty())
+        {
+            // BGRA
+            fo << "<path fill-rule=\"evenodd\" fill=\"rgb(" << int(fill[2]) << "," << int(fill[1]) << "," << int(fill[0])
+               << ")\" d=\"" << path << "\"/>";
+        }
+        fo << "</symbol>\n";
+    }
+    fo << "</defs>\n";
+
+    fo << "<rect width=\"100%\" height=\"100%\" fill=\"rgb(" << int(backgroundColor.r * 255.0f) << "," << int(backgroundColor.g * 255.0f)
+       << "," << int(backgroundColor.b * 255.0f) << ")\"/>\n";
+
+    // The stippled image has its origin at the bottom left corner, SVG at the top left one.
+    foreach(QVector<StippleDot *> * leaf, leaves)
+    {
+        foreach(StippleDot * dot, *leaf)
+        {
+            if(dot->chosenDot() < 0 || dot->chosenDot() >= numberOfSprites)
+            {
+                continue;
+            }
+
+            glm::vec2 position = dot->finalPostion();
+            fo << "<use xlink:href=\"#s" << dot->chosenDot() << "\" x=\"" << position.x
+               << "\" y=\"" << (area.w - position.y - spriteSize.y) << "\" width=\"" << spriteSize.x
+               << "\" height=\"" << spriteSize.y << "\"/>\n";
+        }
+    }
+
+    fo << "</svg>\n";
+    fo.flush();
+
+    if(file.error() != QFile::NoError)
+    {
+        out << "Error: the SVG file " << fileName << " could not be written." << endl;
+        return false;
+    }
+
+    return true;
+}
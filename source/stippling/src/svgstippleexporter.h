@@ -0,0 +1,50 @@
+/**
+ * @file svgstippleexporter.h
+ * @brief SVGStippleExporter class header file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#ifndef SVGSTIPPLEEXPORTER_H
+#define SVGSTIPPLEEXPORTER_H
+
+#include <QString>
+
+#include <glm/glm.hpp>
+
+#include "quadtree.h"
+#include "spriteatlas.h"
+
+/**
+ * @brief SVGStippleExporter class.
+ * Writes a stippled image as a SVG document, so it can be rasterized at any resolution.
+ * Every sprite of the atlas used by the dots is embedded once, traced as a path in a symbol
+ * (the outline of its pixels at least half opaque, in their mean color: the partial transparency
+ * of the sprite edges is not kept), and every dot is a reference to its sprite. The dots are streamed to the file leaf by leaf of the quadtree,
+ * so the memory needed does not depend on the number of dots, and the file size grows with the
+ * number of dots instead of the area of the image.
+ * Non instantiable class.
+ */
+class SVGStippleExporter
+{
+private:
+    SVGStippleExporter();
+
+public:
+    /**
+     * @brief Writes the dots as a SVG document.
+     * @param fileName SVG file to be written.
+     * @param dots Dots, drawn at their final position (with the offset, if any).
+     * @param sprites Sprites the dots are drawn with.
+     * @param backgroundColor Color of the background (RGBA, between 0 and 1).
+     * @return False (after printing why) if the file could not be written.
+     */
+    static bool write(QString fileName, QuadTree * dots, const SpriteAtlas & sprites, glm::vec4 backgroundColor);
+};
+
+#endif // SVGSTIPPLEEXPORTER_H
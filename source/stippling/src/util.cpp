@@ -31,6 +31,14 @@ int Util::mod(int i, int m)
     return mod;
 }
 
+quint64 Util::splitMix64(quint64 z)
+{
+    z += Q_UINT64_C(0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * Q_UINT64_C(0xbf58476d1ce4e5b9);
+    z = (z ^ (z >> 27)) * Q_UINT64_C(0x94d049bb133111eb);
+    return z ^ (z >> 31);
+}
+
 void Util::printMatrix(glm::mat4 matrix)
 {
     // Printing the matrix row major to better understand it.
@@ -41,6 +41,13 @@ public:
      */
     static int mod(int i, int m);
 
+    /**
+     * @brief SplitMix64 (Steele et al. 2014) output function: hashes a 64 bit value into a well mixed one.
+     * @param z Value to be hashed.
+     * @return The hashed value.
+     */
+    static quint64 splitMix64(quint64 z);
+
     /**
      * @brief Prints a matrix via console.
      * The matrix is transposed before being printed, since OpenGL stores its matrices Column major, but they are better understood when Row major for debugging purposes.
@@ -0,0 +1,273 @@
+/**
+ * @file voronoistippler.cpp
+ * @brief VoronoiStippler class source file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#include "voronoistippler.h"
+
+#include <QHash>
+
+#include <cmath>
+#include <limits>
+
+VoronoiStippler::VoronoiStippler(const cv::Mat & density)
+{
+    _density = density;
+    _cellSize = 1.0f;
+    _gridColumns = 0;
+    _gridRows = 0;
+}
+
+void VoronoiStippler::setSites(const QVector<glm::vec2> & sites)
+{
+    _sites = sites;
+    buildGrid();
+}
+
+const QVector<glm::vec2> & VoronoiStippler::sites() const
+{
+    return _sites;
+}
+
+void VoronoiStippler::buildGrid()
+{
+    _cellStart.clear();
+    _cellSites.clear();
+    if(_sites.isEmpty())
+    {
+        _gridColumns = 0;
+        _gridRows = 0;
+        return;
+    }
+
+    // About one site per bucket.
+    _cellSize = qMax(1.0f, float(std::sqrt(double(_density.rows) * _density.cols / _sites.size())));
+    _gridColumns = qMax(1, int(std::ceil(_density.cols / _cellSize)));
+    _gridRows = qMax(1, int(std::ceil(_density.rows / _cellSize)));
+
+    // Counting sort of the sites by bucket.
+    QVector<int> cellOfSite(_sites.size());
+    _cellStart.fill(0, _gridColumns * _gridRows + 1);
+    for(int i=0; i<_sites.size(); ++i)
+    {
+        int column = qBound(0, int(_sites[i].x / _cellSize), _gridColumns - 1);
+        int row = qBound(0, int(_sites[i].y / _cellSize), _gridRows - 1);
+        cellOfSite[i] = row * _gridColumns + column;
+        ++_cellStart[cellOfSite[i] + 1];
+    }
+    for(int cell=0; cell<_gridColumns * _gridRows; ++cell)
+    {
+        _cellStart[cell + 1] += _cellStart[cell];
+    }
+
+    QVector<int> next = _cellStart;
+    _cellSites.resize(_sites.size());
+    for(int i=0; i<_sites.size(); ++i)
+    {
+        _cellSites[next[cellOfSite[i]]++] = i;
+    }
+}
+
+int VoronoiStippler::nearestSite(const glm::vec2 & point) const
+{
+    if(_sites.isEmpty())
+    {
+        return -1;
+    }
+
+    int centerColumn = qBound(0, int(point.x / _cellSize), _gridColumns - 1);
+    int centerRow = qBound(0, int(point.y / _cellSize), _gridRows - 1);
+    int maxRing = qMax(_gridColumns, _gridRows);
+
+    int nearest = -1;
+    float nearestDistance = std::numeric_limits<float>::max();
+
+    // Rings of buckets around the one of the point. Once ring r is searched, the sites left are
+    // at least r buckets away.
+    for(int ring=0; ring<=maxRing; ++ring)
+    {
+        for(int dy=-ring; dy<=ring; ++dy)
+        {
+            int row = centerRow + dy;
+            if(row < 0 || row >= _gridRows)
+            {
+                continue;
+            }
+
+            // Inner rows of the ring only have its left and right buckets.
+            int step = (dy == -ring || dy == ring) ? 1 : qMax(1, 2*ring);
+            for(int dx=-ring; dx<=ring; dx+=step)
+            {
+                int column = centerColumn + dx;
+                if(column < 0 || column >= _gridColumns)
+                {
+                    continue;
+                }
+
+                int cell = row * _gridColumns + column;
+                for(int j=_cellStart[cell]; j<_cellStart[cell + 1]; ++j)
+                {
+                    glm::vec2 d = _sites[_cellSites[j]] - point;
+                    float distance = d.x * d.x + d.y * d.y;
+                    if(distance < nearestDistance)
+                    {
+                        nearestDistance = distance;
+                        nearest = _cellSites[j];
+                    }
+                }
+            }
+        }
+
+        float reach = ring * _cellSize;
+        if(nearest >= 0 && nearestDistance <= reach * reach)
+        {
+            break;
+        }
+    }
+
+    return nearest;
+}
+
+/**
+ * @brief Rows of the bands the centroids are accumulated over.
+ */
+static const int VORONOI_BAND_ROWS = 64;
+
+/**
+ * @brief Sums of the Voronoi cells a band of rows touches.
+ */
+struct VoronoiBandSums
+{
+    QVector<int> sites; /**< Sites with pixels in the band, in the order they were found. */
+    QVector<double> sums; /**< Mass, x and y of every one of those sites. */
+};
+
+/**
+ * @brief Accumulates the weighted centroids of the Voronoi cells over bands of rows, as a cv::parallel_for_ body.
+ * Every band only keeps sums for the sites it touches (about its share of the sites), added up afterwards.
+ */
+class VoronoiCentroidBody : public cv::ParallelLoopBody
+{
+private:
+    const VoronoiStippler & _stippler;
+    const cv::Mat & _density;
+    int _bandRows;
+    QVector<VoronoiBandSums> & _bands;
+
+public:
+    VoronoiCentroidBody(const VoronoiStippler & stippler, const cv::Mat & density, int bandRows,
+                        QVector<VoronoiBandSums> & bands)
+        : _stippler(stippler), _density(density), _bandRows(bandRows), _bands(bands)
+    {
+    }
+
+    void operator()(const cv::Range & range) const
+    {
+        for(int band=range.start; band<range.end; ++band)
+        {
+            VoronoiBandSums & bandSums = _bands[band];
+            QHash<int, int> slotOfSite;
+            int lastSite = -1;
+            double * sums = 0;
+
+            int lastRow = qMin(_density.rows, (band + 1) * _bandRows);
+            for(int row=band * _bandRows; row<lastRow; ++row)
+            {
+                const float * density = _density.ptr<float>(row);
+                for(int column=0; column<_density.cols; ++column)
+                {
+                    float weight = density[column];
+                    if(weight <= 0.0f)
+                    {
+                        continue;
+                    }
+
+                    glm::vec2 center(column + 0.5f, row + 0.5f);
+                    int site = _stippler.nearestSite(center);
+
+                    // Neighbour pixels mostly share their site, so its slot is only looked up when it changes.
+                    if(site != lastSite)
+                    {
+                        QHash<int, int>::const_iterator found = slotOfSite.constFind(site);
+                        int slot;
+                        if(found != slotOfSite.constEnd())
+                        {
+                            slot = found.value();
+                        }
+                        else
+                        {
+                            slot = bandSums.sites.size();
+                            slotOfSite.insert(site, slot);
+                            bandSums.sites.append(site);
+                            bandSums.sums.append(0.0);
+                            bandSums.sums.append(0.0);
+                            bandSums.sums.append(0.0);
+                        }
+                        sums = bandSums.sums.data() + 3*slot;
+                        lastSite = site;
+                    }
+
+                    sums[0] += weight;
+                    sums[1] += weight * center.x;
+                    sums[2] += weight * center.y;
+                }
+            }
+        }
+    }
+};
+
+float VoronoiStippler::relax()
+{
+    if(_sites.isEmpty())
+    {
+        return 0.0f;
+    }
+
+    // Bands of a fixed height, so the sums are grouped (and rounded) the same whatever the number of CPUs.
+    int bandRows = VORONOI_BAND_ROWS;
+    int bands = (_density.rows + bandRows - 1) / bandRows;
+
+    QVector<VoronoiBandSums> bandSums(bands);
+    cv::parallel_for_(cv::Range(0, bands), VoronoiCentroidBody(*this, _density, bandRows, bandSums));
+
+    // Bands in order, so the sums do not depend on the scheduling.
+    QVector<double> sums(3 * _sites.size(), 0.0);
+    for(int band=0; band<bands; ++band)
+    {
+        const VoronoiBandSums & touched = bandSums[band];
+        for(int slot=0; slot<touched.sites.size(); ++slot)
+        {
+            int site = touched.sites[slot];
+            sums[3*site] += touched.sums[3*slot];
+            sums[3*site + 1] += touched.sums[3*slot + 1];
+            sums[3*site + 2] += touched.sums[3*slot + 2];
+        }
+    }
+
+    double displacement = 0.0;
+    for(int i=0; i<_sites.size(); ++i)
+    {
+        double mass = sums[3*i];
+        double x = sums[3*i + 1];
+        double y = sums[3*i + 2];
+        if(mass <= 0.0)
+        {
+            continue;
+        }
+
+        glm::vec2 centroid(float(x / mass), float(y / mass));
+        displacement += glm::length(centroid - _sites[i]);
+        _sites[i] = centroid;
+    }
+
+    buildGrid();
+
+    return float(displacement / _sites.size());
+}
@@ -0,0 +1,72 @@
+/**
+ * @file voronoistippler.h
+ * @brief VoronoiStippler class header file
+ *
+ * @version 0.1
+ * @author José Ignacio Carmona Villegas <joseicv@correo.ugr.es>
+ * @date 19/October/2026
+ *
+ * @thanks Germán Arroyo Moreno <arroyo@ugr.es>
+ *
+ */
+
+#ifndef VORONOISTIPPLER_H
+#define VORONOISTIPPLER_H
+
+#include <QVector>
+
+#include <opencv2/core/core.hpp>
+
+#include <glm/glm.hpp>
+
+/**
+ * @brief VoronoiStippler class.
+ * Weighted centroidal Voronoi tessellation of a density image (Lloyd relaxation): every iteration
+ * assigns each pixel to its nearest site and moves every site to the centroid of its pixels,
+ * weighted by their density. The sites end up evenly spread, closer together where the density is
+ * higher, without the lattice of a grid.
+ * The nearest site of a pixel is searched on a uniform grid of buckets of sites, so an iteration
+ * costs about the same per pixel whatever the number of sites, and the rows of the image are
+ * processed in parallel, in bands of a fixed height added up in order, so the sites are the same
+ * on every machine. Pixels without density are skipped.
+ * Coordinates are in pixels of the density image, (0, 0) being the top left corner of the first pixel.
+ */
+class VoronoiStippler
+{
+private:
+    cv::Mat _density;
+    QVector<glm::vec2> _sites;
+
+    float _cellSize; /**< Side of a bucket, in pixels. */
+    int _gridColumns;
+    int _gridRows;
+    QVector<int> _cellStart; /**< First entry of every bucket in _cellSites (one more entry than buckets). */
+    QVector<int> _cellSites; /**< Sites, bucket by bucket. */
+
+    void buildGrid();
+
+public:
+    /**
+     * @param density Density of every pixel (CV_32FC1, not negative). Shared, not copied.
+     */
+    VoronoiStippler(const cv::Mat & density);
+
+    void setSites(const QVector<glm::vec2> & sites);
+
+    const QVector<glm::vec2> & sites() const;
+
+    /**
+     * @brief Nearest site of a point.
+     * @return Index of the site, -1 if there are no sites.
+     */
+    int nearestSite(const glm::vec2 & point) const;
+
+    /**
+     * @brief Lloyd iteration: moves every site to the weighted centroid of its Voronoi cell.
+     * Sites whose cell has no density stay where they are.
+     * @return Mean distance the sites moved, in pixels.
+     */
+    float relax();
+};
+
+#endif // VORONOISTIPPLER_H